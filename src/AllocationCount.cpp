@@ -0,0 +1,66 @@
+#include "AllocationCount.h"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions with malloc-backed ones that
+// count calls per thread. A thread-local counter costs one increment per
+// allocation and no shared cache line. The array and nothrow forms call
+// these by default.
+
+namespace
+{
+thread_local std::uint64_t allocations = 0;
+
+void *allocate(std::size_t size)
+{
+    ++allocations;
+    if (void *block = std::malloc(size ? size : 1))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+}
+
+std::uint64_t threadAllocations()
+{
+    return allocations;
+}
+
+void *operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++allocations;
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a whole number of alignments, and at least one
+    const std::size_t rounded = size ? (size + align - 1) / align * align : align;
+    if (void *block = std::aligned_alloc(align, rounded))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, std::align_val_t) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, std::size_t, std::align_val_t) noexcept
+{
+    std::free(block);
+}
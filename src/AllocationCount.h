@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made by the calling thread so far. Counted by the global
+// operator new of any program that links AllocationCount.cpp; elsewhere the
+// function is not defined.
+std::uint64_t threadAllocations();
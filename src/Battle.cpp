@@ -0,0 +1,205 @@
+#include "Battle.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cctype>
+
+const char *turnOrderName(TurnOrder order)
+{
+    switch (order)
+    {
+    case TurnOrder::Seats:
+        return "Seats";
+    case TurnOrder::Shuffled:
+        return "Shuffled";
+    case TurnOrder::Reshuffled:
+        return "Reshuffled";
+    }
+    return "Unknown";
+}
+
+bool parseTurnOrder(const std::string &name, TurnOrder &order)
+{
+    std::string lower;
+    for (char ch : name)
+    {
+        lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+    }
+
+    for (TurnOrder candidate : {TurnOrder::Seats, TurnOrder::Shuffled, TurnOrder::Reshuffled})
+    {
+        std::string candidateName = turnOrderName(candidate);
+        candidateName[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(candidateName[0])));
+        if (lower == candidateName)
+        {
+            order = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Battle Implementation
+// ============================================================================
+
+bool Battle::start(const std::vector<FleetLayout> &layouts, TurnOrder turnOrder, std::uint64_t seed)
+{
+    const auto count = static_cast<int>(layouts.size());
+    if (count < MIN_PLAYERS || count > MAX_PLAYERS)
+    {
+        return false;
+    }
+
+    fleets.assign(layouts.size(), Fleet());
+    for (std::size_t player = 0; player < layouts.size(); ++player)
+    {
+        if (!buildFleet(layouts[player], fleets[player]))
+        {
+            return false;
+        }
+    }
+    cellsAfloat.assign(layouts.size(), static_cast<std::uint8_t>(fleets[0].occupied.count()));
+    openHits.assign(layouts.size(), 0);
+
+    survivors = count == MAX_PLAYERS ? ~std::uint64_t{0} : (std::uint64_t{1} << count) - 1;
+    eliminations.clear();
+    order = turnOrder;
+    rng.seed(seed);
+    turns.clear();
+    for (int player = 0; player < count; ++player)
+    {
+        turns.push_back(player);
+    }
+    if (order != TurnOrder::Seats)
+    {
+        std::shuffle(turns.begin(), turns.end(), rng);
+    }
+    position = 0;
+    round = 1;
+    winner = -1;
+    if (countMetrics)
+    {
+        Metrics::add(Counter::GamesStarted);
+    }
+    return true;
+}
+
+Battle::ShotOutcome Battle::fire(int shooter, int target, int cell)
+{
+    ShotOutcome outcome;
+    if (isOver() || shooter != turns[position] || target < 0 || target >= getPlayerCount() || target == shooter ||
+        isEliminated(target) || cell < 0 || cell >= Board::SIZE * Board::SIZE)
+    {
+        return outcome;
+    }
+
+    Fleet &fleet = fleets[static_cast<std::size_t>(target)];
+    TargetView &view = fleet.view;
+    if (view.attacked.test(cell))
+    {
+        outcome.result = Board::AttackResult::AlreadyTried;
+        return outcome;
+    }
+    view.attacked.set(cell);
+
+    if (!fleet.occupied.test(cell))
+    {
+        outcome.result = Board::AttackResult::Miss;
+        if (countMetrics)
+        {
+            Metrics::add(Counter::Misses);
+        }
+        nextTurn();
+        return outcome;
+    }
+
+    view.hits.set(cell);
+    --cellsAfloat[static_cast<std::size_t>(target)];
+    ++openHits[static_cast<std::size_t>(target)];
+    outcome.result = Board::AttackResult::Hit;
+    const int sunkShip = fleet.recordHit(cell, view.hits);
+    if (sunkShip >= 0)
+    {
+        const auto ship = static_cast<std::size_t>(sunkShip);
+        outcome.result = Board::AttackResult::Sunk;
+        outcome.sunkShip = sunkShip;
+        view.markSunk(fleet.layout[ship], STANDARD_SHIP_SIZES[ship]);
+        openHits[static_cast<std::size_t>(target)] =
+            static_cast<std::uint8_t>(openHits[static_cast<std::size_t>(target)] - STANDARD_SHIP_SIZES[ship]);
+    }
+    if (countMetrics)
+    {
+        Metrics::add(outcome.result == Board::AttackResult::Sunk ? Counter::Sinks : Counter::Hits);
+    }
+
+    if (fleet.allSunk())
+    {
+        outcome.eliminated = true;
+        eliminate(target);
+        if (getSurvivorCount() == 1)
+        {
+            winner = shooter;
+            outcome.gameOver = true;
+            if (countMetrics)
+            {
+                Metrics::add(Counter::GamesFinished);
+            }
+            return outcome;
+        }
+    }
+    nextTurn();
+    return outcome;
+}
+
+void Battle::eliminate(int player)
+{
+    survivors &= ~(std::uint64_t{1} << player);
+    eliminations.push_back(player);
+    // Out of this round's order; the shooter keeps its place
+    const auto found = std::find(turns.begin(), turns.end(), player);
+    const auto index = static_cast<std::size_t>(found - turns.begin());
+    turns.erase(found);
+    if (index < position)
+    {
+        --position;
+    }
+}
+
+void Battle::nextTurn()
+{
+    if (++position < turns.size())
+    {
+        return;
+    }
+    position = 0;
+    ++round;
+    if (order == TurnOrder::Reshuffled)
+    {
+        std::shuffle(turns.begin(), turns.end(), rng);
+    }
+}
+
+int chooseBattleTarget(const Battle &battle, int shooter)
+{
+    const int players = battle.getPlayerCount();
+    int best = -1;
+    int bestOpenHits = -1;
+    int bestAfloat = 0;
+    for (int step = 1; step < players; ++step)
+    {
+        const int target = (shooter + step) % players;
+        if (battle.isEliminated(target))
+        {
+            continue;
+        }
+        const int openHits = battle.getOpenHits(target);
+        const int afloat = battle.getCellsAfloat(target);
+        if (openHits > bestOpenHits || (openHits == bestOpenHits && afloat < bestAfloat))
+        {
+            best = target;
+            bestOpenHits = openHits;
+            bestAfloat = afloat;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ComputerAI.h"
+#include "GameLogic.h"
+#include "Random.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How a Battle orders the survivors' turns within each round
+enum class TurnOrder
+{
+    // Seat order
+    Seats,
+    // One random order, drawn when the battle starts
+    Shuffled,
+    // A fresh random order every round
+    Reshuffled
+};
+
+const char *turnOrderName(TurnOrder order);
+// Case-insensitive inverse of turnOrderName()
+bool parseTurnOrder(const std::string &name, TurnOrder &order);
+
+// Rules of a free-for-all on a shared ocean: MIN_PLAYERS to MAX_PLAYERS
+// fleets, each player in turn fires one shot at any opponent still afloat.
+// A player whose last ship sinks is eliminated; the last one afloat wins.
+//
+// As in Match, fleets are cell masks. Every shot is public, so each fleet
+// has a single fog view (TargetView) that all its opponents share, updated
+// in place shot by shot: N fleets keep N views rather than one per pair.
+// The survivors are a 64-bit mask, so whether a player is eliminated and
+// how many remain are a bit test and a popcount.
+class Battle
+{
+public:
+    static constexpr int MIN_PLAYERS = 3;
+    static constexpr int MAX_PLAYERS = 64;
+
+    struct ShotOutcome
+    {
+        Board::AttackResult result = Board::AttackResult::Invalid;
+        // Index into the standard fleet when result is Sunk, otherwise -1
+        int sunkShip = -1;
+        // The shot sank the target's last ship
+        bool eliminated = false;
+        bool gameOver = false;
+    };
+
+    // Seats one player per layout. False when the count is out of range or
+    // a layout is invalid; the shuffled orders draw from seed.
+    bool start(const std::vector<FleetLayout> &layouts, TurnOrder order, std::uint64_t seed);
+
+    // Whether games and shots go to Metrics; off for a replay of shots
+    // that were counted already
+    void setCountMetrics(bool enabled) { countMetrics = enabled; }
+
+    int getPlayerCount() const { return static_cast<int>(fleets.size()); }
+    // The player to move, or -1 once the battle is over
+    int getTurn() const { return isOver() ? -1 : turns[position]; }
+    // Rounds begun so far, counting from 1
+    int getRound() const { return round; }
+    int getWinner() const { return winner; }
+    bool isOver() const { return winner >= 0; }
+    bool isEliminated(int player) const { return ((survivors >> player) & 1) == 0; }
+    int getSurvivorCount() const { return __builtin_popcountll(survivors); }
+    std::uint64_t getSurvivors() const { return survivors; }
+    // Players in the order they were eliminated
+    const std::vector<int> &getEliminations() const { return eliminations; }
+    const FleetLayout &getLayout(int player) const { return fleets[static_cast<std::size_t>(player)].layout; }
+    // What every opponent knows of the player's waters
+    const TargetView &view(int player) const { return fleets[static_cast<std::size_t>(player)].view; }
+    // Ship cells of the player not yet hit, and hits on its ships still
+    // afloat
+    int getCellsAfloat(int player) const { return cellsAfloat[static_cast<std::size_t>(player)]; }
+    int getOpenHits(int player) const { return openHits[static_cast<std::size_t>(player)]; }
+
+    // result is Invalid, and nothing changes, when it is not the shooter's
+    // turn, the target is the shooter or already eliminated, or the cell is
+    // off the board; AlreadyTried when the cell was fired at before
+    ShotOutcome fire(int shooter, int target, int cell);
+
+private:
+    struct Fleet : FleetMasks
+    {
+        TargetView view;
+    };
+
+    std::vector<Fleet> fleets;
+    // Kept apart from the fleets, so choosing a target reads two small
+    // arrays rather than every fleet's masks
+    std::vector<std::uint8_t> cellsAfloat;
+    std::vector<std::uint8_t> openHits;
+    std::uint64_t survivors = 0;
+    std::vector<int> eliminations;
+    // This round's order of the survivors, and whose turn it is in it
+    std::vector<int> turns;
+    std::size_t position = 0;
+    int round = 0;
+    int winner = -1;
+    TurnOrder order = TurnOrder::Seats;
+    Xoshiro256 rng;
+    bool countMetrics = true;
+
+    void eliminate(int player);
+    void nextTurn();
+};
+
+// The opponent a computer player fires at: the one with the most hits on
+// ships still afloat, whose wounded ships are the cheapest to finish, then
+// the one with the fewest ship cells left. Ties go to the next seat after
+// the shooter, so no seat is everyone's default.
+int chooseBattleTarget(const Battle &battle, int shooter);
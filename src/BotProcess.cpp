@@ -0,0 +1,207 @@
+#include "BotProcess.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr std::size_t READ_CHUNK = 4096;
+// Grace period for a bot to exit after quit before it is killed
+constexpr auto EXIT_GRACE = std::chrono::milliseconds(200);
+}
+
+// ============================================================================
+// BotProcess Implementation
+// ============================================================================
+
+BotProcess::~BotProcess()
+{
+    stop();
+}
+
+bool BotProcess::start(const std::string &command)
+{
+    stop();
+
+    // Close-on-exec keeps one bot's pipes out of every other bot, so each
+    // sees end-of-file as soon as its own driver goes away
+    int input[2];
+    int output[2];
+    if (pipe2(input, O_CLOEXEC) != 0)
+    {
+        std::cerr << "pipe: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (pipe2(output, O_CLOEXEC) != 0)
+    {
+        std::cerr << "pipe: " << std::strerror(errno) << std::endl;
+        close(input[0]);
+        close(input[1]);
+        return false;
+    }
+
+    pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "fork: " << std::strerror(errno) << std::endl;
+        for (int fd : {input[0], input[1], output[0], output[1]})
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+
+    close(input[0]);
+    close(output[1]);
+    toBot = input[1];
+    fromBot = output[0];
+    fcntl(fromBot, F_SETFL, fcntl(fromBot, F_GETFL) | O_NONBLOCK);
+    outgoing.clear();
+    incoming.clear();
+    return true;
+}
+
+void BotProcess::stop()
+{
+    if (pid <= 0)
+    {
+        closePipes();
+        return;
+    }
+
+    send("quit");
+    flush();
+    closePipes();
+
+    const auto deadline = std::chrono::steady_clock::now() + EXIT_GRACE;
+    int status = 0;
+    while (waitpid(pid, &status, WNOHANG) == 0)
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pid = -1;
+}
+
+void BotProcess::closePipes()
+{
+    for (int *fd : {&toBot, &fromBot})
+    {
+        if (*fd >= 0)
+        {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void BotProcess::send(const std::string &line)
+{
+    outgoing += line;
+    outgoing += '\n';
+    ++messages;
+}
+
+bool BotProcess::request(const std::string &line, std::string &reply, std::chrono::milliseconds timeout)
+{
+    send(line);
+    if (!flush() || !readLine(reply, timeout))
+    {
+        return false;
+    }
+    ++messages;
+    return true;
+}
+
+bool BotProcess::flush()
+{
+    std::size_t offset = 0;
+    while (offset < outgoing.size())
+    {
+        if (toBot < 0)
+        {
+            return false;
+        }
+        ssize_t written = write(toBot, outgoing.data() + offset, outgoing.size() - offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // EPIPE: the bot has exited
+            outgoing.clear();
+            return false;
+        }
+        offset += static_cast<std::size_t>(written);
+    }
+    outgoing.clear();
+    return true;
+}
+
+bool BotProcess::readLine(std::string &line, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::size_t scanned = 0;
+    while (true)
+    {
+        const std::size_t newline = incoming.find('\n', scanned);
+        if (newline != std::string::npos)
+        {
+            std::size_t end = newline;
+            if (end > 0 && incoming[end - 1] == '\r')
+            {
+                --end;
+            }
+            line.assign(incoming, 0, end);
+            incoming.erase(0, newline + 1);
+            return true;
+        }
+        scanned = incoming.size();
+
+        if (fromBot < 0)
+        {
+            return false;
+        }
+
+        // The answer to a fresh request is never there yet, so wait first
+        const auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        pollfd ready{fromBot, POLLIN, 0};
+        if (remaining.count() <= 0 || poll(&ready, 1, static_cast<int>(remaining.count())) == 0)
+        {
+            return false;
+        }
+
+        char buffer[READ_CHUNK];
+        ssize_t count = read(fromBot, buffer, sizeof(buffer));
+        if (count > 0)
+        {
+            incoming.append(buffer, static_cast<std::size_t>(count));
+        }
+        else if (count == 0 || (errno != EAGAIN && errno != EINTR))
+        {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+// A bot engine running as a child process, spoken to over a pair of pipes
+// with the line protocol in BotProtocol.h. Lines that expect no answer are
+// queued and written together with the next request, so a whole move costs
+// one write() and usually one read().
+//
+// POSIX only. Writing to a bot that has exited raises SIGPIPE, which the
+// driver should ignore.
+class BotProcess
+{
+public:
+    BotProcess() = default;
+    ~BotProcess();
+
+    BotProcess(const BotProcess &) = delete;
+    BotProcess &operator=(const BotProcess &) = delete;
+
+    // Runs command through /bin/sh; false (with a message on stderr) on failure
+    bool start(const std::string &command);
+    // Sends quit and reaps the child, killing it if it does not exit
+    void stop();
+    bool isRunning() const { return pid > 0; }
+
+    // Queues one line without waiting for an answer
+    void send(const std::string &line);
+    // Sends line (after anything queued) and waits for the answer. False if
+    // the bot exits or does not answer in time.
+    bool request(const std::string &line, std::string &reply, std::chrono::milliseconds timeout);
+
+    // Lines sent and received, across restarts
+    std::uint64_t getMessageCount() const { return messages; }
+
+private:
+    pid_t pid = -1;
+    int toBot = -1;
+    int fromBot = -1;
+    std::string outgoing;
+    std::string incoming;
+    std::uint64_t messages = 0;
+
+    bool flush();
+    bool readLine(std::string &line, std::chrono::milliseconds timeout);
+    void closePipes();
+};
@@ -0,0 +1,216 @@
+#include "BotProtocol.h"
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+const char *const SHIP_TOKENS[FLEET_SIZE] = {"carrier", "battleship", "cruiser", "submarine", "destroyer"};
+}
+
+std::string formatCell(const Coordinate &cell)
+{
+    std::string text(1, static_cast<char>('A' + cell.first));
+    text += std::to_string(cell.second + 1);
+    return text;
+}
+
+bool parseCell(const std::string &text, Coordinate &cell)
+{
+    if (text.size() < 2 || text.size() > 3)
+    {
+        return false;
+    }
+
+    const char row = static_cast<char>(text[0] & ~0x20);
+    if (row < 'A' || row >= 'A' + Board::SIZE)
+    {
+        return false;
+    }
+
+    int column = 0;
+    for (std::size_t i = 1; i < text.size(); ++i)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return false;
+        }
+        column = column * 10 + (text[i] - '0');
+    }
+    if (column < 1 || column > Board::SIZE)
+    {
+        return false;
+    }
+
+    cell = Coordinate{row - 'A', column - 1};
+    return true;
+}
+
+std::string formatPlacement(std::uint8_t code)
+{
+    const int start = code & 0x7F;
+    return formatCell(Coordinate{start / Board::SIZE, start % Board::SIZE}) + ((code & 0x80) ? 'H' : 'V');
+}
+
+bool parsePlacement(const std::string &text, std::uint8_t &code)
+{
+    if (text.size() < 3)
+    {
+        return false;
+    }
+
+    const char orientation = static_cast<char>(text.back() & ~0x20);
+    Coordinate start;
+    if ((orientation != 'H' && orientation != 'V') || !parseCell(text.substr(0, text.size() - 1), start))
+    {
+        return false;
+    }
+
+    code = static_cast<std::uint8_t>(start.first * Board::SIZE + start.second);
+    if (orientation == 'H')
+    {
+        code |= 0x80;
+    }
+    return true;
+}
+
+std::string formatLayout(const FleetLayout &layout)
+{
+    std::string text;
+    for (std::size_t i = 0; i < layout.size(); ++i)
+    {
+        if (i > 0)
+        {
+            text += ' ';
+        }
+        text += formatPlacement(layout[i]);
+    }
+    return text;
+}
+
+bool parseLayout(const std::string &text, FleetLayout &layout)
+{
+    std::istringstream tokens(text);
+    std::string token;
+    for (auto &code : layout)
+    {
+        if (!(tokens >> token) || !parsePlacement(token, code))
+        {
+            return false;
+        }
+    }
+    return !(tokens >> token);
+}
+
+const char *shipToken(std::size_t index)
+{
+    return index < FLEET_SIZE ? SHIP_TOKENS[index] : "unknown";
+}
+
+void splitCommand(const std::string &line, std::string &command, std::string &args)
+{
+    const std::size_t space = line.find(' ');
+    if (space == std::string::npos)
+    {
+        command = line;
+        args.clear();
+        return;
+    }
+    command.assign(line, 0, space);
+    args.assign(line, space + 1, std::string::npos);
+}
+
+// ============================================================================
+// BotEngine Implementation
+// ============================================================================
+
+BotEngine::BotEngine(Difficulty difficulty, const OpeningBook *book)
+    : ai(difficulty)
+{
+    ai.setOpeningBook(book);
+    newGame(0);
+}
+
+void BotEngine::newGame(std::uint64_t seed)
+{
+    ai.reset(RandomService::deriveSeed(seed, RandomStream::AI));
+    placementRng.seed(RandomService::deriveSeed(seed, RandomStream::Placement));
+    view = TargetView();
+    lastShot = {-1, -1};
+}
+
+bool BotEngine::handle(const std::string &line, std::string &reply)
+{
+    std::string command;
+    std::string args;
+    splitCommand(line, command, args);
+    reply.clear();
+
+    if (command == "fire")
+    {
+        lastShot = ai.chooseMove(view).target;
+        reply = "fire " + formatCell(lastShot);
+    }
+    else if (command == "result")
+    {
+        recordResult(args);
+    }
+    else if (command == "place")
+    {
+        reply = "place " + formatLayout(randomFleetLayout(placementRng));
+    }
+    else if (command == "newgame")
+    {
+        newGame(std::strtoull(args.c_str(), nullptr, 10));
+    }
+    else if (command == "hello")
+    {
+        reply = std::string("hello Fleet Commander ") + difficultyName(ai.getDifficulty());
+    }
+    else if (command == "quit")
+    {
+        return false;
+    }
+    return true;
+}
+
+void BotEngine::recordResult(const std::string &args)
+{
+    if (lastShot.first < 0)
+    {
+        return;
+    }
+
+    std::string outcome;
+    std::string detail;
+    splitCommand(args, outcome, detail);
+
+    Board::AttackResult result = Board::AttackResult::Miss;
+    if (outcome == "hit")
+    {
+        result = Board::AttackResult::Hit;
+    }
+    else if (outcome == "sunk")
+    {
+        result = Board::AttackResult::Sunk;
+    }
+    view.markShot(lastShot, result != Board::AttackResult::Miss);
+
+    if (result == Board::AttackResult::Sunk)
+    {
+        std::string ship;
+        std::string placement;
+        splitCommand(detail, ship, placement);
+        std::uint8_t code = 0;
+        for (std::size_t i = 0; i < FLEET_SIZE; ++i)
+        {
+            if (ship == SHIP_TOKENS[i] && parsePlacement(placement, code))
+            {
+                view.markSunk(code, STANDARD_SHIP_SIZES[i]);
+                break;
+            }
+        }
+    }
+
+    ai.recordResult(lastShot, result, view);
+    lastShot = {-1, -1};
+}
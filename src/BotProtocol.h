@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ComputerAI.h"
+#include "GameLogic.h"
+#include <cstdint>
+#include <string>
+
+// Line protocol between a game driver and an external bot engine, in the
+// spirit of UCI for chess engines. The bot reads commands on stdin and
+// answers on stdout, one line each; only the commands marked below expect
+// an answer, so a driver can queue everything else and send it together
+// with the next question.
+//
+// Driver to bot:
+//   hello                          answer: hello <name>
+//   newgame <seed>                 forget the previous game
+//   place                          answer: place <placement> x5
+//   fire                           answer: fire <cell>
+//   result miss|hit                outcome of the bot's last shot
+//   result sunk <ship> <placement> the shot sank a ship
+//   incoming <cell>                the opponent fired at the bot's fleet
+//   gameover win|loss
+//   quit
+//
+// Cells are a row letter and column number, A1 to J10. A placement is the
+// ship's first cell followed by H or V, e.g. C3H; the five placements of
+// "place" are in createStandardFleet order. Ships are named carrier,
+// battleship, cruiser, submarine and destroyer. Unknown commands are
+// ignored, so the protocol can grow without breaking older bots.
+
+std::string formatCell(const Coordinate &cell);
+bool parseCell(const std::string &text, Coordinate &cell);
+
+// Placements use FleetLayout codes
+std::string formatPlacement(std::uint8_t code);
+bool parsePlacement(const std::string &text, std::uint8_t &code);
+std::string formatLayout(const FleetLayout &layout);
+bool parseLayout(const std::string &text, FleetLayout &layout);
+
+// Protocol name of the ship at the given index of the standard fleet
+const char *shipToken(std::size_t index);
+
+// Splits a line into its command word and the rest
+void splitCommand(const std::string &line, std::string &command, std::string &args);
+
+// Built-in bot: answers protocol commands with a ComputerAI. It only sees
+// what the protocol tells it, tracking the opponent's waters in a
+// TargetView rather than a Board.
+class BotEngine
+{
+public:
+    explicit BotEngine(Difficulty difficulty, const OpeningBook *book = nullptr);
+
+    // Handles one command line, leaving the answer (if any) in reply.
+    // Returns false on quit.
+    bool handle(const std::string &line, std::string &reply);
+
+private:
+    ComputerAI ai;
+    TargetView view;
+    Xoshiro256 placementRng;
+    Coordinate lastShot{-1, -1};
+
+    void newGame(std::uint64_t seed);
+    void recordResult(const std::string &args);
+};
@@ -0,0 +1,477 @@
+#include "ComputerAI.h"
+#include "OpeningBook.h"
+#include <cctype>
+
+const char *difficultyName(Difficulty difficulty)
+{
+    switch (difficulty)
+    {
+    case Difficulty::Easy:
+        return "Easy";
+    case Difficulty::Medium:
+        return "Medium";
+    case Difficulty::Hard:
+        return "Hard";
+    }
+    return "Unknown";
+}
+
+bool parseDifficulty(const std::string &name, Difficulty &difficulty)
+{
+    std::string lower;
+    for (char ch : name)
+    {
+        lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+    }
+
+    for (Difficulty candidate : {Difficulty::Easy, Difficulty::Medium, Difficulty::Hard})
+    {
+        std::string candidateName = difficultyName(candidate);
+        candidateName[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(candidateName[0])));
+        if (lower == candidateName)
+        {
+            difficulty = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+SearchLimits defaultSearchLimits(Difficulty difficulty)
+{
+    switch (difficulty)
+    {
+    case Difficulty::Hard:
+        // The cap takes well under a millisecond, so it decides the move and
+        // a seed reproduces the game. The deadline only guards against a
+        // machine too loaded to reach it.
+        return SearchLimits{std::chrono::milliseconds(100), 5000};
+    default:
+        return SearchLimits{};
+    }
+}
+
+ShotDensity huntDensity(const CellMask &blocked, const std::vector<int> &shipSizes)
+{
+    ShotDensity density{};
+    for (int size : shipSizes)
+    {
+        for (const auto &placement : shipPlacements(size))
+        {
+            if (placement.mask.intersects(blocked))
+            {
+                continue;
+            }
+            for (int word = 0; word < 2; ++word)
+            {
+                for (std::uint64_t bits = placement.mask.words[word]; bits; bits &= bits - 1)
+                {
+                    ++density[word * 64 + __builtin_ctzll(bits)];
+                }
+            }
+        }
+    }
+    return density;
+}
+
+std::vector<std::uint8_t> bestDensityCells(const ShotDensity &density, const CellMask &blocked)
+{
+    std::vector<std::uint8_t> best;
+    std::uint32_t peak = 0;
+    for (int cell = 0; cell < CELL_COUNT; ++cell)
+    {
+        if (blocked.test(cell) || density[cell] < peak)
+        {
+            continue;
+        }
+        if (density[cell] > peak)
+        {
+            peak = density[cell];
+            best.clear();
+        }
+        best.push_back(static_cast<std::uint8_t>(cell));
+    }
+    return best;
+}
+
+void TargetView::markShot(const Coordinate &target, bool hit)
+{
+    const int cell = target.first * Board::SIZE + target.second;
+    attacked.set(cell);
+    if (hit)
+    {
+        hits.set(cell);
+    }
+}
+
+void TargetView::markSunk(std::uint8_t code, int shipSize)
+{
+    sunk |= placementMask(code, shipSize);
+    auto ship = std::find(afloat.begin(), afloat.end(), shipSize);
+    if (ship != afloat.end())
+    {
+        afloat.erase(ship);
+    }
+}
+
+TargetView targetView(const Board &opponent)
+{
+    TargetView view;
+    view.attacked = opponent.getAttackedCells();
+    view.hits = opponent.getHitCells();
+    view.afloat.clear();
+    for (const Ship *ship : opponent.getShips())
+    {
+        if (!ship->isSunk())
+        {
+            view.afloat.push_back(ship->getSize());
+            continue;
+        }
+        for (const auto &coord : ship->getPositions())
+        {
+            view.sunk.set(coord.first * Board::SIZE + coord.second);
+        }
+    }
+    return view;
+}
+
+ComputerAI::ComputerAI(Difficulty difficulty, std::uint64_t seed)
+    : difficulty(difficulty), limits(defaultSearchLimits(difficulty))
+{
+    reset(seed);
+}
+
+void ComputerAI::reset(std::uint64_t seed)
+{
+    rng.seed(seed);
+    hitQueue.clear();
+    lastHit = {-1, -1};
+    huntingMode = false;
+    refillShots();
+}
+
+void ComputerAI::refillShots()
+{
+    remainingShots.clear();
+    remainingShots.reserve(Board::SIZE * Board::SIZE);
+    for (int row = 0; row < Board::SIZE; ++row)
+    {
+        for (int col = 0; col < Board::SIZE; ++col)
+        {
+            remainingShots.emplace_back(row, col);
+        }
+    }
+    std::shuffle(remainingShots.begin(), remainingShots.end(), rng);
+}
+
+bool ComputerAI::inBounds(const Coordinate &coord)
+{
+    return coord.first >= 0 && coord.first < Board::SIZE && coord.second >= 0 && coord.second < Board::SIZE;
+}
+
+void ComputerAI::setDifficulty(Difficulty level)
+{
+    difficulty = level;
+    limits = defaultSearchLimits(level);
+}
+
+ComputerAI::Move ComputerAI::chooseMove(const TargetView &opponent, const std::atomic<bool> *cancel)
+{
+    return chooseMove(opponent, std::chrono::steady_clock::now() + limits.budget, cancel);
+}
+
+ComputerAI::Move ComputerAI::chooseMove(const TargetView &opponent, std::chrono::steady_clock::time_point deadline,
+                                        const std::atomic<bool> *cancel)
+{
+    ScopedTimer timer(static_cast<Timer>(static_cast<int>(Timer::MoveEasy) + static_cast<int>(difficulty)));
+
+    // Hard mode: opening book first, then the anytime search
+    if (difficulty == Difficulty::Hard)
+    {
+        Coordinate target;
+        if (bookTarget(opponent, target))
+        {
+            return Move{target, 0};
+        }
+        if (limits.budget.count() > 0)
+        {
+            Move move = sampleTarget(opponent, deadline, cancel);
+            if (move.target.first != -1)
+            {
+                return move;
+            }
+        }
+    }
+
+    return Move{heuristicTarget(opponent, cancel), 0};
+}
+
+ComputerAI::Volley ComputerAI::chooseVolley(const TargetView &opponent, int shots, const std::atomic<bool> *cancel)
+{
+    Volley volley;
+    TargetView view = opponent;
+    const auto start = std::chrono::steady_clock::now();
+    for (int shot = 0; shot < shots && view.attacked.count() < CELL_COUNT; ++shot)
+    {
+        const Move move = chooseMove(view, start + limits.budget * (shot + 1) / shots, cancel);
+        volley.targets.push_back(move.target);
+        volley.iterations += move.iterations;
+        view.markShot(move.target, false);
+    }
+    return volley;
+}
+
+Coordinate ComputerAI::heuristicTarget(const TargetView &opponent, const std::atomic<bool> *cancel)
+{
+    // Smart AI for Medium and Hard difficulty: finish off known hits first
+    if (difficulty != Difficulty::Easy)
+    {
+        while (!hitQueue.empty())
+        {
+            Coordinate target = hitQueue.back();
+            hitQueue.pop_back();
+            if (!opponent.isAttacked(target))
+            {
+                return target;
+            }
+        }
+    }
+
+    if (difficulty == Difficulty::Hard && huntingMode && lastHit.first != -1)
+    {
+        // Hard mode: Try adjacent cells to last hit
+        std::vector<Coordinate> adjacent = {
+            {lastHit.first - 1, lastHit.second},
+            {lastHit.first + 1, lastHit.second},
+            {lastHit.first, lastHit.second - 1},
+            {lastHit.first, lastHit.second + 1}};
+        std::shuffle(adjacent.begin(), adjacent.end(), rng);
+
+        for (const auto &coord : adjacent)
+        {
+            if (inBounds(coord) && !opponent.isAttacked(coord))
+            {
+                return coord;
+            }
+        }
+    }
+
+    // Without a search result, Hard mode hunts by placement density
+    if (difficulty == Difficulty::Hard)
+    {
+        Coordinate target = huntTarget(opponent);
+        if (target.first != -1)
+        {
+            return target;
+        }
+    }
+
+    // Random shot if no smart target
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        while (!remainingShots.empty())
+        {
+            if (cancel && cancel->load(std::memory_order_relaxed))
+            {
+                return remainingShots.back();
+            }
+
+            Coordinate target = remainingShots.back();
+            remainingShots.pop_back();
+            if (!opponent.isAttacked(target))
+            {
+                return target;
+            }
+        }
+        refillShots();
+    }
+
+    return Coordinate{0, 0};
+}
+
+bool ComputerAI::bookTarget(const TargetView &opponent, Coordinate &target)
+{
+    // The book only covers positions where every shot missed
+    if (!book || opponent.hits.any())
+    {
+        return false;
+    }
+
+    std::size_t count = 0;
+    const std::uint8_t *cells = book->lookup(opponent.attacked, count);
+    if (!cells)
+    {
+        return false;
+    }
+    std::uniform_int_distribution<std::size_t> pick(0, count - 1);
+    const int cell = cells[pick(rng)];
+    target = Coordinate{cell / Board::SIZE, cell % Board::SIZE};
+    return true;
+}
+
+Coordinate ComputerAI::huntTarget(const TargetView &opponent)
+{
+    std::vector<std::uint8_t> best =
+        bestDensityCells(huntDensity(opponent.attacked, opponent.afloat), opponent.attacked);
+    if (best.empty())
+    {
+        return Coordinate{-1, -1};
+    }
+    std::uniform_int_distribution<std::size_t> pick(0, best.size() - 1);
+    const int cell = best[pick(rng)];
+    return Coordinate{cell / Board::SIZE, cell % Board::SIZE};
+}
+
+ComputerAI::Move ComputerAI::sampleTarget(const TargetView &opponent, std::chrono::steady_clock::time_point deadline,
+                                          const std::atomic<bool> *cancel)
+{
+    // What the shots so far reveal: misses and sunk ships are off limits,
+    // and hits on ships still afloat must be covered by every sample
+    const CellMask &attacked = opponent.attacked;
+    CellMask blocked;
+    CellMask openHits;
+    for (int word = 0; word < 2; ++word)
+    {
+        blocked.words[word] = (attacked.words[word] & ~opponent.hits.words[word]) | opponent.sunk.words[word];
+        openHits.words[word] = opponent.hits.words[word] & ~opponent.sunk.words[word];
+    }
+
+    std::vector<std::vector<const ShipPlacement *>> options;
+    for (int size : opponent.afloat)
+    {
+        options.emplace_back();
+        for (const auto &placement : shipPlacements(size))
+        {
+            if (!placement.mask.intersects(blocked))
+            {
+                options.back().push_back(&placement);
+            }
+        }
+        if (options.back().empty())
+        {
+            return Move{{-1, -1}, 0};
+        }
+    }
+
+    ShotDensity counts{};
+    std::uint64_t iterations = 0;
+    std::uint64_t accepted = 0;
+    while (limits.maxIterations == 0 || iterations < limits.maxIterations)
+    {
+        // Clock and cancel checks are amortized over a batch of samples
+        if ((iterations & 63) == 0 && iterations > 0 &&
+            (std::chrono::steady_clock::now() >= deadline || (cancel && cancel->load(std::memory_order_relaxed))))
+        {
+            break;
+        }
+        ++iterations;
+
+        CellMask occupied;
+        bool valid = true;
+        for (const auto &shipOptions : options)
+        {
+            const ShipPlacement &placement = *shipOptions[rng() % shipOptions.size()];
+            if (placement.mask.intersects(occupied))
+            {
+                valid = false;
+                break;
+            }
+            occupied |= placement.mask;
+        }
+        if (!valid || (openHits.words[0] & ~occupied.words[0]) || (openHits.words[1] & ~occupied.words[1]))
+        {
+            continue;
+        }
+
+        ++accepted;
+        for (int word = 0; word < 2; ++word)
+        {
+            for (std::uint64_t bits = occupied.words[word] & ~attacked.words[word]; bits; bits &= bits - 1)
+            {
+                ++counts[word * 64 + __builtin_ctzll(bits)];
+            }
+        }
+    }
+
+    if (accepted == 0)
+    {
+        return Move{{-1, -1}, iterations};
+    }
+    std::vector<std::uint8_t> best = bestDensityCells(counts, attacked);
+    std::uniform_int_distribution<std::size_t> pick(0, best.size() - 1);
+    const int cell = best[pick(rng)];
+    return Move{{cell / Board::SIZE, cell % Board::SIZE}, iterations};
+}
+
+void ComputerAI::recordResult(const Coordinate &target, Board::AttackResult result, const TargetView &opponent)
+{
+    applyResult(target, result, opponent);
+}
+
+void ComputerAI::recordResult(const Coordinate &target, Board::AttackResult result, const Board &opponent)
+{
+    applyResult(target, result, opponent);
+}
+
+void ComputerAI::recordVolley(const std::vector<Coordinate> &targets, const std::vector<Board::ShotResult> &results,
+                              const Board &opponent)
+{
+    for (std::size_t i = 0; i < targets.size() && i < results.size(); ++i)
+    {
+        applyResult(targets[i], results[i].result, opponent);
+    }
+}
+
+template <typename Opponent>
+void ComputerAI::applyResult(const Coordinate &target, Board::AttackResult result, const Opponent &opponent)
+{
+    switch (result)
+    {
+    case Board::AttackResult::Miss:
+        huntingMode = false;
+        break;
+    case Board::AttackResult::Hit:
+        // Add adjacent cells to hit queue for smart targeting
+        if (difficulty != Difficulty::Easy)
+        {
+            lastHit = target;
+            huntingMode = true;
+
+            const Coordinate adjacent[] = {
+                {target.first - 1, target.second},
+                {target.first + 1, target.second},
+                {target.first, target.second - 1},
+                {target.first, target.second + 1}};
+
+            for (const auto &coord : adjacent)
+            {
+                if (inBounds(coord) && !opponent.isAttacked(coord))
+                {
+                    hitQueue.push_back(coord);
+                }
+            }
+        }
+        break;
+    case Board::AttackResult::Sunk:
+        hitQueue.clear();
+        huntingMode = false;
+        lastHit = {-1, -1};
+        break;
+    default:
+        break;
+    }
+}
+
+ComputerAI::State ComputerAI::getState() const
+{
+    return State{hitQueue, lastHit, huntingMode, remainingShots, rng.state()};
+}
+
+void ComputerAI::setState(State state)
+{
+    hitQueue = std::move(state.hitQueue);
+    lastHit = state.lastHit;
+    huntingMode = state.huntingMode;
+    remainingShots = std::move(state.remainingShots);
+    rng.setState(state.rng);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "GameLogic.h"
+#include "Random.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Difficulty levels
+enum class Difficulty
+{
+    Easy,
+    Medium,
+    Hard
+};
+
+const char *difficultyName(Difficulty difficulty);
+// Case-insensitive inverse of difficultyName()
+bool parseDifficulty(const std::string &name, Difficulty &difficulty);
+
+// Bounds for the anytime search. The search stops at whichever limit is
+// reached first; a zero budget disables it and leaves only the heuristics.
+struct SearchLimits
+{
+    std::chrono::microseconds budget{0};
+    std::uint64_t maxIterations = 0;
+};
+
+SearchLimits defaultSearchLimits(Difficulty difficulty);
+
+class OpeningBook;
+
+constexpr int CELL_COUNT = Board::SIZE * Board::SIZE;
+using ShotDensity = std::array<std::uint32_t, CELL_COUNT>;
+
+// Number of placements of the given ships that cover each cell while
+// avoiding every blocked cell. Blocked cells themselves score zero.
+ShotDensity huntDensity(const CellMask &blocked, const std::vector<int> &shipSizes);
+// Unblocked cells sharing the highest density, in cell order
+std::vector<std::uint8_t> bestDensityCells(const ShotDensity &density, const CellMask &blocked);
+
+// What a shooter knows about the opponent's waters: the cells attacked so
+// far, which of them hit, the cells of sunk ships and the sizes of the
+// ships still afloat. Built from a Board, or kept up to date from shot
+// results when the board lives elsewhere (a bot process, a remote player).
+struct TargetView
+{
+    CellMask attacked;
+    CellMask hits;
+    CellMask sunk;
+    std::vector<int> afloat{STANDARD_SHIP_SIZES.begin(), STANDARD_SHIP_SIZES.end()};
+
+    bool isAttacked(const Coordinate &coord) const { return attacked.test(coord.first * Board::SIZE + coord.second); }
+    void markShot(const Coordinate &target, bool hit);
+    // A ship sank; code is its FleetLayout placement
+    void markSunk(std::uint8_t code, int shipSize);
+};
+
+TargetView targetView(const Board &opponent);
+
+// Computer opponent, independent of any front end.
+//
+// chooseMove() only reads what a TargetView exposes of the opponent board,
+// so it can run on a worker thread while the board is being rendered. The
+// result of the shot is fed back through recordResult().
+//
+// With a search budget, each move is an anytime Monte Carlo search: it
+// samples complete fleets consistent with every shot so far and fires at
+// the cell most of them occupy, returning the best answer found when the
+// deadline passes.
+class ComputerAI
+{
+public:
+    // Internal state, exposed for save games
+    struct State
+    {
+        std::vector<Coordinate> hitQueue;
+        Coordinate lastHit{-1, -1};
+        bool huntingMode = false;
+        std::vector<Coordinate> remainingShots;
+        // So a resumed game draws the same numbers the original would have
+        Xoshiro256::State rng{};
+    };
+
+    struct Move
+    {
+        Coordinate target{0, 0};
+        // Fleets sampled by the search (0 when it did not run)
+        std::uint64_t iterations = 0;
+    };
+
+    // One Salvo turn's targets, in firing order
+    struct Volley
+    {
+        std::vector<Coordinate> targets;
+        std::uint64_t iterations = 0;
+    };
+
+    explicit ComputerAI(Difficulty difficulty = Difficulty::Medium, std::uint64_t seed = 0);
+
+    // Clears all targeting state and reseeds from the game's AI stream
+    void reset(std::uint64_t seed);
+    // Also restores the difficulty's default search limits
+    void setDifficulty(Difficulty level);
+    void setSearchLimits(const SearchLimits &searchLimits) { limits = searchLimits; }
+    const SearchLimits &getSearchLimits() const { return limits; }
+    // Hard mode plays from the book while every shot so far has missed
+    void setOpeningBook(const OpeningBook *openingBook) { book = openingBook; }
+    Difficulty getDifficulty() const { return difficulty; }
+
+    // Returns an unattacked cell. If the deadline passes or cancel is set
+    // while searching, returns early with the best target found so far.
+    Move chooseMove(const TargetView &opponent, std::chrono::steady_clock::time_point deadline,
+                    const std::atomic<bool> *cancel = nullptr);
+    // chooseMove() against the configured budget
+    Move chooseMove(const TargetView &opponent, const std::atomic<bool> *cancel = nullptr);
+    Move chooseMove(const Board &opponent, const std::atomic<bool> *cancel = nullptr)
+    {
+        return chooseMove(targetView(opponent), cancel);
+    }
+    Coordinate chooseTarget(const Board &opponent, const std::atomic<bool> *cancel = nullptr)
+    {
+        return chooseMove(opponent, cancel).target;
+    }
+    // shots distinct unattacked cells, chosen one after another on a copy of
+    // opponent that counts the earlier picks as misses, which spreads the
+    // volley out. The configured budget is shared by the whole volley.
+    Volley chooseVolley(const TargetView &opponent, int shots, const std::atomic<bool> *cancel = nullptr);
+    // opponent already includes this shot
+    void recordResult(const Coordinate &target, Board::AttackResult result, const TargetView &opponent);
+    void recordResult(const Coordinate &target, Board::AttackResult result, const Board &opponent);
+    // recordResult() for each shot of a volley fired with Board::attackBatch()
+    void recordVolley(const std::vector<Coordinate> &targets, const std::vector<Board::ShotResult> &results,
+                      const Board &opponent);
+
+    State getState() const;
+    void setState(State state);
+
+private:
+    Difficulty difficulty;
+    SearchLimits limits;
+    std::vector<Coordinate> hitQueue;
+    Coordinate lastHit{-1, -1};
+    bool huntingMode = false;
+    std::vector<Coordinate> remainingShots;
+    Xoshiro256 rng;
+    const OpeningBook *book = nullptr;
+
+    void refillShots();
+    // Shared by the Board and TargetView overloads of recordResult()
+    template <typename Opponent>
+    void applyResult(const Coordinate &target, Board::AttackResult result, const Opponent &opponent);
+    Coordinate heuristicTarget(const TargetView &opponent, const std::atomic<bool> *cancel);
+    bool bookTarget(const TargetView &opponent, Coordinate &target);
+    Coordinate huntTarget(const TargetView &opponent);
+    Move sampleTarget(const TargetView &opponent, std::chrono::steady_clock::time_point deadline,
+                      const std::atomic<bool> *cancel);
+    static bool inBounds(const Coordinate &coord);
+};
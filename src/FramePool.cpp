@@ -0,0 +1,49 @@
+#include "FramePool.h"
+#include <new>
+
+// ============================================================================
+// FramePool Implementation
+// ============================================================================
+
+FramePool::~FramePool()
+{
+    for (FreeBlock *block : freeLists)
+    {
+        while (block)
+        {
+            FreeBlock *next = block->next;
+            ::operator delete(block);
+            block = next;
+        }
+    }
+}
+
+void *FramePool::allocate(std::size_t size)
+{
+    const std::size_t sizeClass = FramePool::sizeClass(size);
+    if (sizeClass >= freeLists.size())
+    {
+        freeLists.resize(sizeClass + 1, nullptr);
+    }
+
+    void *block = freeLists[sizeClass];
+    if (block)
+    {
+        freeLists[sizeClass] = freeLists[sizeClass]->next;
+    }
+    else
+    {
+        block = ::operator new(sizeClass * GRANULE);
+        ++heapAllocations;
+    }
+    *static_cast<FramePool **>(block) = this;
+    return static_cast<std::byte *>(block) + HEADER;
+}
+
+void FramePool::release(void *frame, std::size_t size)
+{
+    void *block = static_cast<std::byte *>(frame) - HEADER;
+    FramePool &pool = **static_cast<FramePool **>(block);
+    const std::size_t sizeClass = FramePool::sizeClass(size);
+    pool.freeLists[sizeClass] = new (block) FreeBlock{pool.freeLists[sizeClass]};
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Free lists of coroutine frames, one per 64-byte size class. Frames that
+// finish go back on their list, so once a shard has seen its peak number
+// of concurrent matches, starting another allocates nothing.
+//
+// Each frame is preceded by a pointer to its pool, since a coroutine's
+// operator delete only receives the frame and its size. Single-threaded:
+// every frame must be allocated and released on the pool's own thread,
+// and released before the pool is destroyed.
+class FramePool
+{
+public:
+    FramePool() = default;
+    ~FramePool();
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    void *allocate(std::size_t size);
+    static void release(void *frame, std::size_t size);
+
+    // Blocks obtained from the heap so far
+    std::uint64_t getHeapAllocations() const { return heapAllocations; }
+
+private:
+    static constexpr std::size_t GRANULE = 64;
+    // Keeps the frame at the alignment operator new guarantees
+    static constexpr std::size_t HEADER = alignof(std::max_align_t);
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    std::vector<FreeBlock *> freeLists;
+    std::uint64_t heapAllocations = 0;
+
+    static std::size_t sizeClass(std::size_t size) { return (size + HEADER + GRANULE - 1) / GRANULE; }
+};
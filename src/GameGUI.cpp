@@ -1,6 +1,7 @@
 #include "GameGUI.h"
 #include <algorithm>
 #include <cctype>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <random>
@@ -516,7 +517,8 @@ void MessageBox::updateDisplay()
 // GameGUI Implementation
 // ============================================================================
 
-GameGUI::GameGUI()
+GameGUI::GameGUI(std::uint64_t sessionSeed)
+    : random(sessionSeed)
 {
     initWindow();
     initFont();
@@ -526,6 +528,17 @@ GameGUI::GameGUI()
     initWaterBackground();
     initGameObjects();
     loadStats();
+    hasSavedBattle = std::filesystem::exists(autosave.getPath());
+    loadHeatmaps(heatmapWriter.getPath(), heatmaps);
+    if (layoutPool.open("layouts.bin"))
+    {
+        std::cout << "Loaded " << layoutPool.size() << " enemy fleet layouts from layouts.bin" << std::endl;
+    }
+    if (openingBook.load("opening.bin"))
+    {
+        computerAI.setOpeningBook(&openingBook);
+        std::cout << "Loaded " << openingBook.size() << " opening book positions from opening.bin" << std::endl;
+    }
     
     // Initialize fade overlay
     fadeOverlay.setSize(sf::Vector2f(1920, 1080));
@@ -534,7 +547,10 @@ GameGUI::GameGUI()
     changeState(GameState::Menu);
 }
 
-GameGUI::~GameGUI() = default;
+GameGUI::~GameGUI()
+{
+    cancelComputerMove();
+}
 
 void GameGUI::initWindow()
 {
@@ -834,35 +850,15 @@ void GameGUI::initGameObjects()
     // Initialize message box
     messageBox = std::make_unique<MessageBox>(sf::Vector2f(150, 900), sf::Vector2f(1620, 120), font);
     
-    // Initialize computer shots
-    refillComputerShots();
-}
-
-void GameGUI::refillComputerShots()
-{
-    computerShots.clear();
-    computerShots.reserve(Board::SIZE * Board::SIZE);
-    for (int row = 0; row < Board::SIZE; ++row)
-    {
-        for (int col = 0; col < Board::SIZE; ++col)
-        {
-            computerShots.emplace_back(row, col);
-        }
-    }
-    
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(computerShots.begin(), computerShots.end(), g);
+    // Reset the computer AI for a new game
+    computerAI.reset(random.aiSeed());
+    lastSearchIterations = 0;
+    savingBattle = false;
 }
 
 void GameGUI::createFleet(std::vector<std::unique_ptr<Ship>> &fleet)
 {
-    fleet.clear();
-    fleet.emplace_back(std::make_unique<AircraftCarrier>());
-    fleet.emplace_back(std::make_unique<Battleship>());
-    fleet.emplace_back(std::make_unique<Cruiser>());
-    fleet.emplace_back(std::make_unique<Submarine>());
-    fleet.emplace_back(std::make_unique<Destroyer>());
+    createStandardFleet(fleet);
 }
 
 void GameGUI::run()
@@ -879,6 +875,8 @@ void GameGUI::run()
 
 void GameGUI::processEvents()
 {
+    pollNetwork();
+
     sf::Event event;
     while (window.pollEvent(event))
     {
@@ -905,12 +903,33 @@ void GameGUI::processEvents()
         case GameState::GameOver:
             handleGameOverEvents(event);
             break;
+        case GameState::Replay:
+            handleReplayEvents(event);
+            break;
         }
     }
 }
 
 void GameGUI::handleMenuEvents(sf::Event &event)
 {
+    if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::R)
+    {
+        if (!startReplay(replayWriter.getPath(), -1, 10, false))
+        {
+            messageBox->setMessage("No recorded games to replay yet.");
+        }
+        return;
+    }
+
+    if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::C && hasSavedBattle)
+    {
+        if (!resumeSavedBattle())
+        {
+            messageBox->setMessage("The saved battle could not be loaded.");
+        }
+        return;
+    }
+
     if (event.type == sf::Event::MouseButtonPressed)
     {
         sf::Vector2i mousePos = sf::Mouse::getPosition(window);
@@ -918,7 +937,11 @@ void GameGUI::handleMenuEvents(sf::Event &event)
         {
             if (buttons[i]->isClicked(mousePos, event.mouseButton))
             {
-                if (i == 0) // Start New Game
+                if (i == 0 && network.isActive() && !network.isConnected())
+                {
+                    messageBox->setMessage("Still waiting for the other player to connect...");
+                }
+                else if (i == 0) // Start New Game
                 {
                     currentGameShots = 0;
                     currentGameHits = 0;
@@ -971,14 +994,20 @@ void GameGUI::handleSettingsEvents(sf::Event &event)
             sinkSound.setVolume(sfxVolume);
         }
         
-        // Check back button
-        for (auto &button : buttons)
+        // Check back, placement mode and rules buttons
+        if (!buttons.empty() && buttons[0]->isClicked(mousePos, event.mouseButton))
         {
-            if (button->isClicked(mousePos, event.mouseButton))
-            {
-                changeState(GameState::Menu);
-                break;
-            }
+            changeState(GameState::Menu);
+        }
+        else if (buttons.size() > 1 && buttons[1]->isClicked(mousePos, event.mouseButton))
+        {
+            placementMode = placementMode == PlacementMode::Random ? PlacementMode::Adversarial : PlacementMode::Random;
+            buttons.clear();
+        }
+        else if (buttons.size() > 2 && buttons[2]->isClicked(mousePos, event.mouseButton))
+        {
+            rules = rules == RuleSet::Classic ? RuleSet::Salvo : RuleSet::Classic;
+            buttons.clear();
         }
     }
     else if (event.type == sf::Event::MouseButtonReleased)
@@ -1102,6 +1131,46 @@ void GameGUI::handleGameOverEvents(sf::Event &event)
     }
 }
 
+void GameGUI::handleReplayEvents(sf::Event &event)
+{
+    static const int speeds[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+    if (event.type != sf::Event::KeyPressed || !replayPlayer)
+        return;
+
+    if (event.key.code == sf::Keyboard::Escape)
+    {
+        changeState(GameState::Menu);
+    }
+    else if (event.key.code == sf::Keyboard::E)
+    {
+        replayPlayer->skipToEnd();
+        messageBox->addMessage("Jumped to the end of the replay.");
+    }
+    else if (event.key.code == sf::Keyboard::Up || event.key.code == sf::Keyboard::Add)
+    {
+        for (int speed : speeds)
+        {
+            if (speed > replaySpeed)
+            {
+                replaySpeed = speed;
+                break;
+            }
+        }
+    }
+    else if (event.key.code == sf::Keyboard::Down || event.key.code == sf::Keyboard::Subtract)
+    {
+        for (auto it = std::rbegin(speeds); it != std::rend(speeds); ++it)
+        {
+            if (*it < replaySpeed)
+            {
+                replaySpeed = *it;
+                break;
+            }
+        }
+    }
+}
+
 void GameGUI::update(float deltaTime)
 {
     updateParticles(deltaTime);
@@ -1121,7 +1190,18 @@ void GameGUI::update(float deltaTime)
 
     if (state == GameState::ComputerTurn)
     {
-        updateComputerTurn();
+        if (network.isActive())
+        {
+            updateRemoteTurn();
+        }
+        else
+        {
+            updateComputerTurn();
+        }
+    }
+    else if (state == GameState::Replay)
+    {
+        updateReplay(deltaTime);
     }
 }
 
@@ -1158,24 +1238,138 @@ void GameGUI::updateComputerTurn()
 {
     if (!waitingForAction)
     {
+        // Start thinking right away so AI cost overlaps the cosmetic delay
         waitingForAction = true;
         actionClock.restart();
+        cancelMove = false;
+        const int shots = volleySize(*computerBoard, *playerBoard);
+        pendingMove = std::async(std::launch::async, [this, shots]
+                                 { return computerAI.chooseVolley(targetView(*playerBoard), shots, &cancelMove); });
     }
 
-    if (actionClock.getElapsedTime().asSeconds() >= actionDelay)
+    if (actionClock.getElapsedTime().asSeconds() >= actionDelay &&
+        pendingMove.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
     {
-        executeComputerAttack();
+        ComputerAI::Volley volley = pendingMove.get();
+        lastSearchIterations = volley.iterations;
+        executeComputerVolley(volley.targets);
         waitingForAction = false;
-        changeState(GameState::PlayerTurn);
+        if (state == GameState::ComputerTurn)
+        {
+            changeState(GameState::PlayerTurn);
+        }
+    }
+}
+
+void GameGUI::updateReplay(float deltaTime)
+{
+    if (!replayPlayer || replayPlayer->finished())
+        return;
+
+    // One shot per second at 1x; several shots per frame at high speeds
+    replayAccumulator += deltaTime * static_cast<float>(replaySpeed);
+    ReplayPlayer::Event event;
+    while (replayAccumulator >= 1.0f && replayPlayer->step(event))
+    {
+        replayAccumulator -= 1.0f;
+        applyReplayEvent(event);
+    }
+
+    if (replayPlayer->finished())
+    {
+        replayAccumulator = 0.0f;
+        messageBox->addMessage("Replay finished. Press Esc to return to the menu.");
     }
 }
 
+void GameGUI::applyReplayEvent(const ReplayPlayer::Event &event)
+{
+    const bool isPlayer = event.shooter == Shooter::Player;
+    BoardView &view = isPlayer ? *computerBoardView : *playerBoardView;
+    const std::string attacker = isPlayer ? "Player" : "Enemy";
+
+    // Effects and sounds only make sense at watchable speeds
+    const bool showEffects = replaySpeed <= 10;
+
+    switch (event.result)
+    {
+    case Board::AttackResult::Miss:
+        if (showEffects)
+        {
+            createMissEffect(view.getCellCenter(event.target));
+            missSound.play();
+        }
+        messageBox->addMessage(attacker + " misses at " + coordinateToString(event.target));
+        break;
+    case Board::AttackResult::Hit:
+        if (showEffects)
+        {
+            createHitEffect(view.getCellCenter(event.target));
+            hitSound.play();
+        }
+        messageBox->addMessage(attacker + " hits at " + coordinateToString(event.target) + "!");
+        break;
+    case Board::AttackResult::Sunk:
+        if (showEffects)
+        {
+            createSinkEffect(view.getCellCenter(event.target));
+            sinkSound.play();
+        }
+        messageBox->addMessage(attacker + " sinks the " + event.shipName + "!");
+        break;
+    default:
+        break;
+    }
+}
+
+bool GameGUI::startReplay(const std::string &path, int gameIndex, int speed, bool jumpToEnd)
+{
+    std::vector<ReplayRecord> records;
+    readReplayFile(path, records);
+    if (records.empty())
+    {
+        std::cerr << "No replays found in " << path << std::endl;
+        return false;
+    }
+
+    if (gameIndex < 0)
+    {
+        gameIndex = static_cast<int>(records.size()) - 1;
+    }
+    if (gameIndex >= static_cast<int>(records.size()))
+    {
+        std::cerr << "Replay " << gameIndex + 1 << " not found (" << records.size() << " games recorded)" << std::endl;
+        return false;
+    }
+
+    auto player = std::make_unique<ReplayPlayer>(records[gameIndex]);
+    if (!player->isValid())
+    {
+        std::cerr << "Replay " << gameIndex + 1 << " in " << path << " has an invalid fleet layout" << std::endl;
+        return false;
+    }
+
+    replayPlayer = std::move(player);
+    replaySpeed = std::max(1, std::min(1000, speed));
+    replayAccumulator = 0.0f;
+    changeState(GameState::Replay);
+    messageBox->setMessage("Replaying game " + std::to_string(gameIndex + 1) + " of " +
+                           std::to_string(records.size()) + " (seed " + std::to_string(replayPlayer->getSeed()) + ")");
+
+    if (jumpToEnd)
+    {
+        replayPlayer->skipToEnd();
+    }
+    return true;
+}
+
 void GameGUI::render()
 {
     window.clear(Colors::Background);
 
     // Draw animated water background for battle scenes
-    if (state == GameState::PlayerTurn || state == GameState::ComputerTurn || state == GameState::PlacingShips)
+    if (state == GameState::PlayerTurn || state == GameState::ComputerTurn || state == GameState::PlacingShips ||
+        state == GameState::Replay)
     {
         renderWaterBackground();
     }
@@ -1198,6 +1392,9 @@ void GameGUI::render()
     case GameState::GameOver:
         renderGameOver();
         break;
+    case GameState::Replay:
+        renderReplay();
+        break;
     }
 
     // Draw particles
@@ -1273,6 +1470,11 @@ void GameGUI::renderMenu()
 
     drawCenteredText("Select Difficulty:", 640, 22);
     drawCenteredText("Sink all enemy ships to win!", 840, 24);
+    drawCenteredText("Press R to watch your last game", 880, 18);
+    if (hasSavedBattle)
+    {
+        drawCenteredText("Press C to continue your saved battle", 910, 18);
+    }
     
     // Display stats
     std::stringstream ss;
@@ -1280,6 +1482,22 @@ void GameGUI::renderMenu()
        << stats.gamesWon << " Wins | "
        << std::fixed << std::setprecision(1) << stats.getAccuracy() << "% Accuracy";
     drawCenteredText(ss.str(), 950, 20);
+    drawCenteredText("Session seed: " + std::to_string(random.getSessionSeed()), 990, 16);
+
+    switch (network.getStatus())
+    {
+    case NetworkManager::Status::Listening:
+        drawCenteredText("Hosting a two-player game on " + network.getEndpoint() + " - waiting for an opponent", 1020, 18);
+        break;
+    case NetworkManager::Status::Connecting:
+        drawCenteredText("Connecting to " + network.getEndpoint() + "...", 1020, 18);
+        break;
+    case NetworkManager::Status::Connected:
+        drawCenteredText("Opponent connected - start a new game to deploy your fleet", 1020, 18);
+        break;
+    case NetworkManager::Status::Offline:
+        break;
+    }
 }
 
 void GameGUI::renderSettings()
@@ -1314,10 +1532,14 @@ void GameGUI::renderSettings()
     sfxFill.setFillColor(Colors::Highlight);
     window.draw(sfxFill);
     
-    // Draw back button
+    // Draw back, placement mode and rules buttons
     if (buttons.empty())
     {
-        buttons.push_back(std::make_unique<Button>(sf::Vector2f(760, 700), sf::Vector2f(400, 80), "Back to Menu", font));
+        buttons.push_back(std::make_unique<Button>(sf::Vector2f(760, 800), sf::Vector2f(400, 80), "Back to Menu", font));
+        buttons.push_back(std::make_unique<Button>(sf::Vector2f(660, 680), sf::Vector2f(600, 70),
+                                                   std::string("Enemy Fleet: ") + placementModeName(placementMode), font));
+        buttons.push_back(std::make_unique<Button>(sf::Vector2f(660, 230), sf::Vector2f(600, 70),
+                                                   std::string("Rules: ") + ruleSetName(rules), font));
     }
     
     for (auto &button : buttons)
@@ -1325,7 +1547,7 @@ void GameGUI::renderSettings()
         button->draw(window);
     }
     
-    drawCenteredText("Click and drag sliders to adjust volume", 650, 20);
+    drawCenteredText("Click and drag sliders to adjust volume", 600, 20);
 }
 
 void GameGUI::renderPlacement()
@@ -1340,6 +1562,10 @@ void GameGUI::renderPlacement()
                                   std::to_string(currentShip->getSize()) + "). Press R to rotate.";
         drawCenteredText(instruction, 140, 24);
     }
+    else if (network.isActive())
+    {
+        drawCenteredText("Waiting for your opponent to deploy...", 140, 24);
+    }
 
     // Draw player board
     if (playerBoard)
@@ -1395,9 +1621,13 @@ void GameGUI::renderBattle()
         }
     }
 
-    // Highlight hovered cell during player turn
+    // Highlight hovered cell and the salvo picked so far during player turn
     if (state == GameState::PlayerTurn)
     {
+        for (const auto &selected : selectedShots)
+        {
+            computerBoardView->highlightCell(window, selected, Colors::Hit);
+        }
         Coordinate hoverCoord;
         if (computerBoardView->getCellFromMouse(sf::Mouse::getPosition(window), hoverCoord))
         {
@@ -1407,6 +1637,11 @@ void GameGUI::renderBattle()
 
     // Turn indicator
     std::string turnText = (state == GameState::PlayerTurn) ? "YOUR TURN" : "ENEMY TURN";
+    if (state == GameState::PlayerTurn && playerBoard && volleySize(*playerBoard, *computerBoard) > 1)
+    {
+        turnText = "YOUR SALVO: " + std::to_string(selectedShots.size()) + " / " +
+                   std::to_string(volleySize(*playerBoard, *computerBoard));
+    }
     sf::Color turnColor = (state == GameState::PlayerTurn) ? Colors::Highlight : Colors::Hit;
     
     sf::Text turnIndicator(turnText, font, 32);
@@ -1422,6 +1657,24 @@ void GameGUI::renderBattle()
     ss << "Shots: " << currentGameShots << " | Hits: " << currentGameHits 
        << " | Accuracy: " << std::fixed << std::setprecision(1) << accuracy << "%";
     drawCenteredText(ss.str(), 850, 20);
+    if (network.isConnected())
+    {
+        std::stringstream ping;
+        ping << "Opponent ping: ";
+        if (network.getRoundTripMs() < 0.0f)
+        {
+            ping << "measuring...";
+        }
+        else
+        {
+            ping << std::fixed << std::setprecision(1) << network.getRoundTripMs() << " ms";
+        }
+        drawCenteredText(ping.str(), 875, 16);
+    }
+    else if (lastSearchIterations > 0)
+    {
+        drawCenteredText("Enemy weighed " + std::to_string(lastSearchIterations) + " possible fleets", 875, 16);
+    }
     
     // Show ship tooltip on hover (player board only for now)
     if (playerBoard)
@@ -1503,9 +1756,9 @@ void GameGUI::renderGameOver()
     drawCenteredText(ss.str(), 500, 24);
     
     // Show difficulty
-    std::string diffStr = (difficulty == Difficulty::Easy) ? "Easy" :
-                         (difficulty == Difficulty::Medium) ? "Medium" : "Hard";
-    drawCenteredText("Difficulty: " + diffStr, 550, 24);
+    drawCenteredText(std::string("Difficulty: ") + difficultyName(difficulty), 550, 24);
+    drawCenteredText("Session seed: " + std::to_string(random.getSessionSeed()) +
+                     " | Game seed: " + std::to_string(random.getGameSeed()), 600, 18);
 
     // Draw buttons
     if (buttons.empty())
@@ -1520,6 +1773,138 @@ void GameGUI::renderGameOver()
     }
 }
 
+void GameGUI::renderReplay()
+{
+    drawTitle("REPLAY", 50);
+
+    sf::Text playerLabel("Player Fleet", font, 28);
+    playerLabel.setFillColor(Colors::Text);
+    playerLabel.setPosition(320, 160);
+    window.draw(playerLabel);
+
+    sf::Text enemyLabel("Enemy Fleet", font, 28);
+    enemyLabel.setFillColor(Colors::Text);
+    enemyLabel.setPosition(1200, 160);
+    window.draw(enemyLabel);
+
+    if (replayPlayer)
+    {
+        if (useShipSprites)
+        {
+            playerBoardView->draw(window, replayPlayer->getPlayerBoard(), font, shipTextures);
+            computerBoardView->draw(window, replayPlayer->getComputerBoard(), font, shipTextures);
+        }
+        else
+        {
+            playerBoardView->draw(window, replayPlayer->getPlayerBoard(), font);
+            computerBoardView->draw(window, replayPlayer->getComputerBoard(), font);
+        }
+
+        std::stringstream ss;
+        ss << "Shot " << replayPlayer->getShotIndex() << " / " << replayPlayer->getShotCount()
+           << " | Speed: " << replaySpeed << "x";
+        drawCenteredText(ss.str(), 120, 28);
+    }
+
+    drawCenteredText("Up/Down: change speed | E: jump to end | Esc: main menu", 850, 20);
+    messageBox->draw(window);
+}
+
+void GameGUI::finishReplayRecording(bool gameFinished)
+{
+    if (!replayWriter.isRecording())
+        return;
+
+    const ReplayRecord &record = replayWriter.endGame();
+    replayWriter.flush();
+
+    // Abandoned games stay resumable, so only finished ones are aggregated
+    if (gameFinished && !network.isActive())
+    {
+        heatmaps.addGame(record);
+        heatmapWriter.submit(serializeHeatmaps(heatmaps));
+    }
+}
+
+void GameGUI::recordShot(Shooter shooter, const Coordinate &target)
+{
+    replayWriter.recordShot(shooter, target);
+    shotLog.push_back(encodeShot(shooter, target));
+}
+
+void GameGUI::autosaveBattle()
+{
+    BattleSnapshot snapshot;
+    snapshot.seed = random.getGameSeed();
+    snapshot.difficulty = static_cast<std::uint8_t>(difficulty);
+    snapshot.computerToMove = state == GameState::ComputerTurn;
+    snapshot.playerLayout = encodeFleetLayout(playerFleet);
+    snapshot.computerLayout = encodeFleetLayout(computerFleet);
+    snapshot.shots = shotLog;
+    ComputerAI::State aiState = computerAI.getState();
+    snapshot.hitQueue = std::move(aiState.hitQueue);
+    snapshot.lastHit = aiState.lastHit;
+    snapshot.huntingMode = aiState.huntingMode;
+    snapshot.computerShots = std::move(aiState.remainingShots);
+    snapshot.aiRng = aiState.rng;
+    snapshot.shotsFired = currentGameShots;
+    snapshot.hits = currentGameHits;
+
+    // Serializing takes microseconds; the disk write happens off-thread
+    autosave.submit(serializeSnapshot(snapshot));
+    hasSavedBattle = true;
+}
+
+bool GameGUI::resumeSavedBattle()
+{
+    autosave.waitIdle();
+
+    BattleSnapshot snapshot;
+    if (!loadSnapshot(autosave.getPath(), snapshot))
+    {
+        return false;
+    }
+
+    initGameObjects();
+    if (!applyFleetLayout(*playerBoard, playerFleet, snapshot.playerLayout) ||
+        !applyFleetLayout(*computerBoard, computerFleet, snapshot.computerLayout))
+    {
+        initGameObjects();
+        return false;
+    }
+
+    std::string shipName;
+    for (std::uint8_t shot : snapshot.shots)
+    {
+        Board &target = decodeShooter(shot) == Shooter::Player ? *computerBoard : *playerBoard;
+        target.attack(decodeTarget(shot), shipName);
+    }
+
+    random.restoreGame(snapshot.seed);
+    rules = RuleSet::Classic;
+    difficulty = static_cast<Difficulty>(std::min<int>(snapshot.difficulty, static_cast<int>(Difficulty::Hard)));
+    computerAI.reset(random.aiSeed());
+    computerAI.setDifficulty(difficulty);
+    // A version 1 save keeps the generator reset() just seeded
+    const bool savedRng = snapshot.aiRng != Xoshiro256::State{};
+    computerAI.setState({snapshot.hitQueue, snapshot.lastHit, snapshot.huntingMode, snapshot.computerShots,
+                         savedRng ? snapshot.aiRng : computerAI.getState().rng});
+    currentGameShots = snapshot.shotsFired;
+    currentGameHits = snapshot.hits;
+    shotLog = snapshot.shots;
+    savingBattle = true;
+
+    replayWriter.beginGame(random.getGameSeed(), snapshot.playerLayout, snapshot.computerLayout);
+    for (std::uint8_t shot : shotLog)
+    {
+        replayWriter.recordShot(decodeShooter(shot), decodeTarget(shot));
+    }
+
+    changeState(snapshot.computerToMove ? GameState::ComputerTurn : GameState::PlayerTurn);
+    messageBox->addMessage("Saved battle restored.");
+    return true;
+}
+
 void GameGUI::changeState(GameState newState)
 {
     GameState oldState = state;
@@ -1540,6 +1925,7 @@ void GameGUI::changeState(GameState newState)
     case GameState::PlacingShips:
     case GameState::PlayerTurn:
     case GameState::ComputerTurn:
+    case GameState::Replay:
         oldMusic = &battleMusic;
         break;
     case GameState::GameOver:
@@ -1557,6 +1943,7 @@ void GameGUI::changeState(GameState newState)
     case GameState::PlacingShips:
     case GameState::PlayerTurn:
     case GameState::ComputerTurn:
+    case GameState::Replay:
         newMusic = &battleMusic;
         break;
     case GameState::GameOver:
@@ -1583,7 +1970,10 @@ void GameGUI::changeState(GameState newState)
     switch (newState)
     {
     case GameState::Menu:
-        // Reset game
+        // Reset game (an abandoned game is still recorded)
+        cancelComputerMove();
+        finishReplayRecording(false);
+        replayPlayer.reset();
         initGameObjects();
         messageBox->clear();
         particles.clear();
@@ -1595,20 +1985,63 @@ void GameGUI::changeState(GameState newState)
 
     case GameState::PlacingShips:
         placementState = PlacementState();
+        random.beginGame();
+        remoteShots.clear();
+        if (!network.isActive())
+        {
+            startPlacementSearch();
+        }
         messageBox->setMessage("Click on the board to place your ships. Press R to rotate.");
         break;
 
     case GameState::PlayerTurn:
-        messageBox->addMessage("Your turn - click on enemy waters to attack!");
+    {
+        selectedShots.clear();
+        const int shots = volleySize(*playerBoard, *computerBoard);
+        if (shots > 1)
+        {
+            messageBox->addMessage("Your salvo - pick " + std::to_string(shots) + " targets in enemy waters!");
+        }
+        else
+        {
+            messageBox->addMessage("Your turn - click on enemy waters to attack!");
+        }
+        if (savingBattle)
+        {
+            autosaveBattle();
+        }
         break;
+    }
 
     case GameState::ComputerTurn:
-        messageBox->addMessage("Enemy is attacking...");
         waitingForAction = false;
+        if (network.isActive())
+        {
+            messageBox->addMessage("Waiting for your opponent's shot...");
+            break;
+        }
+        messageBox->addMessage("Enemy is attacking...");
+        if (savingBattle)
+        {
+            autosaveBattle();
+        }
         break;
 
     case GameState::GameOver:
         // Music already started above
+        finishReplayRecording(true);
+        // A game that never wrote the save leaves the saved battle in place
+        if (savingBattle)
+        {
+            autosave.remove();
+            hasSavedBattle = false;
+            savingBattle = false;
+        }
+        break;
+
+    case GameState::Replay:
+        particles.clear();
+        computerBoardView->setShowShips(true);
         break;
     }
 }
@@ -1637,72 +2070,182 @@ void GameGUI::placeCurrentShip(const Coordinate &start, bool horizontal)
 
 void GameGUI::finishPlacement()
 {
+    if (network.isActive())
+    {
+        network.sendPlace(encodeFleetLayout(playerFleet));
+        if (remoteLayout)
+        {
+            beginNetworkBattle();
+        }
+        else
+        {
+            messageBox->addMessage("All ships deployed! Waiting for your opponent...");
+        }
+        return;
+    }
+
     setupComputerFleet();
+    computerAI.reset(random.aiSeed());
+    computerAI.setDifficulty(difficulty);
+    shotLog.clear();
+    // Save games do not record the rules, so only Classic battles are saved
+    savingBattle = rules == RuleSet::Classic;
+    replayWriter.beginGame(random.getGameSeed(), encodeFleetLayout(playerFleet), encodeFleetLayout(computerFleet));
     messageBox->addMessage("All ships deployed! Battle begins!");
     changeState(GameState::PlayerTurn);
 }
 
-void GameGUI::setupComputerFleet()
+bool GameGUI::startNetworkGame(bool host, const std::string &address, unsigned short port)
 {
-    if (!loadComputerPlacements())
+    if (host ? !network.host(port) : !network.join(address, port))
     {
-        generateComputerPlacements();
-        saveComputerPlacements();
+        return false;
     }
+
+    messageBox->setMessage(host ? "Waiting for an opponent on " + network.getEndpoint() + "..."
+                                : "Connecting to " + network.getEndpoint() + "...");
+    return true;
 }
 
-void GameGUI::generateComputerPlacements()
+void GameGUI::pollNetwork()
 {
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    std::uniform_int_distribution<int> orientationDist(0, 1);
-    
-    while (true)
+    networkEvents.clear();
+    network.poll(networkEvents);
+
+    for (const auto &event : networkEvents)
     {
-        computerBoard->clear();
-        for (auto &ship : computerFleet)
+        switch (event.type)
         {
-            ship->reset();
-        }
+        case NetworkManager::Event::Type::Connected:
+            if (state == GameState::Menu)
+            {
+                currentGameShots = 0;
+                currentGameHits = 0;
+                changeState(GameState::PlacingShips);
+            }
+            messageBox->addMessage("Opponent connected!");
+            break;
 
-        bool success = true;
-        for (auto &ship : computerFleet)
-        {
-            bool placed = false;
-            for (int attempt = 0; attempt < 500 && !placed; ++attempt)
+        case NetworkManager::Event::Type::Place:
+            remoteLayout = event.layout;
+            if (state == GameState::PlacingShips &&
+                placementState.currentShipIndex >= static_cast<int>(playerFleet.size()))
             {
-                bool horizontal = orientationDist(rng) == 0;
-                int maxRow = horizontal ? Board::SIZE - 1 : Board::SIZE - ship->getSize();
-                int maxCol = horizontal ? Board::SIZE - ship->getSize() : Board::SIZE - 1;
+                beginNetworkBattle();
+            }
+            break;
 
-                if (maxRow < 0 || maxCol < 0)
-                {
-                    continue;
-                }
+        case NetworkManager::Event::Type::Fire:
+            remoteShots.push_back(event.target);
+            break;
 
-                std::uniform_int_distribution<int> rowDist(0, maxRow);
-                std::uniform_int_distribution<int> colDist(0, maxCol);
+        case NetworkManager::Event::Type::Disconnected:
+            remoteLayout.reset();
+            remoteShots.clear();
+            if (state == GameState::PlacingShips || state == GameState::PlayerTurn ||
+                state == GameState::ComputerTurn)
+            {
+                changeState(GameState::Menu);
+            }
+            messageBox->setMessage("Your opponent disconnected.");
+            break;
+        }
+    }
+}
 
-                Coordinate start{rowDist(rng), colDist(rng)};
+void GameGUI::beginNetworkBattle()
+{
+    const FleetLayout layout = *remoteLayout;
+    remoteLayout.reset();
+    if (!applyFleetLayout(*computerBoard, computerFleet, layout))
+    {
+        network.disconnect();
+        changeState(GameState::Menu);
+        messageBox->setMessage("Your opponent sent an invalid fleet and was disconnected.");
+        return;
+    }
 
-                if (computerBoard->placeShip(*ship, start, horizontal))
-                {
-                    placed = true;
-                }
-            }
+    // Replays and heatmaps describe games against the computer, so a game
+    // between two players is not recorded. It cannot be resumed against the
+    // computer either, so it is not autosaved.
+    shotLog.clear();
+    savingBattle = false;
+    messageBox->addMessage("Both fleets deployed! Battle begins!");
+    changeState(network.isHost() ? GameState::PlayerTurn : GameState::ComputerTurn);
+}
 
-            if (!placed)
-            {
-                success = false;
-                break;
-            }
+void GameGUI::updateRemoteTurn()
+{
+    // Both sides apply every shot to identical boards, so a repeated cell
+    // can only come from a broken peer; it is ignored
+    while (!remoteShots.empty() && state == GameState::ComputerTurn)
+    {
+        const Coordinate target = remoteShots.front();
+        remoteShots.pop_front();
+        if (playerBoard->isAttacked(target))
+        {
+            continue;
+        }
+
+        executeComputerVolley({target});
+        if (state == GameState::ComputerTurn)
+        {
+            changeState(GameState::PlayerTurn);
+        }
+    }
+}
+
+void GameGUI::startPlacementSearch()
+{
+    // The search owns the whole pool, so never overlap two of them
+    if (placementSearch.valid())
+    {
+        placementSearch.wait();
+    }
+    if (placementMode != PlacementMode::Adversarial)
+    {
+        placementSearch = std::future<PlacementSearchResult>();
+        return;
+    }
+
+    const std::uint64_t searchSeed = random.placement()();
+    const OpeningBook *book = openingBook.size() ? &openingBook : nullptr;
+    placementSearch = std::async(std::launch::async, [this, searchSeed, book]
+                                 { return searchAdversarialLayout(searchPool, searchSeed, std::chrono::milliseconds(50), book); });
+}
+
+void GameGUI::setupComputerFleet()
+{
+    if (placementSearch.valid())
+    {
+        PlacementSearchResult result = placementSearch.get();
+        if (applyFleetLayout(*computerBoard, computerFleet, result.layout))
+        {
+            std::cout << "Adversarial placement: best of " << result.candidates << " layouts survives "
+                      << result.meanShots << " shots on average" << std::endl;
+            return;
         }
+    }
 
-        if (success)
+    // A pre-generated pool gives a fresh enemy layout every game in O(1)
+    if (layoutPool.isOpen())
+    {
+        if (applyFleetLayout(*computerBoard, computerFleet, layoutPool.pick(random.placement())))
         {
             return;
         }
     }
+
+    if (!loadComputerPlacements())
+    {
+        generateComputerPlacements();
+        saveComputerPlacements();
+    }
+}
+
+void GameGUI::generateComputerPlacements()
+{
+    applyFleetLayout(*computerBoard, computerFleet, randomFleetLayout(random.placement()));
 }
 
 bool GameGUI::loadComputerPlacements()
@@ -1818,173 +2361,152 @@ void GameGUI::saveComputerPlacements() const
     }
 }
 
+int GameGUI::volleySize(const Board &fleet, const Board &target) const
+{
+    // Late in a salvo the ships afloat can outnumber the open cells
+    const int open = CELL_COUNT - target.getAttackedCells().count();
+    return std::min(network.isActive() ? 1 : shotsPerTurn(rules, fleet), open);
+}
+
 void GameGUI::playerAttack(const Coordinate &target)
 {
-    std::string shipName;
-    Board::AttackResult result = computerBoard->attack(target, shipName);
+    const int shots = volleySize(*playerBoard, *computerBoard);
+    if (shots <= 1)
+    {
+        firePlayerVolley({target});
+        return;
+    }
 
-    switch (result)
+    if (computerBoard->isAttacked(target))
     {
-    case Board::AttackResult::Miss:
-        createMissEffect(computerBoardView->getCellCenter(target));
-        messageBox->addMessage("Miss at " + coordinateToString(target));
-        missSound.play();
-        currentGameShots++;
-        break;
-    case Board::AttackResult::Hit:
-        createHitEffect(computerBoardView->getCellCenter(target));
-        messageBox->addMessage("Hit at " + coordinateToString(target) + "!");
-        hitSound.play();
-        currentGameShots++;
-        currentGameHits++;
-        break;
-    case Board::AttackResult::Sunk:
-        createSinkEffect(computerBoardView->getCellCenter(target));
-        messageBox->addMessage("Sunk the " + shipName + "!");
-        sinkSound.play();
-        currentGameShots++;
-        currentGameHits++;
-        break;
-    case Board::AttackResult::AlreadyTried:
         messageBox->addMessage("Already tried " + coordinateToString(target));
         return;
-    case Board::AttackResult::Invalid:
+    }
+    // Clicking a selected cell again takes it back out of the volley
+    auto selected = std::find(selectedShots.begin(), selectedShots.end(), target);
+    if (selected != selectedShots.end())
+    {
+        selectedShots.erase(selected);
         return;
     }
-
-    checkGameOver();
-    if (state != GameState::GameOver)
+    selectedShots.push_back(target);
+    if (static_cast<int>(selectedShots.size()) < shots)
     {
-        changeState(GameState::ComputerTurn);
+        return;
     }
+
+    const std::vector<Coordinate> volley = std::move(selectedShots);
+    selectedShots.clear();
+    firePlayerVolley(volley);
 }
 
-void GameGUI::executeComputerAttack()
+void GameGUI::firePlayerVolley(const std::vector<Coordinate> &targets)
 {
-    Coordinate target;
-    bool validTarget = false;
-    
-    // Smart AI for Medium and Hard difficulty
-    if (difficulty != Difficulty::Easy && !hitQueue.empty())
-    {
-        target = hitQueue.back();
-        hitQueue.pop_back();
-        validTarget = true;
-    }
-    else if (difficulty == Difficulty::Hard && huntingMode && lastHit.first != -1)
-    {
-        // Hard mode: Try adjacent cells to last hit
-        std::vector<Coordinate> adjacent = {
-            {lastHit.first - 1, lastHit.second},
-            {lastHit.first + 1, lastHit.second},
-            {lastHit.first, lastHit.second - 1},
-            {lastHit.first, lastHit.second + 1}
-        };
-        
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::shuffle(adjacent.begin(), adjacent.end(), gen);
-        
-        for (const auto& coord : adjacent)
+    computerBoard->attackBatch(targets, volleyResults);
+
+    bool fired = false;
+    for (std::size_t i = 0; i < targets.size(); ++i)
+    {
+        const Coordinate &target = targets[i];
+        switch (volleyResults[i].result)
         {
-            if (coord.first >= 0 && coord.first < 10 && coord.second >= 0 && coord.second < 10)
-            {
-                if (!playerBoard->isAttacked(coord))
-                {
-                    target = coord;
-                    validTarget = true;
-                    break;
-                }
-            }
+        case Board::AttackResult::Miss:
+            createMissEffect(computerBoardView->getCellCenter(target));
+            messageBox->addMessage("Miss at " + coordinateToString(target));
+            missSound.play();
+            currentGameShots++;
+            break;
+        case Board::AttackResult::Hit:
+            createHitEffect(computerBoardView->getCellCenter(target));
+            messageBox->addMessage("Hit at " + coordinateToString(target) + "!");
+            hitSound.play();
+            currentGameShots++;
+            currentGameHits++;
+            break;
+        case Board::AttackResult::Sunk:
+            createSinkEffect(computerBoardView->getCellCenter(target));
+            messageBox->addMessage("Sunk the " + computerBoard->getShips()[volleyResults[i].ship]->getName() + "!");
+            sinkSound.play();
+            currentGameShots++;
+            currentGameHits++;
+            break;
+        case Board::AttackResult::AlreadyTried:
+            messageBox->addMessage("Already tried " + coordinateToString(target));
+            continue;
+        case Board::AttackResult::Invalid:
+            continue;
         }
-    }
-    
-    // Random shot if no smart target
-    if (!validTarget)
-    {
-        while (!computerShots.empty())
+
+        fired = true;
+        recordShot(Shooter::Player, target);
+        if (network.isActive())
         {
-            target = computerShots.back();
-            computerShots.pop_back();
-            
-            if (!playerBoard->isAttacked(target))
-            {
-                validTarget = true;
-                break;
-            }
+            network.sendFire(target);
         }
     }
-    
-    if (!validTarget)
+
+    if (!fired)
     {
-        refillComputerShots();
         return;
     }
-
-    std::string shipName;
-    Board::AttackResult result = playerBoard->attack(target, shipName);
-
-    if (result == Board::AttackResult::Invalid || result == Board::AttackResult::AlreadyTried)
+    checkGameOver();
+    if (state != GameState::GameOver)
     {
-        return;
+        changeState(GameState::ComputerTurn);
     }
+}
+
+void GameGUI::executeComputerVolley(const std::vector<Coordinate> &targets)
+{
+    playerBoard->attackBatch(targets, volleyResults);
+    computerAI.recordVolley(targets, volleyResults, *playerBoard);
 
-    switch (result)
+    for (std::size_t i = 0; i < targets.size(); ++i)
     {
-    case Board::AttackResult::Miss:
-        createMissEffect(playerBoardView->getCellCenter(target));
-        messageBox->addMessage("Enemy misses at " + coordinateToString(target));
-        missSound.play();
-        huntingMode = false;
-        break;
-    case Board::AttackResult::Hit:
-        createHitEffect(playerBoardView->getCellCenter(target));
-        messageBox->addMessage("Enemy hits at " + coordinateToString(target) + "!");
-        hitSound.play();
-        
-        // Add adjacent cells to hit queue for smart targeting
-        if (difficulty != Difficulty::Easy)
+        const Coordinate &target = targets[i];
+        const Board::AttackResult result = volleyResults[i].result;
+        if (result == Board::AttackResult::Invalid || result == Board::AttackResult::AlreadyTried)
         {
-            lastHit = target;
-            huntingMode = true;
-            
-            std::vector<Coordinate> adjacent = {
-                {target.first - 1, target.second},
-                {target.first + 1, target.second},
-                {target.first, target.second - 1},
-                {target.first, target.second + 1}
-            };
-            
-            for (const auto& coord : adjacent)
-            {
-                if (coord.first >= 0 && coord.first < 10 && coord.second >= 0 && coord.second < 10)
-                {
-                    if (!playerBoard->isAttacked(coord))
-                    {
-                        hitQueue.push_back(coord);
-                    }
-                }
-            }
+            continue;
+        }
+
+        recordShot(Shooter::Computer, target);
+        switch (result)
+        {
+        case Board::AttackResult::Miss:
+            createMissEffect(playerBoardView->getCellCenter(target));
+            messageBox->addMessage("Enemy misses at " + coordinateToString(target));
+            missSound.play();
+            break;
+        case Board::AttackResult::Hit:
+            createHitEffect(playerBoardView->getCellCenter(target));
+            messageBox->addMessage("Enemy hits at " + coordinateToString(target) + "!");
+            hitSound.play();
+            break;
+        case Board::AttackResult::Sunk:
+            createSinkEffect(playerBoardView->getCellCenter(target));
+            messageBox->addMessage("Enemy sinks your " + playerBoard->getShips()[volleyResults[i].ship]->getName() +
+                                   "!");
+            sinkSound.play();
+            break;
+        default:
+            break;
         }
-        break;
-    case Board::AttackResult::Sunk:
-        createSinkEffect(playerBoardView->getCellCenter(target));
-        messageBox->addMessage("Enemy sinks your " + shipName + "!");
-        sinkSound.play();
-        hitQueue.clear();
-        huntingMode = false;
-        lastHit = {-1, -1};
-        break;
-    default:
-        break;
     }
 
     checkGameOver();
-    
-    if (computerShots.empty())
+}
+
+void GameGUI::cancelComputerMove()
+{
+    // The worker reads playerBoard, so it must finish before the board goes away
+    if (pendingMove.valid())
     {
-        refillComputerShots();
+        cancelMove = true;
+        pendingMove.wait();
+        pendingMove = std::future<ComputerAI::Volley>();
     }
+    waitingForAction = false;
 }
 
 void GameGUI::checkGameOver()
@@ -2027,8 +2549,7 @@ void GameGUI::createConfetti(const sf::Vector2f &position)
 
 void GameGUI::createParticle(const sf::Vector2f &position, ParticleType type)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    Xoshiro256 &gen = random.cosmetic();
     std::uniform_real_distribution<float> angleDist(0, 6.28318f);
     
     int count = 10;
@@ -2115,8 +2636,7 @@ void GameGUI::createParticle(const sf::Vector2f &position, ParticleType type)
 
 void GameGUI::createSinkEffect(const sf::Vector2f &position)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    Xoshiro256 &gen = random.cosmetic();
     std::uniform_real_distribution<float> angleDist(0, 6.28318f);
     std::uniform_real_distribution<float> speedDist(80, 200);
 
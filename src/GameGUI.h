@@ -1,12 +1,26 @@
 #pragma once
 
+#include "ComputerAI.h"
 #include "GameLogic.h"
+#include "Heatmaps.h"
+#include "LayoutPool.h"
+#include "NetworkManager.h"
+#include "OpeningBook.h"
+#include "PlacementSearch.h"
+#include "Random.h"
+#include "Replay.h"
+#include "SaveGame.h"
+#include "WorkStealingPool.h"
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 #include <array>
+#include <atomic>
+#include <deque>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -28,7 +42,7 @@ namespace Colors
     const sf::Color ButtonHover(41, 128, 185);  // Darker blue hover
 }
 
-// Game states
+// Game states. In a network game ComputerTurn is the remote player's turn.
 enum class GameState
 {
     Menu,
@@ -36,15 +50,8 @@ enum class GameState
     PlacingShips,
     PlayerTurn,
     ComputerTurn,
-    GameOver
-};
-
-// Difficulty levels
-enum class Difficulty
-{
-    Easy,
-    Medium,
-    Hard
+    GameOver,
+    Replay
 };
 
 // Particle types
@@ -140,10 +147,13 @@ struct PlacementState
 class GameGUI
 {
 public:
-    GameGUI();
+    explicit GameGUI(std::uint64_t sessionSeed = RandomService::freshSeed());
     ~GameGUI();
 
     void run();
+    bool startReplay(const std::string &path, int gameIndex, int speed, bool jumpToEnd);
+    // Hosts (address ignored) or joins a two-player game over TCP
+    bool startNetworkGame(bool host, const std::string &address, unsigned short port);
 
 private:
     // Window and rendering
@@ -174,6 +184,8 @@ private:
     GameState state;
     bool playerWon = false;
     Difficulty difficulty = Difficulty::Medium;
+    // Against the computer only; network games are always Classic
+    RuleSet rules = RuleSet::Classic;
     
     // Statistics
     struct GameStats {
@@ -190,10 +202,14 @@ private:
     int currentGameShots = 0;
     int currentGameHits = 0;
     
-    // Computer AI
-    std::vector<Coordinate> hitQueue; // For smart AI targeting
-    Coordinate lastHit{-1, -1};
-    bool huntingMode = false;
+    // Computer AI. The move (a one-shot volley under Classic rules) is
+    // computed on a worker thread as soon as ComputerTurn begins and applied
+    // once both it and actionDelay finish.
+    ComputerAI computerAI;
+    OpeningBook openingBook;
+    std::future<ComputerAI::Volley> pendingMove;
+    std::uint64_t lastSearchIterations = 0;
+    std::atomic<bool> cancelMove{false};
     
     // Game logic (from existing code)
     std::unique_ptr<Board> playerBoard;
@@ -252,6 +268,30 @@ private:
     void saveStats();
     void updateStatsOnGameEnd(bool won);
     
+    // Replays
+    ReplayWriter replayWriter{"replays.bin"};
+    RandomService random;
+    std::unique_ptr<ReplayPlayer> replayPlayer;
+    int replaySpeed = 1;
+    float replayAccumulator = 0.0f;
+    void finishReplayRecording(bool gameFinished);
+    void applyReplayEvent(const ReplayPlayer::Event &event);
+    void recordShot(Shooter shooter, const Coordinate &target);
+    
+    // Save game (autosaved at every turn change)
+    SnapshotWriter autosave{"savegame.bin", "autosave battle"};
+    std::vector<std::uint8_t> shotLog;
+    bool hasSavedBattle = false;
+    // Whether the current game writes the autosave; only such a game may
+    // delete it when it ends
+    bool savingBattle = false;
+    
+    // Aggregate heatmaps across all finished games
+    Heatmaps heatmaps;
+    SnapshotWriter heatmapWriter{"heatmaps.bin", "save heatmaps"};
+    void autosaveBattle();
+    bool resumeSavedBattle();
+    
     // State management
     void changeState(GameState newState);
     
@@ -262,11 +302,13 @@ private:
     void handlePlacementEvents(sf::Event &event);
     void handleBattleEvents(sf::Event &event);
     void handleGameOverEvents(sf::Event &event);
+    void handleReplayEvents(sf::Event &event);
     
     // Update logic
     void update(float deltaTime);
     void updateParticles(float deltaTime);
     void updateComputerTurn();
+    void updateReplay(float deltaTime);
     
     // Rendering
     void render();
@@ -275,6 +317,7 @@ private:
     void renderPlacement();
     void renderBattle();
     void renderGameOver();
+    void renderReplay();
     void renderWaterBackground();
     
     // Ship placement logic
@@ -287,13 +330,37 @@ private:
     void generateComputerPlacements();
     bool loadComputerPlacements();
     void saveComputerPlacements() const;
-    void executeComputerAttack();
-    void refillComputerShots();
-    std::vector<Coordinate> computerShots;
+    void executeComputerVolley(const std::vector<Coordinate> &targets);
+    void cancelComputerMove();
     std::string placementFile = "placement.txt";
+    LayoutPool layoutPool;
+    
+    // Adversarial placement runs while the player places their ships, so
+    // it is normally finished before the battle starts
+    PlacementMode placementMode = PlacementMode::Random;
+    WorkStealingPool searchPool;
+    std::future<PlacementSearchResult> placementSearch;
+    void startPlacementSearch();
+    
+    // Two-player network game. The peers swap fleet layouts once both are
+    // placed and then only exchange shots; each side applies them to its
+    // own copy of both boards.
+    NetworkManager network;
+    std::vector<NetworkManager::Event> networkEvents;
+    std::optional<FleetLayout> remoteLayout;
+    std::deque<Coordinate> remoteShots;
+    void pollNetwork();
+    void beginNetworkBattle();
+    void updateRemoteTurn();
     
-    // Battle logic
+    // Battle logic. Under Salvo rules clicks select the player's volley,
+    // which is fired once it has a shot per ship still afloat, or one per
+    // cell of target left when there are fewer.
+    std::vector<Coordinate> selectedShots;
+    std::vector<Board::ShotResult> volleyResults;
+    int volleySize(const Board &fleet, const Board &target) const;
     void playerAttack(const Coordinate &target);
+    void firePlayerVolley(const std::vector<Coordinate> &targets);
     void checkGameOver();
     
     // Visual effects
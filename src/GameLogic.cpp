@@ -23,6 +23,39 @@ static std::string colorizeSymbol(char symbol)
     }
 }
 
+const char *ruleSetName(RuleSet rules)
+{
+    switch (rules)
+    {
+    case RuleSet::Classic:
+        return "Classic";
+    case RuleSet::Salvo:
+        return "Salvo";
+    }
+    return "Unknown";
+}
+
+bool parseRuleSet(const std::string &name, RuleSet &rules)
+{
+    std::string lower;
+    for (char ch : name)
+    {
+        lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+    }
+
+    for (RuleSet candidate : {RuleSet::Classic, RuleSet::Salvo})
+    {
+        std::string candidateName = ruleSetName(candidate);
+        candidateName[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(candidateName[0])));
+        if (lower == candidateName)
+        {
+            rules = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
 // ============================================================================
 // Ship Implementation
 // ============================================================================
@@ -100,10 +133,15 @@ void Board::clear()
         for (auto &cell : row)
         {
             cell.ship = nullptr;
+            cell.shipIndex = -1;
             cell.attacked = false;
         }
     }
     ships.clear();
+    shipMasks.clear();
+    occupiedCells = CellMask();
+    attackedCells = CellMask();
+    hitCells = CellMask();
 }
 
 bool Board::placeShip(Ship &ship, const Coordinate &start, bool horizontal)
@@ -126,16 +164,24 @@ bool Board::placeShip(Ship &ship, const Coordinate &start, bool horizontal)
 
     ship.setPositions(prospective);
 
-    for (const auto &coord : prospective)
+    auto found = std::find(ships.begin(), ships.end(), &ship);
+    const auto index = static_cast<std::size_t>(found - ships.begin());
+    if (found == ships.end())
     {
-        Cell &cell = grid[coord.first][coord.second];
-        cell.ship = &ship;
+        ships.push_back(&ship);
+        shipMasks.emplace_back();
     }
 
-    if (std::find(ships.begin(), ships.end(), &ship) == ships.end())
+    CellMask mask;
+    for (const auto &coord : prospective)
     {
-        ships.push_back(&ship);
+        Cell &cell = grid[coord.first][coord.second];
+        cell.ship = &ship;
+        cell.shipIndex = static_cast<std::int8_t>(index);
+        mask.set(coord.first * SIZE + coord.second);
     }
+    shipMasks[index] = mask;
+    occupiedCells |= mask;
 
     return true;
 }
@@ -154,11 +200,15 @@ Board::AttackResult Board::attack(const Coordinate &target, std::string &shipNam
     }
 
     cell.attacked = true;
+    const int index = target.first * SIZE + target.second;
+    attackedCells.set(index);
 
     if (cell.ship == nullptr)
     {
+        Metrics::add(Counter::Misses);
         return AttackResult::Miss;
     }
+    hitCells.set(index);
 
     Ship *hitShip = cell.ship;
     hitShip->registerHit(target);
@@ -166,18 +216,113 @@ Board::AttackResult Board::attack(const Coordinate &target, std::string &shipNam
 
     if (hitShip->isSunk())
     {
+        Metrics::add(Counter::Sinks);
         return AttackResult::Sunk;
     }
 
+    Metrics::add(Counter::Hits);
     return AttackResult::Hit;
 }
 
+std::uint32_t Board::attackBatch(const std::vector<Coordinate> &targets, std::vector<ShotResult> &results)
+{
+    results.resize(targets.size());
+
+    // Validate each shot against the board and the volley so far, and
+    // apply it to the grid; the masks are updated once for the volley
+    CellMask volley;
+    CellMask hits;
+    std::uint64_t tally[3] = {0, 0, 0};
+    for (std::size_t i = 0; i < targets.size(); ++i)
+    {
+        ShotResult &shot = results[i];
+        shot = ShotResult();
+        if (!inBounds(targets[i]))
+        {
+            continue;
+        }
+        const int index = targets[i].first * SIZE + targets[i].second;
+        if (attackedCells.test(index) || volley.test(index))
+        {
+            shot.result = AttackResult::AlreadyTried;
+            continue;
+        }
+        volley.set(index);
+
+        Cell &cell = grid[targets[i].first][targets[i].second];
+        cell.attacked = true;
+        if (cell.ship == nullptr)
+        {
+            shot.result = AttackResult::Miss;
+            ++tally[0];
+            continue;
+        }
+        cell.ship->registerHit(targets[i]);
+        hits.set(index);
+        shot.result = AttackResult::Hit;
+        shot.ship = cell.shipIndex;
+        ++tally[1];
+    }
+    attackedCells |= volley;
+    hitCells |= hits;
+
+    // A ship is sunk by this volley when its new hits complete it; its last
+    // shot in the volley reports Sunk
+    std::uint32_t sunk = 0;
+    if (hits.any())
+    {
+        for (std::size_t ship = 0; ship < shipMasks.size(); ++ship)
+        {
+            if (shipMasks[ship].intersects(hits) && hitCells.contains(shipMasks[ship]))
+            {
+                sunk |= 1u << ship;
+            }
+        }
+    }
+    std::uint32_t unreported = sunk;
+    for (std::size_t i = targets.size(); unreported != 0 && i-- > 0;)
+    {
+        const int ship = results[i].ship;
+        if (results[i].result == AttackResult::Hit && ((unreported >> ship) & 1))
+        {
+            results[i].result = AttackResult::Sunk;
+            unreported &= ~(1u << ship);
+            --tally[1];
+            ++tally[2];
+        }
+    }
+
+    // At most one update per counter and volley, rather than one per shot
+    const Counter counters[3] = {Counter::Misses, Counter::Hits, Counter::Sinks};
+    for (int i = 0; i < 3; ++i)
+    {
+        if (tally[i] > 0)
+        {
+            Metrics::add(counters[i], tally[i]);
+        }
+    }
+    return sunk;
+}
+
 bool Board::allShipsSunk() const
 {
     return std::all_of(ships.begin(), ships.end(), [](const Ship *ship)
                        { return ship->isSunk(); });
 }
 
+int Board::countShipsAfloat() const
+{
+    int afloat = 0;
+    for (const CellMask &ship : shipMasks)
+    {
+        if (!hitCells.contains(ship))
+        {
+            ++afloat;
+        }
+    }
+    return afloat;
+}
+
 bool Board::inBounds(const Coordinate &coord) const
 {
     return coord.first >= 0 && coord.first < SIZE && coord.second >= 0 && coord.second < SIZE;
@@ -267,3 +412,155 @@ void Board::display(bool hideShips) const
         std::cout << "\n";
     }
 }
+
+// ============================================================================
+// Fleet helpers
+// ============================================================================
+
+void createStandardFleet(std::vector<std::unique_ptr<Ship>> &fleet)
+{
+    fleet.clear();
+    fleet.emplace_back(std::make_unique<AircraftCarrier>());
+    fleet.emplace_back(std::make_unique<Battleship>());
+    fleet.emplace_back(std::make_unique<Cruiser>());
+    fleet.emplace_back(std::make_unique<Submarine>());
+    fleet.emplace_back(std::make_unique<Destroyer>());
+}
+
+FleetLayout encodeFleetLayout(const std::vector<std::unique_ptr<Ship>> &fleet)
+{
+    FleetLayout layout{};
+    for (std::size_t i = 0; i < fleet.size() && i < layout.size(); ++i)
+    {
+        const auto &positions = fleet[i]->getPositions();
+        if (positions.empty())
+        {
+            continue;
+        }
+
+        bool horizontal = positions.size() < 2 || positions[0].first == positions[1].first;
+        int cell = positions.front().first * Board::SIZE + positions.front().second;
+        layout[i] = static_cast<std::uint8_t>(cell | (horizontal ? 0x80 : 0));
+    }
+    return layout;
+}
+
+int shotsPerTurn(RuleSet rules, const Board &fleet)
+{
+    return rules == RuleSet::Salvo ? fleet.countShipsAfloat() : 1;
+}
+
+bool applyFleetLayout(Board &board, std::vector<std::unique_ptr<Ship>> &fleet, const FleetLayout &layout)
+{
+    board.clear();
+    for (auto &ship : fleet)
+    {
+        ship->reset();
+    }
+
+    for (std::size_t i = 0; i < fleet.size() && i < layout.size(); ++i)
+    {
+        int cell = layout[i] & 0x7F;
+        bool horizontal = (layout[i] & 0x80) != 0;
+        Coordinate start{cell / Board::SIZE, cell % Board::SIZE};
+        if (!board.placeShip(*fleet[i], start, horizontal))
+        {
+            return false;
+        }
+    }
+    return fleet.size() == layout.size();
+}
+
+bool buildFleet(const FleetLayout &layout, FleetMasks &fleet)
+{
+    fleet = FleetMasks();
+    for (std::size_t i = 0; i < FLEET_SIZE; ++i)
+    {
+        const int cell = layout[i] & 0x7F;
+        const int size = STANDARD_SHIP_SIZES[i];
+        const bool horizontal = (layout[i] & 0x80) != 0;
+        const int row = cell / Board::SIZE;
+        const int col = cell % Board::SIZE;
+        if (row >= Board::SIZE || (horizontal ? col : row) + size > Board::SIZE)
+        {
+            return false;
+        }
+        fleet.ships[i] = placementMask(layout[i], size);
+        if (fleet.ships[i].intersects(fleet.occupied))
+        {
+            return false;
+        }
+        fleet.occupied |= fleet.ships[i];
+    }
+    fleet.layout = layout;
+    return true;
+}
+
+int FleetMasks::recordHit(int cell, const CellMask &hits)
+{
+    for (std::size_t i = 0; i < FLEET_SIZE; ++i)
+    {
+        if (!ships[i].test(cell))
+        {
+            continue;
+        }
+        if (!hits.contains(ships[i]))
+        {
+            return -1;
+        }
+        sunk = static_cast<std::uint8_t>(sunk | 1u << i);
+        return static_cast<int>(i);
+    }
+    return -1;
+}
+
+CellMask placementMask(std::uint8_t code, int shipSize)
+{
+    CellMask mask;
+    int cell = code & 0x7F;
+    int step = (code & 0x80) ? 1 : Board::SIZE;
+    for (int i = 0; i < shipSize; ++i)
+    {
+        mask.set(cell + i * step);
+    }
+    return mask;
+}
+
+CellMask fleetMask(const FleetLayout &layout)
+{
+    CellMask mask;
+    for (std::size_t i = 0; i < FLEET_SIZE; ++i)
+    {
+        mask |= placementMask(layout[i], STANDARD_SHIP_SIZES[i]);
+    }
+    return mask;
+}
+
+const std::vector<ShipPlacement> &shipPlacements(int shipSize)
+{
+    static const auto tables = []
+    {
+        std::array<std::vector<ShipPlacement>, Board::SIZE + 1> result;
+        for (int size = 1; size <= Board::SIZE; ++size)
+        {
+            for (int row = 0; row < Board::SIZE; ++row)
+            {
+                for (int col = 0; col < Board::SIZE; ++col)
+                {
+                    auto cell = static_cast<std::uint8_t>(row * Board::SIZE + col);
+                    if (col + size <= Board::SIZE)
+                    {
+                        auto code = static_cast<std::uint8_t>(cell | 0x80);
+                        result[size].push_back({code, placementMask(code, size)});
+                    }
+                    if (size > 1 && row + size <= Board::SIZE)
+                    {
+                        result[size].push_back({cell, placementMask(cell, size)});
+                    }
+                }
+            }
+        }
+        return result;
+    }();
+    return tables.at(static_cast<std::size_t>(shipSize));
+}
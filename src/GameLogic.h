@@ -1,8 +1,11 @@
 #pragma once
 
+#include "Metrics.h"
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <memory>
+#include <random>
 #include <string>
 #include <utility>
 #include <vector>
@@ -72,6 +75,51 @@ public:
     std::string getType() const override { return "Destroyer"; }
 };
 
+// Bitmask over the 100 board cells, bit index = row * Board::SIZE + col
+struct CellMask
+{
+    std::uint64_t words[2] = {0, 0};
+
+    void set(int cell) { words[cell >> 6] |= std::uint64_t{1} << (cell & 63); }
+    void reset(int cell) { words[cell >> 6] &= ~(std::uint64_t{1} << (cell & 63)); }
+    bool test(int cell) const { return (words[cell >> 6] >> (cell & 63)) & 1; }
+    bool any() const { return (words[0] | words[1]) != 0; }
+    bool intersects(const CellMask &other) const
+    {
+        return ((words[0] & other.words[0]) | (words[1] & other.words[1])) != 0;
+    }
+    int count() const { return __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]); }
+
+    CellMask &operator|=(const CellMask &other)
+    {
+        words[0] |= other.words[0];
+        words[1] |= other.words[1];
+        return *this;
+    }
+    bool operator==(const CellMask &other) const
+    {
+        return words[0] == other.words[0] && words[1] == other.words[1];
+    }
+    // Every cell of other is also set here
+    bool contains(const CellMask &other) const
+    {
+        return ((other.words[0] & ~words[0]) | (other.words[1] & ~words[1])) == 0;
+    }
+};
+
+// How many shots a side fires per turn
+enum class RuleSet
+{
+    // One shot per turn
+    Classic,
+    // One shot per ship the shooter still has afloat, fired as a volley
+    Salvo
+};
+
+const char *ruleSetName(RuleSet rules);
+// Case-insensitive inverse of ruleSetName()
+bool parseRuleSet(const std::string &name, RuleSet &rules);
+
 // Board class - manages the game grid
 class Board
 {
@@ -87,12 +135,27 @@ public:
         Sunk
     };
 
+    // One shot of a volley
+    struct ShotResult
+    {
+        AttackResult result = AttackResult::Invalid;
+        // Index into getShips() of the ship hit, otherwise -1
+        int ship = -1;
+    };
+
     Board();
 
     void clear();
     bool placeShip(Ship &ship, const Coordinate &start, bool horizontal);
     AttackResult attack(const Coordinate &target, std::string &shipName);
+    // Fires a whole volley at once; results[i] answers targets[i]. A target
+    // off the board is Invalid, one attacked before or earlier in the same
+    // volley is AlreadyTried, and neither changes anything. A ship sunk by
+    // the volley is reported Sunk on its last shot in the volley, Hit on
+    // the others. Returns the ships sunk as a bit mask over getShips().
+    std::uint32_t attackBatch(const std::vector<Coordinate> &targets, std::vector<ShotResult> &results);
     bool allShipsSunk() const;
+    int countShipsAfloat() const;
 
     void displayOwn() const;
     void displayFogged() const;
@@ -103,17 +166,105 @@ public:
     bool hasShipAt(const Coordinate &coord) const;
     char getCellSymbol(const Coordinate &coord, bool showShips) const;
     const std::vector<Ship *> &getShips() const { return ships; }
+    const CellMask &getAttackedCells() const { return attackedCells; }
+    const CellMask &getHitCells() const { return hitCells; }
 
 private:
     struct Cell
     {
         Ship *ship = nullptr;
+        // Index of ship in ships
+        std::int8_t shipIndex = -1;
         bool attacked = false;
     };
 
     std::array<std::array<Cell, SIZE>, SIZE> grid{};
     std::vector<Ship *> ships;
+    // Cells of each ship, parallel to ships
+    std::vector<CellMask> shipMasks;
+    CellMask occupiedCells;
+    CellMask attackedCells;
+    CellMask hitCells;
 
     bool inBounds(const Coordinate &coord) const;
     void display(bool hideShips) const;
 };
+
+// ============================================================================
+// Fleet helpers
+// ============================================================================
+
+// Number of ships in the standard fleet built by createStandardFleet
+constexpr std::size_t FLEET_SIZE = 5;
+constexpr std::array<int, FLEET_SIZE> STANDARD_SHIP_SIZES = {5, 4, 3, 3, 2};
+
+// Compact fleet layout: one byte per ship in createStandardFleet order.
+// Low 7 bits hold the start cell (row * Board::SIZE + col), the high bit is
+// set for horizontal ships.
+using FleetLayout = std::array<std::uint8_t, FLEET_SIZE>;
+
+void createStandardFleet(std::vector<std::unique_ptr<Ship>> &fleet);
+// Shots the owner of fleet fires this turn under rules
+int shotsPerTurn(RuleSet rules, const Board &fleet);
+FleetLayout encodeFleetLayout(const std::vector<std::unique_ptr<Ship>> &fleet);
+bool applyFleetLayout(Board &board, std::vector<std::unique_ptr<Ship>> &fleet, const FleetLayout &layout);
+
+// Every in-bounds placement of a ship of the given length, as FleetLayout
+// codes with their cell masks. Tables are built once and shared.
+struct ShipPlacement
+{
+    std::uint8_t code;
+    CellMask mask;
+};
+const std::vector<ShipPlacement> &shipPlacements(int shipSize);
+
+CellMask placementMask(std::uint8_t code, int shipSize);
+CellMask fleetMask(const FleetLayout &layout);
+
+// A standard fleet as cell masks, for engines that keep no Board or Ships
+// (Match, Battle)
+struct FleetMasks
+{
+    FleetLayout layout{};
+    CellMask ships[FLEET_SIZE];
+    CellMask occupied;
+    // One bit per ship, in createStandardFleet order
+    std::uint8_t sunk = 0;
+
+    bool allSunk() const { return sunk == (1u << FLEET_SIZE) - 1; }
+    // Marks the ship on cell sunk once hits, every hit on this fleet so far
+    // including cell, cover it. Returns that ship's index, otherwise -1.
+    int recordHit(int cell, const CellMask &hits);
+};
+
+// Decodes layout into fleet; false when a ship leaves the board or
+// overlaps another, and fleet is then unspecified
+bool buildFleet(const FleetLayout &layout, FleetMasks &fleet);
+
+// Uniformly random valid layout of the standard fleet: every ship picks one
+// of its placements uniformly and the whole layout is rejected on overlap,
+// which makes every valid layout equally likely.
+template <typename Rng>
+FleetLayout randomFleetLayout(Rng &rng)
+{
+    ScopedTimer timer(Timer::Placement);
+    while (true)
+    {
+        FleetLayout layout{};
+        CellMask occupied;
+        bool valid = true;
+        for (std::size_t i = 0; i < FLEET_SIZE && valid; ++i)
+        {
+            const auto &options = shipPlacements(STANDARD_SHIP_SIZES[i]);
+            std::uniform_int_distribution<std::size_t> pick(0, options.size() - 1);
+            const ShipPlacement &placement = options[pick(rng)];
+            valid = !occupied.intersects(placement.mask);
+            occupied |= placement.mask;
+            layout[i] = placement.code;
+        }
+        if (valid)
+        {
+            return layout;
+        }
+    }
+}
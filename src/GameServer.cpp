@@ -0,0 +1,184 @@
+#include "GameServer.h"
+#include <iostream>
+#include <thread>
+
+// ============================================================================
+// GameServer Implementation
+// ============================================================================
+
+GameServer::GameServer(Options options)
+    : options(std::move(options))
+{
+}
+
+GameServer::~GameServer() = default;
+
+bool GameServer::start()
+{
+    if (options.backend == Backend::Uring && !IoUring::isSupported())
+    {
+        std::cerr << "io_uring with multishot recv is unavailable (needs Linux 6.0+); using epoll" << std::endl;
+        options.backend = Backend::Epoll;
+    }
+
+    const unsigned count = options.threads > 0 ? options.threads : 1;
+    if (!options.logDirectory.empty())
+    {
+        for (unsigned i = 0; i < count; ++i)
+        {
+            logs.push_back(std::make_unique<MatchLog>(options.logDirectory, i, count, options.checkpointBytes));
+            if (!logs.back()->open())
+            {
+                return false;
+            }
+        }
+    }
+    for (unsigned i = 0; i < count; ++i)
+    {
+        shards.push_back(std::make_unique<ServerShard>(*this, i));
+        if (!shards.back()->start(options.host, options.port, options.backlog))
+        {
+            return false;
+        }
+    }
+
+    // Every shard must exist first: match ids depend on the shard count
+    const auto recoveryStart = std::chrono::steady_clock::now();
+    for (auto &shard : shards)
+    {
+        std::size_t restored = 0;
+        if (!shard->recover(restored))
+        {
+            return false;
+        }
+        recoveredMatches += restored;
+    }
+    // The fresh checkpoints go down now, compacting what was replayed
+    for (auto &log : logs)
+    {
+        log->commit();
+    }
+    recoveryTime = std::chrono::steady_clock::now() - recoveryStart;
+    return true;
+}
+
+void GameServer::run()
+{
+    if (!logs.empty())
+    {
+        // Polls rather than waits on a condition variable, since stop()
+        // runs in a signal handler
+        committer = std::thread(
+            [this]
+            {
+                while (!stopping.load(std::memory_order_acquire))
+                {
+                    std::this_thread::sleep_for(options.commitInterval);
+                    for (auto &log : logs)
+                    {
+                        log->commit();
+                    }
+                }
+            });
+    }
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < shards.size(); ++i)
+    {
+        threads.emplace_back([this, i] { shards[i]->run(); });
+    }
+    shards[0]->run();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    if (committer.joinable())
+    {
+        committer.join();
+    }
+    // Whatever the shards handed over after the committer's last pass
+    for (auto &log : logs)
+    {
+        log->commit();
+    }
+}
+
+void GameServer::stop()
+{
+    stopping.store(true, std::memory_order_release);
+    for (auto &shard : shards)
+    {
+        shard->wake();
+    }
+}
+
+GameServer::Stats GameServer::getStats() const
+{
+    Stats total;
+    for (const auto &shard : shards)
+    {
+        total += shard->getStats();
+    }
+    return total;
+}
+
+MatchLog::Stats GameServer::getLogStats() const
+{
+    MatchLog::Stats total;
+    for (const auto &log : logs)
+    {
+        total += log->getStats();
+    }
+    return total;
+}
+
+std::size_t GameServer::getConnectionCount() const
+{
+    std::size_t total = 0;
+    for (const auto &shard : shards)
+    {
+        total += shard->getConnectionCount();
+    }
+    return total;
+}
+
+std::size_t GameServer::getMatchCount() const
+{
+    std::size_t total = 0;
+    for (const auto &shard : shards)
+    {
+        total += shard->getMatchCount();
+    }
+    return total;
+}
+
+std::size_t GameServer::getSpectatorCount() const
+{
+    std::size_t total = 0;
+    for (const auto &shard : shards)
+    {
+        total += shard->getSpectatorCount();
+    }
+    return total;
+}
+
+bool GameServer::pairOrWait(const Seat &seat, Seat &partner)
+{
+    std::lock_guard<std::mutex> lock(lobbyMutex);
+    if (!waiting)
+    {
+        waiting = seat;
+        return false;
+    }
+    partner = *waiting;
+    waiting.reset();
+    return true;
+}
+
+void GameServer::leaveLobby(const Seat &seat)
+{
+    std::lock_guard<std::mutex> lock(lobbyMutex);
+    if (waiting && waiting->shard == seat.shard && waiting->fd == seat.fd && waiting->generation == seat.generation)
+    {
+        waiting.reset();
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "ServerShard.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Headless match server for the protocol in Protocol.h. Runs one
+// ServerShard per thread, each with its own event loop (epoll or
+// io_uring), listening socket, connections and matches. The only state
+// the shards share is the lobby, touched once per Join.
+//
+// With a log directory, each shard keeps a MatchLog there and a committer
+// thread syncs them all every commit interval. start() replays the logs,
+// so matches in progress survive a restart.
+//
+// Linux only.
+class GameServer
+{
+public:
+    enum class Backend
+    {
+        Epoll,
+        // Falls back to Epoll where the kernel lacks what it needs
+        Uring
+    };
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::uint16_t port = 7777;
+        int backlog = 1024;
+        // Event loop threads; one per core is the intended setting
+        unsigned threads = 1;
+        // Time a player has to place its fleet or fire before forfeiting;
+        // zero waits forever
+        std::chrono::seconds turnTimeout{60};
+        // Time a player who lost its connection has to Rejoin before
+        // forfeiting; zero forfeits at once
+        std::chrono::seconds rejoinGrace{30};
+        // Frames a client may send per second, and at once, before its
+        // frames wait for the budget to refill; a zero rate is unlimited
+        double messageRate = 1000;
+        double messageBurst = 100;
+        // Matches per shard still waiting for fleets; Join is refused with
+        // Overloaded beyond it
+        std::size_t maxPendingMatches = 1024;
+        // Join is refused with Overloaded while a shard's event loop falls
+        // further behind than this; zero never refuses
+        std::chrono::milliseconds latencySlo{50};
+        // Where each shard logs its matches; empty keeps no log
+        std::string logDirectory;
+        // How often the log is synced, the most play a crash can lose
+        std::chrono::milliseconds commitInterval{5};
+        // Event bytes a shard logs between checkpoints of its live matches
+        std::size_t checkpointBytes = 4 * 1024 * 1024;
+        Backend backend = Backend::Epoll;
+    };
+
+    using Stats = ServerStats;
+
+    explicit GameServer(Options options);
+    ~GameServer();
+
+    GameServer(const GameServer &) = delete;
+    GameServer &operator=(const GameServer &) = delete;
+
+    // Binds every shard's listening socket and recovers the matches in the
+    // log; false (with a message on stderr) on failure
+    bool start();
+    // Serves until stop() is called. Shard 0 runs on the calling thread.
+    void run();
+    // Safe to call from a signal handler
+    void stop();
+
+    // Sums over the shards; call once run() has returned
+    Stats getStats() const;
+    std::size_t getShardCount() const { return shards.size(); }
+    // The backend in use, after any fallback
+    Backend getBackend() const { return options.backend; }
+    std::size_t getConnectionCount() const;
+    std::size_t getMatchCount() const;
+    std::size_t getSpectatorCount() const;
+    // Matches start() recovered from the log, and the time it took
+    std::size_t getRecoveredMatches() const { return recoveredMatches; }
+    std::chrono::steady_clock::duration getRecoveryTime() const { return recoveryTime; }
+    // Sums over the shards' logs; call once run() has returned
+    MatchLog::Stats getLogStats() const;
+
+private:
+    friend class ServerShard;
+
+    // A connection waiting in the lobby
+    struct Seat
+    {
+        std::size_t shard = 0;
+        int fd = -1;
+        std::uint32_t generation = 0;
+    };
+
+    Options options;
+    // Declared before the shards, which point into them
+    std::vector<std::unique_ptr<MatchLog>> logs;
+    std::vector<std::unique_ptr<ServerShard>> shards;
+    std::thread committer;
+    std::size_t recoveredMatches = 0;
+    std::chrono::steady_clock::duration recoveryTime{};
+    std::atomic<bool> stopping{false};
+
+    std::mutex lobbyMutex;
+    std::optional<Seat> waiting;
+
+    // Takes the waiting seat into partner and returns true, or leaves seat
+    // waiting and returns false
+    bool pairOrWait(const Seat &seat, Seat &partner);
+    void leaveLobby(const Seat &seat);
+    // Match ids encode their shard; see ServerShard::matchIdOf
+    std::size_t ownerOf(std::uint32_t matchId) const { return (matchId - 1) % shards.size(); }
+};
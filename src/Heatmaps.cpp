@@ -0,0 +1,141 @@
+#include "Heatmaps.h"
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+constexpr std::uint8_t MAGIC[3] = {'F', 'C', 'H'};
+
+void putU32(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+std::uint32_t getU32(const std::uint8_t *data)
+{
+    return static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8) |
+           (static_cast<std::uint32_t>(data[2]) << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+}
+}
+
+const char *heatmapName(HeatmapKind kind)
+{
+    switch (kind)
+    {
+    case HeatmapKind::CarrierPlacement:
+        return "carrier";
+    case HeatmapKind::BattleshipPlacement:
+        return "battleship";
+    case HeatmapKind::CruiserPlacement:
+        return "cruiser";
+    case HeatmapKind::SubmarinePlacement:
+        return "submarine";
+    case HeatmapKind::DestroyerPlacement:
+        return "destroyer";
+    case HeatmapKind::PlayerFirstShot:
+        return "first-shot";
+    case HeatmapKind::PlayerShots:
+        return "player-shots";
+    case HeatmapKind::ComputerShots:
+        return "ai-shots";
+    case HeatmapKind::ComputerMisses:
+        return "ai-misses";
+    case HeatmapKind::Count:
+        break;
+    }
+    return "unknown";
+}
+
+void Heatmaps::addGame(const ReplayRecord &record)
+{
+    ++games;
+
+    for (std::size_t ship = 0; ship < FLEET_SIZE; ++ship)
+    {
+        CellMask mask = placementMask(record.playerLayout[ship], STANDARD_SHIP_SIZES[ship]);
+        for (std::size_t cell = 0; cell < CELLS; ++cell)
+        {
+            maps[ship][cell] += mask.test(static_cast<int>(cell));
+        }
+    }
+
+    const CellMask playerShips = fleetMask(record.playerLayout);
+    bool firstShot = true;
+    for (std::uint8_t shot : record.shots)
+    {
+        const std::size_t cell = shot & 0x7F;
+        if (cell >= CELLS)
+        {
+            continue;
+        }
+
+        if (decodeShooter(shot) == Shooter::Player)
+        {
+            if (firstShot)
+            {
+                ++maps[static_cast<std::size_t>(HeatmapKind::PlayerFirstShot)][cell];
+                firstShot = false;
+            }
+            ++maps[static_cast<std::size_t>(HeatmapKind::PlayerShots)][cell];
+        }
+        else
+        {
+            ++maps[static_cast<std::size_t>(HeatmapKind::ComputerShots)][cell];
+            if (!playerShips.test(static_cast<int>(cell)))
+            {
+                ++maps[static_cast<std::size_t>(HeatmapKind::ComputerMisses)][cell];
+            }
+        }
+    }
+}
+
+std::vector<std::uint8_t> serializeHeatmaps(const Heatmaps &heatmaps)
+{
+    std::vector<std::uint8_t> out;
+    out.reserve(Heatmaps::FILE_SIZE);
+    out.insert(out.end(), std::begin(MAGIC), std::end(MAGIC));
+    out.push_back(Heatmaps::VERSION);
+    putU32(out, heatmaps.games);
+    for (const auto &map : heatmaps.maps)
+    {
+        for (std::uint32_t count : map)
+        {
+            putU32(out, count);
+        }
+    }
+    return out;
+}
+
+bool loadHeatmaps(const std::string &path, Heatmaps &heatmaps)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+    {
+        return false;
+    }
+
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (data.size() != Heatmaps::FILE_SIZE || data[0] != MAGIC[0] || data[1] != MAGIC[1] || data[2] != MAGIC[2] ||
+        data[3] != Heatmaps::VERSION)
+    {
+        return false;
+    }
+
+    Heatmaps result;
+    result.games = getU32(data.data() + 4);
+    const std::uint8_t *cursor = data.data() + 8;
+    for (auto &map : result.maps)
+    {
+        for (auto &count : map)
+        {
+            count = getU32(cursor);
+            cursor += 4;
+        }
+    }
+
+    heatmaps = result;
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "GameLogic.h"
+#include "Replay.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-cell aggregates across every game ever played, kept in a small
+// fixed-size file (heatmaps.bin) that is updated once per finished game:
+//   magic 'F' 'C' 'H' <version>, u32 games, then HEATMAP_COUNT maps of
+//   100 u32 counters each (little-endian). 3608 bytes in total.
+enum class HeatmapKind
+{
+    CarrierPlacement,
+    BattleshipPlacement,
+    CruiserPlacement,
+    SubmarinePlacement,
+    DestroyerPlacement,
+    PlayerFirstShot,
+    PlayerShots,
+    ComputerShots,
+    ComputerMisses,
+    Count
+};
+
+constexpr std::size_t HEATMAP_COUNT = static_cast<std::size_t>(HeatmapKind::Count);
+
+const char *heatmapName(HeatmapKind kind);
+
+struct Heatmaps
+{
+    static constexpr std::uint8_t VERSION = 1;
+    static constexpr std::size_t CELLS = Board::SIZE * Board::SIZE;
+    static constexpr std::size_t FILE_SIZE = 8 + HEATMAP_COUNT * CELLS * 4;
+
+    std::uint32_t games = 0;
+    std::array<std::array<std::uint32_t, CELLS>, HEATMAP_COUNT> maps{};
+
+    // Folds one game in. Player placements, the player's first shot and the
+    // computer's wasted shots are all derived from the replay record.
+    void addGame(const ReplayRecord &record);
+
+    const std::array<std::uint32_t, CELLS> &get(HeatmapKind kind) const
+    {
+        return maps[static_cast<std::size_t>(kind)];
+    }
+};
+
+std::vector<std::uint8_t> serializeHeatmaps(const Heatmaps &heatmaps);
+bool loadHeatmaps(const std::string &path, Heatmaps &heatmaps);
@@ -0,0 +1,245 @@
+#include "IoUring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+int setupRing(unsigned entries, io_uring_params &params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int registerWithRing(int ringFd, unsigned opcode, const void *argument, unsigned count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ringFd, opcode, argument, count));
+}
+}
+
+// ============================================================================
+// IoUring Implementation
+// ============================================================================
+
+IoUring::~IoUring()
+{
+    // Closing the ring cancels whatever is still in flight
+    if (ringFd >= 0)
+    {
+        close(ringFd);
+    }
+    if (bufferRing)
+    {
+        munmap(bufferRing, bufferRingSize);
+    }
+    if (submissions)
+    {
+        munmap(submissions, submissionsSize);
+    }
+    if (rings)
+    {
+        munmap(rings, ringsSize);
+    }
+}
+
+bool IoUring::isSupported()
+{
+    IoUring ring;
+    if (!ring.setup(4, 2, 64) || !ring.enable())
+    {
+        return false;
+    }
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+    {
+        return false;
+    }
+    io_uring_sqe *sqe = ring.getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sockets[0];
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = BUFFER_GROUP;
+    const char byte = 0;
+    bool supported = write(sockets[1], &byte, 1) == 1 && ring.submitAndWait(1000);
+    if (supported)
+    {
+        // Kernels without multishot recv reject it with -EINVAL
+        bool delivered = false;
+        ring.forEachCompletion([&delivered](const io_uring_cqe &cqe)
+                               { delivered = delivered || (cqe.res == 1 && (cqe.flags & IORING_CQE_F_MORE)); });
+        supported = delivered;
+    }
+    close(sockets[0]);
+    close(sockets[1]);
+    return supported;
+}
+
+bool IoUring::open(unsigned entries, unsigned bufferCount, unsigned bufferSize)
+{
+    if (!setup(entries, bufferCount, bufferSize))
+    {
+        std::cerr << "io_uring: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IoUring::setup(unsigned entries, unsigned bufferCount, unsigned size)
+{
+    // Completions are reaped once per loop, so leave them room to pile up.
+    // Task work runs only when the loop asks for completions, on its own
+    // thread (Linux 6.1+); older kernels get an ordinary ring.
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED | IORING_SETUP_SUBMIT_ALL |
+                   IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = entries * 4;
+    ringFd = setupRing(entries, params);
+    if (ringFd < 0 && errno == EINVAL)
+    {
+        params = io_uring_params{};
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_R_DISABLED;
+        params.cq_entries = entries * 4;
+        ringFd = setupRing(entries, params);
+    }
+    if (ringFd < 0)
+    {
+        return false;
+    }
+    const unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & required) != required)
+    {
+        errno = ENOSYS;
+        return false;
+    }
+
+    ringsSize = std::max<std::size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void *mapped = mmap(nullptr, ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                        IORING_OFF_SQ_RING);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    rings = mapped;
+    submissionsSize = params.sq_entries * sizeof(io_uring_sqe);
+    mapped = mmap(nullptr, submissionsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                  IORING_OFF_SQES);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    submissions = static_cast<io_uring_sqe *>(mapped);
+
+    auto *base = static_cast<std::uint8_t *>(rings);
+    submissionHead = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+    submissionTail = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+    submissionMask = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    submissionEntries = params.sq_entries;
+    queuedTail = *submissionTail;
+    // Entries are always used in ring order, so the indirection array maps
+    // each slot to itself
+    unsigned *array = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    for (unsigned i = 0; i < submissionEntries; ++i)
+    {
+        array[i] = i;
+    }
+    completionHead = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+    completionTail = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+    completionMask = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    completions = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+
+    // The buffer ring must be page aligned, which mmap guarantees
+    bufferRingSize = bufferCount * sizeof(io_uring_buf);
+    mapped = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    // Indexed as a plain array: in C++ the header's flexible array member
+    // sits after an empty struct of size one, eight bytes too far in
+    bufferRing = static_cast<io_uring_buf *>(mapped);
+    io_uring_buf_reg registration{};
+    registration.ring_addr = reinterpret_cast<std::uint64_t>(bufferRing);
+    registration.ring_entries = bufferCount;
+    registration.bgid = BUFFER_GROUP;
+    if (registerWithRing(ringFd, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+    {
+        return false;
+    }
+    bufferMask = bufferCount - 1;
+    bufferSize = size;
+    buffers.resize(static_cast<std::size_t>(bufferCount) * size);
+    for (unsigned id = 0; id < bufferCount; ++id)
+    {
+        recycleBuffer(id);
+    }
+    return true;
+}
+
+bool IoUring::enable()
+{
+    return registerWithRing(ringFd, IORING_REGISTER_ENABLE_RINGS, nullptr, 0) == 0;
+}
+
+io_uring_sqe *IoUring::getSqe()
+{
+    if (queuedTail - std::atomic_ref<unsigned>(*submissionHead).load(std::memory_order_acquire) ==
+            submissionEntries &&
+        enter(0, 0, nullptr, 0) < 0)
+    {
+        return nullptr;
+    }
+    io_uring_sqe *sqe = &submissions[queuedTail & submissionMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++queuedTail;
+    return sqe;
+}
+
+bool IoUring::submitAndWait(int timeoutMillis)
+{
+    int result;
+    if (timeoutMillis > 0)
+    {
+        __kernel_timespec timeout{};
+        timeout.tv_sec = timeoutMillis / 1000;
+        timeout.tv_nsec = static_cast<long long>(timeoutMillis % 1000) * 1000000;
+        io_uring_getevents_arg argument{};
+        argument.ts = reinterpret_cast<std::uint64_t>(&timeout);
+        result = enter(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &argument, sizeof(argument));
+    }
+    else
+    {
+        // Even without waiting, GETEVENTS runs the deferred completion work
+        result = enter(timeoutMillis < 0 ? 1 : 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+    return result >= 0 || errno == EINTR || errno == ETIME;
+}
+
+void IoUring::recycleBuffer(unsigned id)
+{
+    io_uring_buf &entry = bufferRing[bufferTail & bufferMask];
+    entry.addr = reinterpret_cast<std::uint64_t>(buffer(id));
+    entry.len = bufferSize;
+    entry.bid = static_cast<std::uint16_t>(id);
+    ++bufferTail;
+    // The tail overlays the reserved field of the first entry
+    std::atomic_ref<std::uint16_t>(bufferRing[0].resv).store(bufferTail, std::memory_order_release);
+}
+
+int IoUring::enter(unsigned minComplete, unsigned flags, const void *argument, std::size_t size)
+{
+    // Everything the kernel has not consumed, including entries left by a
+    // call that was interrupted
+    const unsigned toSubmit = queuedTail - std::atomic_ref<unsigned>(*submissionHead).load(std::memory_order_acquire);
+    std::atomic_ref<unsigned>(*submissionTail).store(queuedTail, std::memory_order_release);
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, argument, size));
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+// One io_uring instance driven through the raw system calls, so the server
+// needs no liburing. Owns the submission and completion queues and a ring
+// of provided receive buffers: recvs submitted with IOSQE_BUFFER_SELECT in
+// BUFFER_GROUP get a buffer picked by the kernel when data arrives, so an
+// idle connection pins no receive memory.
+//
+// Single-threaded: after enable(), only the enabling thread may submit.
+// Linux only.
+class IoUring
+{
+public:
+    static constexpr std::uint16_t BUFFER_GROUP = 0;
+
+    IoUring() = default;
+    ~IoUring();
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    // Whether the kernel runs everything the server submits: multishot
+    // accept and multishot recv from provided buffers (Linux 6.0+)
+    static bool isSupported();
+
+    // Creates the ring with room for entries submissions and registers
+    // bufferCount receive buffers (a power of two) of bufferSize bytes.
+    // The ring starts disabled; false (with a message on stderr) on failure.
+    bool open(unsigned entries, unsigned bufferCount, unsigned bufferSize);
+    // Enables the ring for the calling thread, which becomes its only
+    // submitter
+    bool enable();
+
+    // A zeroed submission entry; submits what is queued first if the
+    // queue is full
+    io_uring_sqe *getSqe();
+    // Submits everything queued and waits for at least one completion, up
+    // to timeoutMillis (-1 waits forever, 0 does not wait). False on
+    // failure other than an interrupt or the time running out.
+    bool submitAndWait(int timeoutMillis);
+
+    // Calls handler(const io_uring_cqe &) for each completion ready. The
+    // handler may queue submissions.
+    template <typename Handler>
+    void forEachCompletion(Handler &&handler)
+    {
+        unsigned head = *completionHead;
+        const unsigned tail = std::atomic_ref<unsigned>(*completionTail).load(std::memory_order_acquire);
+        while (head != tail)
+        {
+            handler(completions[head & completionMask]);
+            ++head;
+            std::atomic_ref<unsigned>(*completionHead).store(head, std::memory_order_release);
+        }
+    }
+
+    std::uint8_t *buffer(unsigned id) { return buffers.data() + static_cast<std::size_t>(id) * bufferSize; }
+    unsigned getBufferSize() const { return bufferSize; }
+    // Hands a receive buffer back to the kernel
+    void recycleBuffer(unsigned id);
+
+private:
+    int ringFd = -1;
+    // Both queues share one mapping (IORING_FEAT_SINGLE_MMAP)
+    void *rings = nullptr;
+    std::size_t ringsSize = 0;
+    io_uring_sqe *submissions = nullptr;
+    std::size_t submissionsSize = 0;
+
+    // Ring indices shared with the kernel
+    unsigned *submissionHead = nullptr;
+    unsigned *submissionTail = nullptr;
+    unsigned submissionMask = 0;
+    unsigned submissionEntries = 0;
+    // Entries queued here and not yet published to the kernel
+    unsigned queuedTail = 0;
+
+    unsigned *completionHead = nullptr;
+    unsigned *completionTail = nullptr;
+    unsigned completionMask = 0;
+    io_uring_cqe *completions = nullptr;
+
+    io_uring_buf *bufferRing = nullptr;
+    std::size_t bufferRingSize = 0;
+    unsigned bufferMask = 0;
+    std::uint16_t bufferTail = 0;
+    unsigned bufferSize = 0;
+    std::vector<std::uint8_t> buffers;
+
+    // open() without the messages, for probing
+    bool setup(unsigned entries, unsigned bufferCount, unsigned bufferSize);
+    int enter(unsigned minComplete, unsigned flags, const void *argument, std::size_t size);
+};
@@ -0,0 +1,97 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+// ============================================================================
+// LatencyHistogram Implementation
+// ============================================================================
+
+LatencyHistogram::LatencyHistogram()
+    : counts(BUCKET_COUNT, 0)
+{
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t value)
+{
+    if (value < SUB_BUCKETS)
+    {
+        return static_cast<std::size_t>(value);
+    }
+    // Keep the top SUB_BUCKET_BITS - 1 bits below the leading one
+    const int highest = 63 - __builtin_clzll(value);
+    const int shift = highest - (SUB_BUCKET_BITS - 1);
+    const std::size_t mantissa = static_cast<std::size_t>(value >> shift);
+    return SUB_BUCKETS + static_cast<std::size_t>(shift - 1) * HALF_BUCKETS + (mantissa - HALF_BUCKETS);
+}
+
+std::uint64_t LatencyHistogram::bucketLimit(std::size_t index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+    const int shift = static_cast<int>((index - SUB_BUCKETS) / HALF_BUCKETS) + 1;
+    const std::uint64_t mantissa = (index - SUB_BUCKETS) % HALF_BUCKETS + HALF_BUCKETS;
+    // Wraps to UINT64_MAX for the very last bucket
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t value)
+{
+    ++counts[bucketIndex(value)];
+    ++count;
+    total += value;
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.count == 0)
+    {
+        return;
+    }
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    total += other.total;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+void LatencyHistogram::clear()
+{
+    if (count == 0)
+    {
+        return;
+    }
+    std::fill(counts.begin(), counts.end(), 0);
+    count = 0;
+    total = 0;
+    minimum = UINT64_MAX;
+    maximum = 0;
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    const double clamped = std::min(1.0, std::max(0.0, fraction));
+    const std::uint64_t rank =
+        std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped * static_cast<double>(count))));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return std::min(bucketLimit(i), maximum);
+        }
+    }
+    return maximum;
+}
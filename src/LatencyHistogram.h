@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Log-linear histogram in the style of HdrHistogram. Values below 128 get a
+// bucket each; above that, each power of two is split into 64 buckets, so
+// every percentile is reported within 1/64 (about 1.6%) of the true value
+// at any magnitude. Recording is a bit scan and an increment, and memory
+// is fixed at about 30 KB.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(std::uint64_t value);
+    void merge(const LatencyHistogram &other);
+    void clear();
+
+    std::uint64_t getCount() const { return count; }
+    std::uint64_t getMax() const { return maximum; }
+    std::uint64_t getMin() const { return count ? minimum : 0; }
+    double getMean() const { return count ? static_cast<double>(total) / static_cast<double>(count) : 0.0; }
+
+    // Highest value in the bucket holding the given fraction (0..1) of
+    // recorded values; 0 when empty
+    std::uint64_t percentile(double fraction) const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 7;
+    static constexpr std::size_t SUB_BUCKETS = std::size_t{1} << SUB_BUCKET_BITS;
+    static constexpr std::size_t HALF_BUCKETS = SUB_BUCKETS / 2;
+    static constexpr std::size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * HALF_BUCKETS;
+
+    static std::size_t bucketIndex(std::uint64_t value);
+    static std::uint64_t bucketLimit(std::size_t index);
+
+    std::vector<std::uint64_t> counts;
+    std::uint64_t count = 0;
+    std::uint64_t total = 0;
+    std::uint64_t minimum = UINT64_MAX;
+    std::uint64_t maximum = 0;
+};
@@ -0,0 +1,140 @@
+#include "LayoutPool.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr std::uint8_t MAGIC[3] = {'F', 'C', 'L'};
+}
+
+LayoutPool::~LayoutPool()
+{
+    close();
+}
+
+void LayoutPool::writeHeader(std::uint8_t *header, std::uint64_t entryCount)
+{
+    std::memset(header, 0, HEADER_SIZE);
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    header[3] = VERSION;
+    for (int i = 0; i < 4; ++i)
+    {
+        header[4 + i] = static_cast<std::uint8_t>(ENTRY_SIZE >> (8 * i));
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        header[8 + i] = static_cast<std::uint8_t>(entryCount >> (8 * i));
+    }
+}
+
+bool LayoutPool::open(const std::string &path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    HANDLE map = nullptr;
+    void *view = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= static_cast<LONGLONG>(HEADER_SIZE))
+    {
+        map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        view = map ? MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    }
+    if (!view)
+    {
+        if (map)
+        {
+            CloseHandle(map);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mapHandle = map;
+    mapping = view;
+    mappingSize = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    void *view = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(HEADER_SIZE))
+    {
+        view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+    mapping = view;
+    mappingSize = static_cast<std::size_t>(info.st_size);
+#endif
+
+    const auto *header = static_cast<const std::uint8_t *>(mapping);
+    std::uint32_t entrySize = 0;
+    std::uint64_t entryCount = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        entrySize |= static_cast<std::uint32_t>(header[4 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        entryCount |= static_cast<std::uint64_t>(header[8 + i]) << (8 * i);
+    }
+
+    if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || header[3] != VERSION || entrySize != ENTRY_SIZE ||
+        entryCount == 0 || entryCount > (mappingSize - HEADER_SIZE) / ENTRY_SIZE)
+    {
+        close();
+        return false;
+    }
+
+    entries = header + HEADER_SIZE;
+    count = entryCount;
+    return true;
+}
+
+void LayoutPool::close()
+{
+    if (mapping)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+        CloseHandle(static_cast<HANDLE>(mapHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        mapHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        ::munmap(mapping, mappingSize);
+#endif
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    entries = nullptr;
+    count = 0;
+}
+
+FleetLayout LayoutPool::at(std::uint64_t index) const
+{
+    FleetLayout layout{};
+    std::memcpy(layout.data(), entries + index * ENTRY_SIZE, ENTRY_SIZE);
+    return layout;
+}
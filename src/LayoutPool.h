@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GameLogic.h"
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Pool of pre-generated fleet layouts (see fleet_layoutgen).
+//
+// File layout: a 16-byte header
+//   magic 'F' 'C' 'L' <version>, u32 entry size, u64 entry count
+// followed by fixed-width FleetLayout entries. The file is memory-mapped
+// read-only, so opening it costs nothing up front and picking a layout is
+// a single indexed read.
+class LayoutPool
+{
+public:
+    static constexpr std::uint8_t VERSION = 1;
+    static constexpr std::size_t HEADER_SIZE = 16;
+    static constexpr std::size_t ENTRY_SIZE = FLEET_SIZE;
+
+    LayoutPool() = default;
+    ~LayoutPool();
+
+    LayoutPool(const LayoutPool &) = delete;
+    LayoutPool &operator=(const LayoutPool &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const { return entries != nullptr; }
+    std::uint64_t size() const { return count; }
+
+    FleetLayout at(std::uint64_t index) const;
+
+    template <typename Rng>
+    FleetLayout pick(Rng &rng) const
+    {
+        std::uniform_int_distribution<std::uint64_t> dist(0, count - 1);
+        return at(dist(rng));
+    }
+
+    static void writeHeader(std::uint8_t *header, std::uint64_t entryCount);
+
+private:
+    const std::uint8_t *entries = nullptr;
+    std::uint64_t count = 0;
+    void *mapping = nullptr;
+    std::size_t mappingSize = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mapHandle = nullptr;
+#endif
+};
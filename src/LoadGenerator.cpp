@@ -0,0 +1,912 @@
+#include "LoadGenerator.h"
+#include "LayoutPool.h"
+#include "Match.h"
+#include "Protocol.h"
+#include "Random.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <queue>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr int MAX_EVENTS = 256;
+constexpr std::size_t READ_CHUNK = 16 * 1024;
+// New connections per worker per pass, so a large target ramps in rather
+// than overflowing the server's listen backlog
+constexpr std::size_t OPEN_BURST = 64;
+// Longest a worker sleeps before rechecking its target and collect()
+constexpr int LOOP_TICK_MS = 10;
+// Pause after a failed connect so a server that is down is not hammered
+constexpr auto CONNECT_BACKOFF = std::chrono::milliseconds(100);
+constexpr auto PING_SWEEP = std::chrono::milliseconds(50);
+// A refused Join is retried after this, doubled for each refusal in a row
+// up to MAX_JOIN_BACKOFF, with jitter so refused players do not return in
+// step
+constexpr auto JOIN_BACKOFF = std::chrono::milliseconds(50);
+constexpr auto MAX_JOIN_BACKOFF = std::chrono::milliseconds(1600);
+constexpr int SHIP_COUNT = static_cast<int>(FLEET_SIZE);
+
+std::uint64_t nanosBetween(Clock::time_point start, Clock::time_point end)
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+std::uint64_t epollKey(std::size_t slot, std::uint32_t generation)
+{
+    return static_cast<std::uint64_t>(generation) << 32 | static_cast<std::uint32_t>(slot);
+}
+
+// The server names the ship that sank but not where it lay; it is the
+// placement through the target made only of hits not yet accounted for
+bool sunkPlacement(const TargetView &view, int cell, int shipSize, std::uint8_t &code)
+{
+    for (const ShipPlacement &placement : shipPlacements(shipSize))
+    {
+        const CellMask &mask = placement.mask;
+        const bool allHits = (mask.words[0] & ~view.hits.words[0]) == 0 && (mask.words[1] & ~view.hits.words[1]) == 0;
+        if (mask.test(cell) && allHits && !mask.intersects(view.sunk))
+        {
+            code = placement.code;
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+const char *exchangeName(Exchange exchange)
+{
+    switch (exchange)
+    {
+    case Exchange::Connect:
+        return "connect";
+    case Exchange::Join:
+        return "join";
+    case Exchange::Place:
+        return "place";
+    case Exchange::Fire:
+        return "fire";
+    case Exchange::Ping:
+        return "ping";
+    case Exchange::Rejoin:
+        return "rejoin";
+    default:
+        return "?";
+    }
+}
+
+// ============================================================================
+// LoadStats Implementation
+// ============================================================================
+
+void LoadStats::merge(const LoadStats &other)
+{
+    for (std::size_t i = 0; i < EXCHANGE_COUNT; ++i)
+    {
+        latency[i].merge(other.latency[i]);
+    }
+    connects += other.connects;
+    connectFailures += other.connectFailures;
+    disconnects += other.disconnects;
+    shots += other.shots;
+    games += other.games;
+    errors += other.errors;
+    refused += other.refused;
+}
+
+void LoadStats::clear()
+{
+    for (auto &histogram : latency)
+    {
+        histogram.clear();
+    }
+    connects = 0;
+    connectFailures = 0;
+    disconnects = 0;
+    shots = 0;
+    games = 0;
+    errors = 0;
+    refused = 0;
+}
+
+// ============================================================================
+// Player and Worker
+// ============================================================================
+
+struct LoadGenerator::Player
+{
+    enum class State
+    {
+        Connecting,
+        Queued,
+        Placing,
+        Playing
+    };
+
+    int fd = -1;
+    std::uint32_t generation = 0;
+    bool open = false;
+    bool wantWrite = false;
+    State state = State::Connecting;
+    // Reconnecting to take the seat back rather than to queue
+    bool rejoining = false;
+    int seat = -1;
+    std::uint32_t matchId = 0;
+    std::uint32_t token = 0;
+    // Shot frames received this game, for Rejoin
+    std::uint16_t shotsSeen = 0;
+    int shotsFired = 0;
+    // Joins refused in a row
+    int refusals = 0;
+    // The connection drops before this shot; -1 for none this game
+    int dropAt = -1;
+    // Sinks on each side, so nobody fires after the last ship goes down
+    int shipsSunk = 0;
+    int shipsLost = 0;
+    TargetView view;
+    std::unique_ptr<ComputerAI> ai;
+    std::vector<std::uint8_t> untried;
+    std::vector<std::uint8_t> in;
+    std::vector<std::uint8_t> out;
+    Clock::time_point sentAt[EXCHANGE_COUNT];
+    Clock::time_point nextPing;
+};
+
+struct LoadGenerator::Worker
+{
+    struct Delayed
+    {
+        Clock::time_point due;
+        std::size_t slot;
+        std::uint32_t generation;
+        bool operator>(const Delayed &other) const { return due > other.due; }
+    };
+
+    LoadGenerator &owner;
+    std::size_t index;
+    int epollFd = -1;
+    Xoshiro256 rng;
+    std::vector<Player> players;
+    std::vector<std::size_t> freeSlots;
+    std::atomic<std::size_t> openCount{0};
+    // Shots held for the think time, and Joins backing off after a refusal
+    std::priority_queue<Delayed, std::vector<Delayed>, std::greater<Delayed>> delayed;
+    Clock::time_point retryAt;
+    Clock::time_point nextPingSweep;
+    std::uint64_t seenEpoch = 0;
+    LoadStats stats;
+
+    Worker(LoadGenerator &owner, std::size_t index, std::uint64_t seed)
+        : owner(owner), index(index), rng(seed)
+    {
+    }
+
+    void run();
+    std::size_t share() const;
+    void openConnections(Clock::time_point now);
+    bool openOne(Clock::time_point now);
+    // Starts a non-blocking connect and watches it under the slot's key
+    bool dial(Player &player, std::size_t slot);
+    void connected(Player &player);
+    void reconnect(Player &player);
+    void readFrom(Player &player);
+    void handleFrame(Player &player, const Frame &frame);
+    void startGame(Player &player, int seat);
+    void applyShot(Player &player, const ShotRecord &shot);
+    void recordShot(Player &player, const ShotRecord &shot);
+    // Picks up after a View or Delta answered a Rejoin
+    void resume(Player &player, const MatchStatus &status);
+    // Queues the Join again once the back-off for a refusal has passed
+    void retryJoin(Player &player);
+    void takeTurn(Player &player);
+    void fire(Player &player);
+    void sendPings(Clock::time_point now);
+    void flush(Player &player);
+    void setWriteInterest(Player &player, bool wantWrite);
+    void closePlayer(Player &player);
+    void handOver();
+};
+
+void LoadGenerator::Worker::run()
+{
+    epoll_event events[MAX_EVENTS];
+    while (owner.running.load(std::memory_order_relaxed))
+    {
+        Clock::time_point now = Clock::now();
+        openConnections(now);
+
+        int timeout = LOOP_TICK_MS;
+        if (!delayed.empty())
+        {
+            const auto wait =
+                std::chrono::duration_cast<std::chrono::milliseconds>(delayed.top().due - now).count();
+            timeout = static_cast<int>(std::max<std::int64_t>(0, std::min<std::int64_t>(wait, timeout)));
+        }
+
+        const int count = epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+        for (int i = 0; i < count; ++i)
+        {
+            const std::size_t slot = static_cast<std::size_t>(events[i].data.u64 & 0xFFFFFFFFu);
+            const auto generation = static_cast<std::uint32_t>(events[i].data.u64 >> 32);
+            Player &player = players[slot];
+            if (!player.open || player.generation != generation)
+            {
+                continue;
+            }
+
+            if (player.state == Player::State::Connecting)
+            {
+                connected(player);
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                ++stats.disconnects;
+                closePlayer(player);
+                continue;
+            }
+            if (events[i].events & EPOLLIN)
+            {
+                readFrom(player);
+            }
+            if (player.open && (events[i].events & EPOLLOUT))
+            {
+                flush(player);
+            }
+        }
+
+        now = Clock::now();
+        while (!delayed.empty() && delayed.top().due <= now)
+        {
+            const Delayed due = delayed.top();
+            delayed.pop();
+            Player &player = players[due.slot];
+            if (!player.open || player.generation != due.generation)
+            {
+                continue;
+            }
+            if (player.state == Player::State::Playing)
+            {
+                fire(player);
+            }
+            else if (player.state == Player::State::Queued)
+            {
+                appendJoin(player.out);
+                player.sentAt[static_cast<std::size_t>(Exchange::Join)] = now;
+                flush(player);
+            }
+        }
+        sendPings(now);
+
+        if (owner.harvestEpoch.load(std::memory_order_acquire) != seenEpoch)
+        {
+            handOver();
+        }
+    }
+
+    for (Player &player : players)
+    {
+        closePlayer(player);
+    }
+    close(epollFd);
+    epollFd = -1;
+}
+
+std::size_t LoadGenerator::Worker::share() const
+{
+    const std::size_t total = owner.targetConnections.load(std::memory_order_relaxed);
+    const std::size_t workerCount = owner.workers.size();
+    return total / workerCount + (index < total % workerCount ? 1 : 0);
+}
+
+void LoadGenerator::Worker::openConnections(Clock::time_point now)
+{
+    if (now < retryAt)
+    {
+        return;
+    }
+    const std::size_t target = share();
+    for (std::size_t opened = 0; opened < OPEN_BURST && openCount.load(std::memory_order_relaxed) < target; ++opened)
+    {
+        if (!openOne(now))
+        {
+            retryAt = now + CONNECT_BACKOFF;
+            return;
+        }
+    }
+}
+
+bool LoadGenerator::Worker::openOne(Clock::time_point now)
+{
+    std::size_t slot = players.size();
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        players.emplace_back();
+    }
+    Player &player = players[slot];
+    const std::uint32_t generation = player.generation;
+    player = Player();
+    player.generation = generation;
+    player.sentAt[static_cast<std::size_t>(Exchange::Connect)] = now;
+    if (!dial(player, slot))
+    {
+        freeSlots.push_back(slot);
+        return false;
+    }
+    openCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool LoadGenerator::Worker::dial(Player &player, std::size_t slot)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        ++stats.connectFailures;
+        return false;
+    }
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(owner.options.port);
+    address.sin_addr.s_addr = owner.address;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 && errno != EINPROGRESS)
+    {
+        ++stats.connectFailures;
+        close(fd);
+        return false;
+    }
+
+    // Completion of a non-blocking connect shows up as writability
+    ++player.generation;
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+    event.data.u64 = epollKey(slot, player.generation);
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        ++stats.connectFailures;
+        close(fd);
+        return false;
+    }
+    player.fd = fd;
+    player.open = true;
+    player.wantWrite = true;
+    player.state = Player::State::Connecting;
+    return true;
+}
+
+void LoadGenerator::Worker::connected(Player &player)
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(player.fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0)
+    {
+        ++stats.connectFailures;
+        closePlayer(player);
+        retryAt = Clock::now() + CONNECT_BACKOFF;
+        return;
+    }
+
+    const Clock::time_point now = Clock::now();
+    ++stats.connects;
+    stats.latency[static_cast<std::size_t>(Exchange::Connect)].record(
+        nanosBetween(player.sentAt[static_cast<std::size_t>(Exchange::Connect)], now));
+
+    // Spread pings over the interval rather than sending them in waves
+    const auto interval = owner.options.pingInterval;
+    if (interval.count() > 0)
+    {
+        player.nextPing = now + std::chrono::milliseconds(rng() % static_cast<std::uint64_t>(interval.count()));
+    }
+
+    if (player.rejoining)
+    {
+        player.state = Player::State::Playing;
+        appendRejoin(player.out, player.matchId, player.token, player.shotsSeen);
+        player.sentAt[static_cast<std::size_t>(Exchange::Rejoin)] = now;
+        flush(player);
+        return;
+    }
+
+    player.state = Player::State::Queued;
+    appendJoin(player.out);
+    player.sentAt[static_cast<std::size_t>(Exchange::Join)] = now;
+    flush(player);
+}
+
+void LoadGenerator::Worker::reconnect(Player &player)
+{
+    // Dropped without a word, as a lost network would; the game state
+    // stays with the player for the Rejoin
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, player.fd, nullptr);
+    close(player.fd);
+    player.in.clear();
+    player.out.clear();
+    player.rejoining = true;
+    player.sentAt[static_cast<std::size_t>(Exchange::Connect)] = Clock::now();
+    if (!dial(player, static_cast<std::size_t>(&player - players.data())))
+    {
+        player.open = false;
+        player.fd = -1;
+        player.ai.reset();
+        freeSlots.push_back(static_cast<std::size_t>(&player - players.data()));
+        openCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void LoadGenerator::Worker::readFrom(Player &player)
+{
+    std::uint8_t buffer[READ_CHUNK];
+    const ssize_t received = recv(player.fd, buffer, sizeof(buffer), 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+        ++stats.disconnects;
+        closePlayer(player);
+        return;
+    }
+    if (received < 0)
+    {
+        return;
+    }
+
+    player.in.insert(player.in.end(), buffer, buffer + received);
+    std::size_t consumed = 0;
+    Frame frame;
+    // A frame may lead the player to drop this connection for a new one,
+    // which takes whatever was left unread with it
+    const std::uint32_t generation = player.generation;
+    while (player.open && player.generation == generation)
+    {
+        const std::size_t length = parseFrame(player.in.data() + consumed, player.in.size() - consumed, frame);
+        if (length == 0)
+        {
+            break;
+        }
+        consumed += length;
+        handleFrame(player, frame);
+    }
+    if (!player.open || player.generation != generation)
+    {
+        return;
+    }
+    player.in.erase(player.in.begin(), player.in.begin() + static_cast<std::ptrdiff_t>(consumed));
+    flush(player);
+}
+
+void LoadGenerator::Worker::handleFrame(Player &player, const Frame &frame)
+{
+    const Clock::time_point now = Clock::now();
+    auto elapsed = [&](Exchange exchange)
+    { return nanosBetween(player.sentAt[static_cast<std::size_t>(exchange)], now); };
+
+    switch (frame.type)
+    {
+    case MessageType::Matched:
+    {
+        int seat = 0;
+        if (readMatched(frame, player.matchId, seat, player.token))
+        {
+            player.refusals = 0;
+            stats.latency[static_cast<std::size_t>(Exchange::Join)].record(elapsed(Exchange::Join));
+            startGame(player, seat);
+        }
+        break;
+    }
+    case MessageType::Start:
+        stats.latency[static_cast<std::size_t>(Exchange::Place)].record(elapsed(Exchange::Place));
+        player.state = Player::State::Playing;
+        if (player.seat == 0)
+        {
+            takeTurn(player);
+        }
+        break;
+    case MessageType::Shot:
+    {
+        if (frame.size != 4)
+        {
+            break;
+        }
+        ShotRecord shot;
+        shot.seat = frame.payload[0];
+        shot.cell = frame.payload[1];
+        shot.result = static_cast<Board::AttackResult>(frame.payload[2]);
+        shot.sunkShip = frame.payload[3] == NO_SHIP ? -1 : frame.payload[3];
+        if (shot.seat == player.seat)
+        {
+            stats.latency[static_cast<std::size_t>(Exchange::Fire)].record(elapsed(Exchange::Fire));
+        }
+        applyShot(player, shot);
+        if (shot.seat != player.seat && player.shipsLost < SHIP_COUNT)
+        {
+            takeTurn(player);
+        }
+        break;
+    }
+    case MessageType::Delta:
+    {
+        std::uint16_t since = 0;
+        MatchStatus status;
+        std::vector<ShotRecord> shots;
+        if (readDelta(frame, since, status, shots) && since == player.shotsSeen)
+        {
+            stats.latency[static_cast<std::size_t>(Exchange::Rejoin)].record(elapsed(Exchange::Rejoin));
+            for (const ShotRecord &shot : shots)
+            {
+                applyShot(player, shot);
+            }
+            resume(player, status);
+        }
+        else
+        {
+            ++stats.errors;
+        }
+        break;
+    }
+    case MessageType::View:
+    {
+        // Only sent when the Delta would be larger; the shots it folds in
+        // are lost to this player's aim
+        MatchView view;
+        if (readView(frame, view))
+        {
+            stats.latency[static_cast<std::size_t>(Exchange::Rejoin)].record(elapsed(Exchange::Rejoin));
+            player.shotsSeen = view.shots;
+            resume(player, view.status);
+        }
+        break;
+    }
+    case MessageType::GameOver:
+        // Both seats see it; count each match once
+        if (player.seat == 0)
+        {
+            ++stats.games;
+        }
+        player.state = Player::State::Queued;
+        player.ai.reset();
+        appendJoin(player.out);
+        player.sentAt[static_cast<std::size_t>(Exchange::Join)] = now;
+        break;
+    case MessageType::Error:
+        if (frame.size == 1 && static_cast<ProtocolError>(frame.payload[0]) == ProtocolError::Overloaded &&
+            player.state == Player::State::Queued)
+        {
+            ++stats.refused;
+            retryJoin(player);
+            break;
+        }
+        ++stats.errors;
+        break;
+    case MessageType::Pong:
+    {
+        std::uint64_t token = 0;
+        if (readToken(frame, token))
+        {
+            const auto sent = Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(token)));
+            stats.latency[static_cast<std::size_t>(Exchange::Ping)].record(nanosBetween(sent, now));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void LoadGenerator::Worker::startGame(Player &player, int seat)
+{
+    player.seat = seat;
+    player.state = Player::State::Placing;
+    player.shipsSunk = 0;
+    player.shipsLost = 0;
+    player.shotsSeen = 0;
+    player.shotsFired = 0;
+    player.rejoining = false;
+    player.view = TargetView();
+
+    // Before one of its first 20 shots, so the drop lands mid-game
+    const unsigned percent = owner.options.rejoinPercent;
+    player.dropAt = percent > 0 && rng() % 100 < percent ? static_cast<int>(rng() % 20) : -1;
+
+    const Options &options = owner.options;
+    if (options.ai)
+    {
+        player.ai = std::make_unique<ComputerAI>(options.ai->difficulty, rng());
+        player.ai->setSearchLimits(options.ai->limits);
+        player.ai->setOpeningBook(options.ai->book);
+    }
+    else
+    {
+        player.untried.resize(Board::SIZE * Board::SIZE);
+        std::iota(player.untried.begin(), player.untried.end(), 0);
+        std::shuffle(player.untried.begin(), player.untried.end(), rng);
+    }
+
+    const FleetLayout layout = options.layouts ? options.layouts->pick(rng) : randomFleetLayout(rng);
+    appendPlace(player.out, layout);
+    player.sentAt[static_cast<std::size_t>(Exchange::Place)] = Clock::now();
+}
+
+void LoadGenerator::Worker::applyShot(Player &player, const ShotRecord &shot)
+{
+    ++player.shotsSeen;
+    if (shot.seat == player.seat)
+    {
+        ++stats.shots;
+        recordShot(player, shot);
+    }
+    else if (shot.result == Board::AttackResult::Sunk)
+    {
+        ++player.shipsLost;
+    }
+}
+
+void LoadGenerator::Worker::recordShot(Player &player, const ShotRecord &shot)
+{
+    const int cell = shot.cell;
+    const Board::AttackResult result = shot.result;
+    const Coordinate target{cell / Board::SIZE, cell % Board::SIZE};
+
+    player.view.markShot(target, result == Board::AttackResult::Hit || result == Board::AttackResult::Sunk);
+    if (result == Board::AttackResult::Sunk)
+    {
+        ++player.shipsSunk;
+        std::uint8_t code = 0;
+        const auto ship = static_cast<std::size_t>(shot.sunkShip);
+        if (shot.sunkShip >= 0 && ship < FLEET_SIZE && sunkPlacement(player.view, cell, STANDARD_SHIP_SIZES[ship], code))
+        {
+            player.view.markSunk(code, STANDARD_SHIP_SIZES[ship]);
+        }
+    }
+    if (player.ai)
+    {
+        player.ai->recordResult(target, result, player.view);
+    }
+}
+
+void LoadGenerator::Worker::resume(Player &player, const MatchStatus &status)
+{
+    player.rejoining = false;
+    if (status.phase == static_cast<std::uint8_t>(Match::Phase::Playing) && status.turn == player.seat && player.shipsLost < SHIP_COUNT)
+    {
+        takeTurn(player);
+    }
+}
+
+void LoadGenerator::Worker::retryJoin(Player &player)
+{
+    const Clock::duration backoff =
+        std::min<Clock::duration>(JOIN_BACKOFF * (1 << std::min(player.refusals, 5)), MAX_JOIN_BACKOFF);
+    ++player.refusals;
+    // Anywhere from half to the whole back-off
+    const auto spread = static_cast<std::uint64_t>(backoff.count() / 2 + 1);
+    const auto jitter = Clock::duration(static_cast<Clock::rep>(rng() % spread));
+    const std::size_t slot = static_cast<std::size_t>(&player - players.data());
+    delayed.push(Delayed{Clock::now() + backoff / 2 + jitter, slot, player.generation});
+}
+
+void LoadGenerator::Worker::takeTurn(Player &player)
+{
+    if (player.shipsSunk == SHIP_COUNT)
+    {
+        return;
+    }
+    const auto think = owner.options.thinkTime;
+    if (think.count() > 0)
+    {
+        const std::size_t slot = static_cast<std::size_t>(&player - players.data());
+        delayed.push(Delayed{Clock::now() + think, slot, player.generation});
+        return;
+    }
+    fire(player);
+}
+
+void LoadGenerator::Worker::fire(Player &player)
+{
+    if (player.shotsFired == player.dropAt)
+    {
+        player.dropAt = -1;
+        reconnect(player);
+        return;
+    }
+    ++player.shotsFired;
+
+    int cell = 0;
+    if (player.ai)
+    {
+        const Coordinate target = player.ai->chooseMove(player.view).target;
+        cell = target.first * Board::SIZE + target.second;
+    }
+    else if (!player.untried.empty())
+    {
+        cell = player.untried.back();
+        player.untried.pop_back();
+    }
+    appendFire(player.out, cell);
+    player.sentAt[static_cast<std::size_t>(Exchange::Fire)] = Clock::now();
+    flush(player);
+}
+
+void LoadGenerator::Worker::sendPings(Clock::time_point now)
+{
+    const auto interval = owner.options.pingInterval;
+    if (interval.count() <= 0 || now < nextPingSweep)
+    {
+        return;
+    }
+    nextPingSweep = now + PING_SWEEP;
+
+    const auto token = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
+    for (Player &player : players)
+    {
+        if (player.open && player.state != Player::State::Connecting && now >= player.nextPing)
+        {
+            appendPing(player.out, token);
+            player.nextPing = now + interval;
+            flush(player);
+        }
+    }
+}
+
+void LoadGenerator::Worker::flush(Player &player)
+{
+    std::size_t offset = 0;
+    while (offset < player.out.size())
+    {
+        const ssize_t sent = send(player.fd, player.out.data() + offset, player.out.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            ++stats.disconnects;
+            closePlayer(player);
+            return;
+        }
+        offset += static_cast<std::size_t>(sent);
+    }
+    player.out.erase(player.out.begin(), player.out.begin() + static_cast<std::ptrdiff_t>(offset));
+    setWriteInterest(player, !player.out.empty());
+}
+
+void LoadGenerator::Worker::setWriteInterest(Player &player, bool wantWrite)
+{
+    if (player.wantWrite == wantWrite)
+    {
+        return;
+    }
+    player.wantWrite = wantWrite;
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? EPOLLOUT : 0u);
+    event.data.u64 = epollKey(static_cast<std::size_t>(&player - players.data()), player.generation);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, player.fd, &event);
+}
+
+void LoadGenerator::Worker::closePlayer(Player &player)
+{
+    if (!player.open)
+    {
+        return;
+    }
+    player.open = false;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, player.fd, nullptr);
+    close(player.fd);
+    player.fd = -1;
+    player.ai.reset();
+    player.in.clear();
+    player.out.clear();
+    freeSlots.push_back(static_cast<std::size_t>(&player - players.data()));
+    openCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void LoadGenerator::Worker::handOver()
+{
+    std::lock_guard<std::mutex> lock(owner.harvestMutex);
+    seenEpoch = owner.harvestEpoch.load(std::memory_order_relaxed);
+    owner.harvest.merge(stats);
+    stats.clear();
+    ++owner.handedOver;
+    owner.harvested.notify_all();
+}
+
+// ============================================================================
+// LoadGenerator Implementation
+// ============================================================================
+
+LoadGenerator::LoadGenerator(Options options)
+    : options(std::move(options))
+{
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    stop();
+}
+
+bool LoadGenerator::start()
+{
+    in_addr parsed{};
+    if (inet_pton(AF_INET, options.host.c_str(), &parsed) != 1)
+    {
+        std::cerr << "Invalid server address " << options.host << std::endl;
+        return false;
+    }
+    address = parsed.s_addr;
+
+    std::uint64_t seedState = options.seed;
+    const unsigned count = std::max(1u, options.threads);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        auto worker = std::make_unique<Worker>(*this, i, splitmix64(seedState));
+        worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (worker->epollFd < 0)
+        {
+            std::cerr << "epoll: " << std::strerror(errno) << std::endl;
+            workers.clear();
+            return false;
+        }
+        workers.push_back(std::move(worker));
+    }
+
+    running = true;
+    for (auto &worker : workers)
+    {
+        threads.emplace_back([&worker] { worker->run(); });
+    }
+    return true;
+}
+
+void LoadGenerator::stop()
+{
+    running = false;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+}
+
+std::size_t LoadGenerator::getOpenConnections() const
+{
+    std::size_t total = 0;
+    for (const auto &worker : workers)
+    {
+        total += worker->openCount.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void LoadGenerator::collect(LoadStats &stats)
+{
+    std::unique_lock<std::mutex> lock(harvestMutex);
+    harvest.clear();
+    handedOver = 0;
+    harvestEpoch.fetch_add(1, std::memory_order_release);
+    harvested.wait(lock, [this] { return handedOver == workers.size() || !running; });
+    stats.clear();
+    stats.merge(harvest);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "Simulation.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LayoutPool;
+
+// Request and reply pairs timed by fleet_loadgen
+enum class Exchange
+{
+    Connect, // TCP handshake
+    Join,    // Join to Matched, including the wait for an opponent; refused
+             // attempts are not timed
+    Place,   // Place to Start, including the opponent's placement
+    Fire,    // Fire to the Shot reporting it
+    Ping,    // Ping to Pong
+    Rejoin,  // Rejoin to the View or Delta, excluding the reconnect
+    Count
+};
+
+constexpr std::size_t EXCHANGE_COUNT = static_cast<std::size_t>(Exchange::Count);
+
+const char *exchangeName(Exchange exchange);
+
+struct LoadStats
+{
+    // Nanoseconds, per Exchange
+    LatencyHistogram latency[EXCHANGE_COUNT];
+    std::uint64_t connects = 0;
+    std::uint64_t connectFailures = 0;
+    std::uint64_t disconnects = 0;
+    std::uint64_t shots = 0;
+    std::uint64_t games = 0;
+    std::uint64_t errors = 0;
+    // Joins answered with Overloaded, each retried after a back-off
+    std::uint64_t refused = 0;
+
+    void merge(const LoadStats &other);
+    void clear();
+};
+
+// Simulated players for capacity tests of fleet_server. Each worker thread
+// runs its own epoll loop over its share of the connections. A player
+// queues for a match, places a fleet, fires until the game ends and queues
+// again; every request is timed from send to reply.
+//
+// Linux only.
+class LoadGenerator
+{
+public:
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::uint16_t port = 7777;
+        unsigned threads = 1;
+        // Unset: fire at uniformly random untried cells
+        std::optional<PlayerConfig> ai;
+        // Fleets are drawn from the pool when set, else from randomFleetLayout
+        const LayoutPool *layouts = nullptr;
+        // Delay before each shot, as a human would take
+        std::chrono::milliseconds thinkTime{0};
+        // Zero disables pings
+        std::chrono::milliseconds pingInterval{1000};
+        // Percentage of games in which a player drops its connection once,
+        // mid-game, and takes its seat back with Rejoin
+        unsigned rejoinPercent = 0;
+        std::uint64_t seed = 0;
+    };
+
+    explicit LoadGenerator(Options options);
+    ~LoadGenerator();
+
+    LoadGenerator(const LoadGenerator &) = delete;
+    LoadGenerator &operator=(const LoadGenerator &) = delete;
+
+    // Starts the workers; false (with a message on stderr) on a bad address
+    bool start();
+    void stop();
+
+    // Connections to hold open. Workers open new ones a burst at a time and
+    // replace any the server drops.
+    void setConnections(std::size_t target) { targetConnections = target; }
+    std::size_t getOpenConnections() const;
+
+    // Everything recorded since the previous call, from every worker
+    void collect(LoadStats &stats);
+
+private:
+    struct Player;
+    struct Worker;
+
+    Options options;
+    std::uint32_t address = 0;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<bool> running{false};
+    std::atomic<std::size_t> targetConnections{0};
+
+    // collect() bumps the epoch; each worker then merges its statistics
+    // into harvest on its next pass
+    std::mutex harvestMutex;
+    std::condition_variable harvested;
+    std::atomic<std::uint64_t> harvestEpoch{0};
+    std::size_t handedOver = 0;
+    LoadStats harvest;
+};
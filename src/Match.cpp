@@ -0,0 +1,139 @@
+#include "Match.h"
+#include "Metrics.h"
+
+void Match::reset(std::uint32_t newId)
+{
+    id = newId;
+    phase = Phase::Placing;
+    turn = 0;
+    winner = -1;
+    shots = 0;
+    for (int seat = 0; seat < SEATS; ++seat)
+    {
+        placed[seat] = false;
+        fleets[seat] = Fleet();
+    }
+}
+
+ProtocolError Match::place(int seat, const FleetLayout &layout)
+{
+    if (phase != Phase::Placing)
+    {
+        return ProtocolError::AlreadyPlaced;
+    }
+    if (placed[seat])
+    {
+        return ProtocolError::AlreadyPlaced;
+    }
+
+    Fleet fleet;
+    if (!buildFleet(layout, fleet))
+    {
+        return ProtocolError::InvalidLayout;
+    }
+    fleets[seat] = fleet;
+
+    placed[seat] = true;
+    if (placed[0] && placed[1])
+    {
+        phase = Phase::Playing;
+        Metrics::add(Counter::GamesStarted);
+    }
+    return ProtocolError::None;
+}
+
+ProtocolError Match::fire(int seat, int cell, ShotOutcome &outcome)
+{
+    if (phase != Phase::Playing || seat != turn)
+    {
+        return ProtocolError::NotYourTurn;
+    }
+    if (cell < 0 || cell >= Board::SIZE * Board::SIZE)
+    {
+        return ProtocolError::InvalidTarget;
+    }
+
+    const int opponent = 1 - seat;
+    Fleet &target = fleets[opponent];
+    outcome = ShotOutcome();
+    if (target.attacked.test(cell))
+    {
+        outcome.result = Board::AttackResult::AlreadyTried;
+        return ProtocolError::InvalidTarget;
+    }
+    target.attacked.set(cell);
+
+    if (!target.occupied.test(cell))
+    {
+        outcome.result = Board::AttackResult::Miss;
+        Metrics::add(Counter::Misses);
+        log[shots++] = packShot(ShotRecord{seat, cell, outcome.result, -1});
+        turn = opponent;
+        return ProtocolError::None;
+    }
+
+    target.hits.set(cell);
+    outcome.result = Board::AttackResult::Hit;
+    outcome.sunkShip = target.recordHit(cell, target.hits);
+    if (outcome.sunkShip >= 0)
+    {
+        outcome.result = Board::AttackResult::Sunk;
+    }
+    Metrics::add(outcome.result == Board::AttackResult::Sunk ? Counter::Sinks : Counter::Hits);
+    log[shots++] = packShot(ShotRecord{seat, cell, outcome.result, outcome.sunkShip});
+
+    if (target.allSunk())
+    {
+        phase = Phase::Finished;
+        Metrics::add(Counter::GamesFinished);
+        winner = seat;
+        outcome.gameOver = true;
+        return ProtocolError::None;
+    }
+
+    turn = opponent;
+    return ProtocolError::None;
+}
+
+MatchStatus Match::getStatus(int viewer) const
+{
+    MatchStatus status;
+    status.phase = static_cast<std::uint8_t>(phase);
+    status.turn = turn;
+    status.placed[0] = placed[0];
+    status.placed[1] = placed[1];
+    status.seat = viewer;
+    return status;
+}
+
+MatchView Match::view(int viewer) const
+{
+    MatchView result;
+    result.matchId = id;
+    result.shots = static_cast<std::uint16_t>(shots);
+    result.status = getStatus(viewer);
+    if (viewer >= 0)
+    {
+        result.layout = fleets[viewer].layout;
+    }
+    for (int seat = 0; seat < SEATS; ++seat)
+    {
+        result.sides[seat].attacked = fleets[seat].attacked;
+        result.sides[seat].hits = fleets[seat].hits;
+        result.sides[seat].sunk = fleets[seat].sunk;
+    }
+    return result;
+}
+
+void Match::forfeit(int seat)
+{
+    if (phase == Phase::Playing)
+    {
+        Metrics::add(Counter::GamesFinished);
+    }
+    if (phase != Phase::Finished)
+    {
+        phase = Phase::Finished;
+        winner = 1 - seat;
+    }
+}
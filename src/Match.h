@@ -0,0 +1,72 @@
+#pragma once
+
+#include "GameLogic.h"
+#include "Protocol.h"
+#include <cstdint>
+
+// Rules of one networked two-player game, independent of the transport.
+// Seat 0 fires first; turns alternate after every valid shot.
+//
+// Fleets are kept as cell masks rather than Boards and Ships, so a Match
+// holds no heap memory and a finished one can be reset in place for the
+// next game.
+class Match
+{
+public:
+    enum class Phase
+    {
+        Placing,
+        Playing,
+        Finished
+    };
+
+    struct ShotOutcome
+    {
+        Board::AttackResult result = Board::AttackResult::Invalid;
+        // Index into the standard fleet when result is Sunk, otherwise -1
+        int sunkShip = -1;
+        bool gameOver = false;
+    };
+
+    static constexpr int SEATS = 2;
+
+    explicit Match(std::uint32_t id = 0) { reset(id); }
+
+    // Starts a fresh game under a new id
+    void reset(std::uint32_t newId);
+
+    std::uint32_t getId() const { return id; }
+    Phase getPhase() const { return phase; }
+    int getTurn() const { return turn; }
+    int getWinner() const { return winner; }
+    int getShotCount() const { return shots; }
+    bool hasPlaced(int seat) const { return placed[seat]; }
+    const FleetLayout &getLayout(int seat) const { return fleets[seat].layout; }
+    // Shot i of the game, in firing order
+    const PackedShot &getShot(int i) const { return log[i]; }
+    MatchStatus getStatus(int viewer) const;
+    // The match as the seat sees it, or a spectator when viewer is -1
+    MatchView view(int viewer) const;
+
+    ProtocolError place(int seat, const FleetLayout &layout);
+    ProtocolError fire(int seat, int cell, ShotOutcome &outcome);
+    // Ends the game in favour of the other seat
+    void forfeit(int seat);
+
+private:
+    struct Fleet : FleetMasks
+    {
+        // Shots received and those that struck a ship
+        CellMask attacked;
+        CellMask hits;
+    };
+
+    std::uint32_t id = 0;
+    Phase phase = Phase::Placing;
+    int turn = 0;
+    int winner = -1;
+    int shots = 0;
+    bool placed[SEATS] = {false, false};
+    Fleet fleets[SEATS];
+    PackedShot log[MAX_SHOTS];
+};
@@ -0,0 +1,554 @@
+#include "MatchLog.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+// Every file starts with the magic, a format version, then the shard and
+// the shard count of the server that wrote it, all u32
+constexpr std::uint8_t MAGIC[4] = {'F', 'C', 'M', 'L'};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::size_t HEADER_BYTES = 16;
+// size:u32 type:u8 ... check:u32
+constexpr std::size_t RECORD_OVERHEAD = 4 + 1 + 4;
+
+std::uint32_t fnv1a(const std::uint8_t *data, std::size_t size)
+{
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putU32(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+std::uint32_t getU32(const std::uint8_t *in)
+{
+    return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+           static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+}
+
+void appendRecord(std::vector<std::uint8_t> &out, LogRecord type, const std::uint8_t *payload, std::size_t size)
+{
+    const std::size_t start = out.size();
+    putU32(out, static_cast<std::uint32_t>(size));
+    out.push_back(static_cast<std::uint8_t>(type));
+    out.insert(out.end(), payload, payload + size);
+    putU32(out, fnv1a(out.data() + start, out.size() - start));
+}
+
+// Length of the intact record at data, or 0 when it is torn or corrupt
+std::size_t recordLength(const std::uint8_t *data, std::size_t size)
+{
+    if (size < RECORD_OVERHEAD)
+    {
+        return 0;
+    }
+    const std::size_t payload = getU32(data);
+    if (payload > size - RECORD_OVERHEAD)
+    {
+        return 0;
+    }
+    const std::size_t length = payload + RECORD_OVERHEAD;
+    return getU32(data + length - 4) == fnv1a(data, length - 4) ? length : 0;
+}
+
+bool readFile(const std::string &path, std::vector<std::uint8_t> &data)
+{
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    data.clear();
+    std::uint8_t buffer[64 * 1024];
+    std::size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    const bool ok = !std::ferror(file);
+    std::fclose(file);
+    return ok;
+}
+
+// Segment files are named segment-<number>.log; 0 for anything else
+std::uint32_t segmentNumberOf(const std::string &name)
+{
+    unsigned number = 0;
+    char tail = 0;
+    if (std::sscanf(name.c_str(), "segment-%u.lo%c", &number, &tail) == 2 && tail == 'g' &&
+        name.size() == std::strlen("segment-00000000.log"))
+    {
+        return number;
+    }
+    return 0;
+}
+
+// Whether the segment starts with a checkpoint that it holds in full
+bool holdsCheckpoint(const std::vector<std::uint8_t> &data)
+{
+    std::size_t offset = HEADER_BYTES;
+    bool first = true;
+    while (offset < data.size())
+    {
+        const std::size_t length = recordLength(data.data() + offset, data.size() - offset);
+        if (length == 0)
+        {
+            return false;
+        }
+        const auto type = static_cast<LogRecord>(data[offset + 4]);
+        if (first && type != LogRecord::CheckpointBegin)
+        {
+            return false;
+        }
+        if (type == LogRecord::CheckpointEnd)
+        {
+            return true;
+        }
+        first = false;
+        offset += length;
+    }
+    return false;
+}
+}
+
+MatchLog::Stats &MatchLog::Stats::operator+=(const Stats &other)
+{
+    eventBytes += other.eventBytes;
+    checkpointBytes += other.checkpointBytes;
+    resultBytes += other.resultBytes;
+    checkpoints += other.checkpoints;
+    bytesWritten += other.bytesWritten;
+    syncs += other.syncs;
+    segmentsDeleted += other.segmentsDeleted;
+    replayedBytes += other.replayedBytes;
+    replayedRecords += other.replayedRecords;
+    return *this;
+}
+
+// ============================================================================
+// MatchLog Implementation
+// ============================================================================
+
+MatchLog::MatchLog(std::string directory, std::size_t shard, std::size_t shards, std::size_t checkpointBytes)
+    : directory(std::move(directory)), shard(shard), shards(shards), checkpointBytes(checkpointBytes)
+{
+    this->directory += "/shard-" + std::to_string(shard);
+}
+
+MatchLog::~MatchLog()
+{
+    for (int fd : {segmentFd, resultsFd, directoryFd})
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+bool MatchLog::open()
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (error || directoryFd < 0)
+    {
+        std::cerr << "Unable to create match log " << directory << ": "
+                  << (error ? error.message() : std::strerror(errno)) << std::endl;
+        return false;
+    }
+
+    // Match ids encode the shard count, so a log only makes sense to a
+    // server with as many shards as the one that wrote it
+    const std::string resultsPath = directory + "/results.log";
+    std::uint8_t existing[HEADER_BYTES];
+    if (std::FILE *file = std::fopen(resultsPath.c_str(), "rb"))
+    {
+        const bool whole = std::fread(existing, 1, sizeof(existing), file) == sizeof(existing);
+        std::fclose(file);
+        if (whole && (std::memcmp(existing, MAGIC, sizeof(MAGIC)) != 0 || getU32(existing + 12) != shards))
+        {
+            std::cerr << "Match log " << directory << " was written by a server with " << getU32(existing + 12)
+                      << " threads; run with --threads " << getU32(existing + 12) << " to recover it" << std::endl;
+            return false;
+        }
+    }
+    resultsFd = ::open(resultsPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (resultsFd < 0)
+    {
+        std::cerr << "Unable to open " << resultsPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat status{};
+    if (fstat(resultsFd, &status) == 0 && status.st_size == 0)
+    {
+        std::vector<std::uint8_t> header;
+        writeHeader(header);
+        if (!writeAll(resultsFd, header.data(), header.size()))
+        {
+            std::cerr << "Unable to write " << resultsPath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MatchLog::replay(const Handler &handler)
+{
+    std::vector<std::uint32_t> numbers;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (const std::uint32_t number = segmentNumberOf(entry.path().filename().string()))
+        {
+            numbers.push_back(number);
+        }
+    }
+    if (error)
+    {
+        std::cerr << "Unable to list " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    // Start at the newest segment that opens with a whole checkpoint; older
+    // ones are left over from a compaction cut short
+    std::vector<std::uint8_t> data;
+    std::size_t start = 0;
+    for (std::size_t i = numbers.size(); i-- > 0;)
+    {
+        if (readFile(segmentPath(numbers[i]), data) && holdsCheckpoint(data))
+        {
+            start = i;
+            break;
+        }
+    }
+
+    // A checkpoint's records are held back until its CheckpointEnd: one cut
+    // short by a crash must not replace the matches replayed before it
+    std::vector<std::uint8_t> held;
+    bool holding = false;
+    const auto dispatch = [this, &handler](const std::uint8_t *record, std::size_t length)
+    {
+        handler(static_cast<LogRecord>(record[4]), record + 5, length - RECORD_OVERHEAD);
+        ++stats.replayedRecords;
+    };
+
+    bool torn = false;
+    for (std::size_t i = start; i < numbers.size(); ++i)
+    {
+        const std::string path = segmentPath(numbers[i]);
+        if (torn)
+        {
+            // Written after a segment that is damaged midway; events past
+            // the damage cannot be applied
+            std::cerr << "Dropping " << path << ", which follows a damaged segment" << std::endl;
+            std::filesystem::remove(path, error);
+            continue;
+        }
+        if (!readFile(path, data))
+        {
+            std::cerr << "Unable to read " << path << std::endl;
+            return false;
+        }
+        if (data.size() >= HEADER_BYTES &&
+            (std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0 || getU32(data.data() + 12) != shards))
+        {
+            std::cerr << path << " does not belong to shard " << shard << " of " << shards << std::endl;
+            return false;
+        }
+
+        std::size_t offset = std::min(HEADER_BYTES, data.size());
+        while (offset < data.size())
+        {
+            const std::size_t length = recordLength(data.data() + offset, data.size() - offset);
+            if (length == 0)
+            {
+                break;
+            }
+            const auto type = static_cast<LogRecord>(data[offset + 4]);
+            if (type == LogRecord::CheckpointBegin)
+            {
+                held.clear();
+                holding = true;
+            }
+            if (!holding)
+            {
+                dispatch(data.data() + offset, length);
+            }
+            else
+            {
+                held.insert(held.end(), data.begin() + static_cast<std::ptrdiff_t>(offset),
+                            data.begin() + static_cast<std::ptrdiff_t>(offset + length));
+            }
+            if (holding && type == LogRecord::CheckpointEnd)
+            {
+                for (std::size_t at = 0; at < held.size();)
+                {
+                    const std::size_t size = RECORD_OVERHEAD + getU32(held.data() + at);
+                    dispatch(held.data() + at, size);
+                    at += size;
+                }
+                held.clear();
+                holding = false;
+            }
+            offset += length;
+        }
+        stats.replayedBytes += offset;
+        if (offset < data.size())
+        {
+            // The tail of the last write before a crash
+            std::cerr << "Cutting " << data.size() - offset << " damaged bytes off " << path << std::endl;
+            if (truncate(path.c_str(), static_cast<off_t>(offset)) != 0)
+            {
+                std::cerr << "truncate: " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            torn = true;
+        }
+    }
+    if (holding)
+    {
+        std::cerr << "Discarding a checkpoint in " << directory << " that was cut short" << std::endl;
+    }
+    for (std::size_t i = 0; i < start; ++i)
+    {
+        std::filesystem::remove(segmentPath(numbers[i]), error);
+    }
+
+    // Appends go to a fresh segment, never after a tail that was cut
+    segmentNumber = numbers.empty() ? 0 : numbers.back();
+    oldestSegment = numbers.empty() ? 1 : numbers[start];
+    keepFrom = oldestSegment;
+    if (!startSegment())
+    {
+        std::cerr << "Unable to start a segment in " << directory << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void MatchLog::append(LogRecord type, const std::uint8_t *payload, std::size_t size)
+{
+    const std::size_t before = staged.size();
+    appendRecord(staged, type, payload, size);
+    const std::size_t bytes = staged.size() - before;
+    if (checkpointing)
+    {
+        stats.checkpointBytes += bytes;
+    }
+    else
+    {
+        stats.eventBytes += bytes;
+        sinceCheckpoint += bytes;
+    }
+}
+
+void MatchLog::appendResult(const std::uint8_t *payload, std::size_t size)
+{
+    const std::size_t before = stagedResults.size();
+    appendRecord(stagedResults, LogRecord::Result, payload, size);
+    stats.resultBytes += stagedResults.size() - before;
+}
+
+void MatchLog::beginCheckpoint()
+{
+    stagedCheckpoint = staged.size();
+    checkpointing = true;
+    sinceCheckpoint = 0;
+    ++stats.checkpoints;
+}
+
+void MatchLog::submit()
+{
+    checkpointing = false;
+    if (staged.empty() && stagedResults.empty())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (stagedCheckpoint != NO_CHECKPOINT)
+    {
+        pendingCheckpoint = pending.size() + stagedCheckpoint;
+        stagedCheckpoint = NO_CHECKPOINT;
+    }
+    // Swapping keeps both buffers' capacity in circulation
+    if (pending.empty())
+    {
+        pending.swap(staged);
+    }
+    else
+    {
+        pending.insert(pending.end(), staged.begin(), staged.end());
+    }
+    staged.clear();
+    if (pendingResults.empty())
+    {
+        pendingResults.swap(stagedResults);
+    }
+    else
+    {
+        pendingResults.insert(pendingResults.end(), stagedResults.begin(), stagedResults.end());
+    }
+    stagedResults.clear();
+}
+
+void MatchLog::commit()
+{
+    std::size_t checkpointAt;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        writing.swap(pending);
+        writingResults.swap(pendingResults);
+        checkpointAt = pendingCheckpoint;
+        pendingCheckpoint = NO_CHECKPOINT;
+    }
+    if (failed || (writing.empty() && writingResults.empty()))
+    {
+        writing.clear();
+        writingResults.clear();
+        return;
+    }
+
+    // A checkpoint opens a segment of its own, so everything before that
+    // segment can go once it is on disk
+    std::size_t written = 0;
+    if (checkpointAt != NO_CHECKPOINT)
+    {
+        if (!writeAll(segmentFd, writing.data(), checkpointAt) || !startSegment())
+        {
+            fail("write");
+            return;
+        }
+        written = checkpointAt;
+    }
+    if (!writeAll(segmentFd, writing.data() + written, writing.size() - written) ||
+        !writeAll(resultsFd, writingResults.data(), writingResults.size()))
+    {
+        fail("write");
+        return;
+    }
+    if (fdatasync(segmentFd) != 0 || (!writingResults.empty() && fdatasync(resultsFd) != 0))
+    {
+        fail("fdatasync");
+        return;
+    }
+    ++stats.syncs;
+    if (checkpointAt != NO_CHECKPOINT)
+    {
+        keepFrom = segmentNumber;
+    }
+    writing.clear();
+    writingResults.clear();
+
+    // Compaction: finished matches are summarised in results.log and live
+    // ones in the checkpoint
+    if (oldestSegment < keepFrom)
+    {
+        for (; oldestSegment < keepFrom; ++oldestSegment)
+        {
+            if (unlink(segmentPath(oldestSegment).c_str()) == 0)
+            {
+                ++stats.segmentsDeleted;
+            }
+        }
+        fsync(directoryFd);
+    }
+    if (segmentSize >= SEGMENT_BYTES && !startSegment())
+    {
+        fail("segment");
+    }
+}
+
+std::string MatchLog::segmentPath(std::uint32_t number) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "/segment-%08u.log", number);
+    return directory + name;
+}
+
+void MatchLog::writeHeader(std::vector<std::uint8_t> &out) const
+{
+    out.insert(out.end(), std::begin(MAGIC), std::end(MAGIC));
+    putU32(out, VERSION);
+    putU32(out, static_cast<std::uint32_t>(shard));
+    putU32(out, static_cast<std::uint32_t>(shards));
+}
+
+bool MatchLog::startSegment()
+{
+    if (segmentFd >= 0)
+    {
+        if (fdatasync(segmentFd) != 0)
+        {
+            return false;
+        }
+        ++stats.syncs;
+        close(segmentFd);
+        segmentFd = -1;
+    }
+    ++segmentNumber;
+    segmentFd = ::open(segmentPath(segmentNumber).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (segmentFd < 0)
+    {
+        return false;
+    }
+    std::vector<std::uint8_t> header;
+    writeHeader(header);
+    segmentSize = 0;
+    // The new name must be on disk before anything relies on the segment
+    return writeAll(segmentFd, header.data(), header.size()) && fsync(directoryFd) == 0;
+}
+
+bool MatchLog::writeAll(int fd, const std::uint8_t *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t count = write(fd, data, size);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += count;
+        size -= static_cast<std::size_t>(count);
+        stats.bytesWritten += static_cast<std::uint64_t>(count);
+        if (fd == segmentFd)
+        {
+            segmentSize += static_cast<std::size_t>(count);
+        }
+    }
+    return true;
+}
+
+void MatchLog::fail(const char *what)
+{
+    // The server keeps playing without a log rather than stopping
+    std::cerr << "Match log " << directory << ": " << what << ": " << std::strerror(errno)
+              << "; no longer logging" << std::endl;
+    failed = true;
+    writing.clear();
+    writingResults.clear();
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Record types of the match log. Payloads are little-endian:
+//   Started          match:u32 token:u32[2]
+//   Placed           match:u32 seat:u8 layout:u8[5]
+//   Shot             match:u32 shot:u8[2]          a PackedShot; the result
+//                                                  is recomputed on replay
+//   Ended            match:u32                     won, forfeited or timed
+//                                                  out; see its Result
+//   CheckpointBegin  uses:u32[slots]               every slot's use count
+//   Live             match:u32 token:u32[2] placed:u8 layout:u8[5][placed]
+//                    shots:u16 shot:u8[2][shots]   a match in progress
+//   CheckpointEnd
+//   Result           match:u32 winner:u8 reason:u8 view
+//                                                  in results.log only; the
+//                                                  view is a spectator View
+//                                                  payload
+enum class LogRecord : std::uint8_t
+{
+    Started = 1,
+    Placed,
+    Shot,
+    Ended,
+    CheckpointBegin,
+    Live,
+    CheckpointEnd,
+    Result
+};
+
+// Durable history of one ServerShard's matches, in DIR/shard-N.
+//
+// Events go to an append-only log split into segment files of about
+// SEGMENT_BYTES. The shard thread appends records to a private buffer and
+// hands it over once per loop iteration; a committer thread writes what
+// has been handed over and syncs it with one fdatasync every commit
+// interval (group commit), so play never waits on the disk. A crash loses
+// at most the last interval; a clean stop loses nothing.
+//
+// Once enough has been appended, the shard writes a checkpoint: a Live
+// record per match in progress. A checkpoint starts a new segment, and
+// once it is on disk every older segment is deleted, finished matches'
+// events included. Recovery reads the newest complete checkpoint and the
+// events after it, so its time is bounded by the checkpoint interval
+// rather than the server's uptime. Each finished match is also summarised
+// in results.log, which is never compacted.
+//
+// Every record is [size:u32][type:u8][payload][check:u32], the check an
+// FNV-1a hash of everything before it. A torn record at the tail is cut
+// off on recovery.
+//
+// Linux only.
+class MatchLog
+{
+public:
+    static constexpr std::size_t SEGMENT_BYTES = 8 * 1024 * 1024;
+
+    struct Stats
+    {
+        // Appended by the shard: play, checkpoints and result summaries
+        std::uint64_t eventBytes = 0;
+        std::uint64_t checkpointBytes = 0;
+        std::uint64_t resultBytes = 0;
+        std::uint64_t checkpoints = 0;
+        // Written by the committer, file headers included
+        std::uint64_t bytesWritten = 0;
+        std::uint64_t syncs = 0;
+        std::uint64_t segmentsDeleted = 0;
+        // Read back by replay()
+        std::uint64_t replayedBytes = 0;
+        std::uint64_t replayedRecords = 0;
+
+        Stats &operator+=(const Stats &other);
+    };
+
+    using Handler = std::function<void(LogRecord type, const std::uint8_t *payload, std::size_t size)>;
+
+    // A checkpoint is due once checkpointBytes of events follow the last one
+    MatchLog(std::string directory, std::size_t shard, std::size_t shards, std::size_t checkpointBytes);
+    ~MatchLog();
+
+    MatchLog(const MatchLog &) = delete;
+    MatchLog &operator=(const MatchLog &) = delete;
+
+    // Creates the shard's directory and opens results.log; false (with a
+    // message on stderr) on failure or when the log was written by a
+    // server with a different number of shards
+    bool open();
+    // Calls handler for each record from the newest complete checkpoint
+    // on, cutting off a torn tail, then starts a fresh segment for appends.
+    // A checkpoint's records reach handler only once its CheckpointEnd has
+    // been read; one cut short by a crash is dropped. False (with a message
+    // on stderr) when the log cannot be read.
+    bool replay(const Handler &handler);
+
+    // Shard thread only. Records collect in a private buffer until submit().
+    void append(LogRecord type, const std::uint8_t *payload, std::size_t size);
+    void appendResult(const std::uint8_t *payload, std::size_t size);
+    bool checkpointDue() const { return sinceCheckpoint >= checkpointBytes; }
+    // Records appended from here to submit() form a checkpoint
+    void beginCheckpoint();
+    // Hands what was appended to the committer
+    void submit();
+
+    // Committer thread only: writes everything submitted, syncs it and
+    // deletes the segments a checkpoint superseded
+    void commit();
+
+    // Call once the shard and the committer have stopped
+    const Stats &getStats() const { return stats; }
+
+private:
+    static constexpr std::size_t NO_CHECKPOINT = SIZE_MAX;
+
+    std::string directory;
+    std::size_t shard;
+    std::size_t shards;
+    std::size_t checkpointBytes;
+    Stats stats;
+
+    // Shard thread
+    std::vector<std::uint8_t> staged;
+    std::vector<std::uint8_t> stagedResults;
+    std::size_t stagedCheckpoint = NO_CHECKPOINT;
+    std::size_t sinceCheckpoint = 0;
+    bool checkpointing = false;
+
+    // Handed over, waiting for the committer
+    std::mutex pendingMutex;
+    std::vector<std::uint8_t> pending;
+    std::vector<std::uint8_t> pendingResults;
+    std::size_t pendingCheckpoint = NO_CHECKPOINT;
+
+    // Committer thread
+    std::vector<std::uint8_t> writing;
+    std::vector<std::uint8_t> writingResults;
+    int directoryFd = -1;
+    int segmentFd = -1;
+    int resultsFd = -1;
+    std::uint32_t segmentNumber = 0;
+    std::size_t segmentSize = 0;
+    // Segments oldestSegment .. segmentNumber exist
+    std::uint32_t oldestSegment = 0;
+    // Segments before this one are superseded by a checkpoint on disk
+    std::uint32_t keepFrom = 0;
+    bool failed = false;
+
+    std::string segmentPath(std::uint32_t number) const;
+    void writeHeader(std::vector<std::uint8_t> &out) const;
+    // Syncs and closes the current segment, then starts the next
+    bool startSegment();
+    bool writeAll(int fd, const std::uint8_t *data, std::size_t size);
+    void fail(const char *what);
+};
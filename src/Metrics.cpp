@@ -0,0 +1,175 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+namespace
+{
+// Clock reads are spaced to cost about this share of the time they measure;
+// two reads take roughly 100 ns
+constexpr std::uint64_t SAMPLED_NANOS_PER_READ = 100000;
+constexpr std::uint32_t MAX_SAMPLE_INTERVAL = 4096;
+
+// Guards attaching and detaching; scrapes only follow the list
+std::mutex registryMutex;
+
+const char *const DIFFICULTY_LABELS[] = {"easy", "medium", "hard"};
+
+void writeHeader(std::ostringstream &out, const char *name, const char *type, const std::string &help)
+{
+    out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+}
+}
+
+// Detaches the thread's block when the thread exits
+struct MetricsThreadExit
+{
+    Metrics::Block *block;
+
+    ~MetricsThreadExit() { Metrics::detach(block); }
+};
+
+// ============================================================================
+// Metrics Implementation
+// ============================================================================
+
+std::atomic<Metrics::Block *> Metrics::blocks{nullptr};
+
+const std::uint64_t Metrics::BUCKET_LIMITS[BUCKET_COUNT] = {
+    1000,      2500,      5000,       10000,      25000,      50000,      100000,
+    250000,    500000,    1000000,    2500000,    5000000,    10000000,   25000000,
+    50000000,  100000000, 250000000,  500000000,  1000000000};
+
+Metrics::Block *Metrics::attach()
+{
+    Block *block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (Block *candidate = blocks.load(std::memory_order_relaxed); candidate; candidate = candidate->next)
+        {
+            if (!candidate->inUse)
+            {
+                block = candidate;
+                break;
+            }
+        }
+        if (!block)
+        {
+            // Value-initialised, so every atomic starts at zero
+            block = new Block();
+            std::fill(std::begin(block->countdown), std::end(block->countdown), 1u);
+            std::fill(std::begin(block->interval), std::end(block->interval), 1u);
+            block->next = blocks.load(std::memory_order_relaxed);
+            blocks.store(block, std::memory_order_release);
+        }
+        block->inUse = true;
+    }
+
+    static thread_local MetricsThreadExit exit{block};
+    return block;
+}
+
+void Metrics::detach(Block *block)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    block->inUse = false;
+}
+
+void Metrics::record(Timer timer, std::uint64_t nanos)
+{
+    Block &block = local();
+    const std::size_t index = static_cast<std::size_t>(timer);
+    Histogram &histogram = block.timers[index];
+    const std::uint32_t weight = block.interval[index];
+    const std::size_t bucket = static_cast<std::size_t>(
+        std::lower_bound(std::begin(BUCKET_LIMITS), std::end(BUCKET_LIMITS), nanos) - std::begin(BUCKET_LIMITS));
+    bump(histogram.buckets[bucket], weight);
+    bump(histogram.nanos, nanos * weight);
+
+    const std::uint64_t interval = SAMPLED_NANOS_PER_READ / std::max<std::uint64_t>(nanos, 1);
+    block.interval[index] = static_cast<std::uint32_t>(std::clamp<std::uint64_t>(interval, 1, MAX_SAMPLE_INTERVAL));
+    block.countdown[index] = block.interval[index];
+}
+
+std::uint64_t Metrics::total(Counter counter)
+{
+    std::uint64_t sum = 0;
+    for (Block *block = blocks.load(std::memory_order_acquire); block; block = block->next)
+    {
+        sum += block->counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+std::string Metrics::render()
+{
+    std::ostringstream out;
+
+    const std::uint64_t started = total(Counter::GamesStarted);
+    const std::uint64_t finished = total(Counter::GamesFinished);
+    writeHeader(out, "fleet_games_started_total", "counter", "Games with both fleets placed.");
+    out << "fleet_games_started_total " << started << '\n';
+    writeHeader(out, "fleet_games_finished_total", "counter", "Games won, lost or forfeited after starting.");
+    out << "fleet_games_finished_total " << finished << '\n';
+    // Threads keep counting while the blocks are summed, so clamp at zero
+    writeHeader(out, "fleet_games_active", "gauge", "Games in progress.");
+    out << "fleet_games_active " << (started > finished ? started - finished : 0) << '\n';
+
+    writeHeader(out, "fleet_shots_total", "counter", "Shots fired, by result.");
+    out << "fleet_shots_total{result=\"miss\"} " << total(Counter::Misses) << '\n';
+    out << "fleet_shots_total{result=\"hit\"} " << total(Counter::Hits) << '\n';
+    out << "fleet_shots_total{result=\"sunk\"} " << total(Counter::Sinks) << '\n';
+
+    const std::uint64_t opened = total(Counter::ConnectionsOpened);
+    const std::uint64_t closed = total(Counter::ConnectionsClosed);
+    writeHeader(out, "fleet_connections_accepted_total", "counter", "Client connections accepted.");
+    out << "fleet_connections_accepted_total " << opened << '\n';
+    writeHeader(out, "fleet_connections_open", "gauge", "Client connections currently open.");
+    out << "fleet_connections_open " << (opened > closed ? opened - closed : 0) << '\n';
+    writeHeader(out, "fleet_received_bytes_total", "counter", "Bytes read from clients.");
+    out << "fleet_received_bytes_total " << total(Counter::BytesIn) << '\n';
+    writeHeader(out, "fleet_sent_bytes_total", "counter", "Bytes written to clients.");
+    out << "fleet_sent_bytes_total " << total(Counter::BytesOut) << '\n';
+
+    // Histograms: cumulative buckets per series, as Prometheus expects
+    auto writeHistogram = [&out](const char *name, Timer timer, const std::string &labels)
+    {
+        std::uint64_t buckets[BUCKET_COUNT + 1] = {};
+        std::uint64_t nanos = 0;
+        for (Block *block = blocks.load(std::memory_order_acquire); block; block = block->next)
+        {
+            const Histogram &histogram = block->timers[static_cast<std::size_t>(timer)];
+            for (std::size_t i = 0; i <= BUCKET_COUNT; ++i)
+            {
+                buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+            }
+            nanos += histogram.nanos.load(std::memory_order_relaxed);
+        }
+
+        const std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            cumulative += buckets[i];
+            out << name << "_bucket" << prefix << "le=\"" << static_cast<double>(BUCKET_LIMITS[i]) / 1e9 << "\"} "
+                << cumulative << '\n';
+        }
+        cumulative += buckets[BUCKET_COUNT];
+        out << name << "_bucket" << prefix << "le=\"+Inf\"} " << cumulative << '\n';
+        const std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+        out << name << "_sum" << suffix << ' ' << static_cast<double>(nanos) / 1e9 << '\n';
+        out << name << "_count" << suffix << ' ' << cumulative << '\n';
+    };
+
+    const std::string sampled = " (sampled, weighted to count every call).";
+    writeHeader(out, "fleet_ai_move_seconds", "histogram", "Time for the computer to choose a shot" + sampled);
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        writeHistogram("fleet_ai_move_seconds", static_cast<Timer>(static_cast<std::size_t>(Timer::MoveEasy) + i),
+                       std::string("difficulty=\"") + DIFFICULTY_LABELS[i] + "\"");
+    }
+    writeHeader(out, "fleet_placement_seconds", "histogram", "Time to generate a random fleet layout" + sampled);
+    writeHistogram("fleet_placement_seconds", Timer::Placement, "");
+
+    return out.str();
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Process-wide counters and sampled latency histograms, exported in the
+// Prometheus text format by MetricsEndpoint. Each thread writes its own block.
+
+enum class Counter
+{
+    GamesStarted,
+    GamesFinished,
+    // Shots by result; invalid and repeated shots are not counted
+    Misses,
+    Hits,
+    Sinks,
+    ConnectionsOpened,
+    ConnectionsClosed,
+    BytesIn,
+    BytesOut,
+    Count
+};
+
+enum class Timer
+{
+    // ComputerAI::chooseMove, by difficulty
+    MoveEasy,
+    MoveMedium,
+    MoveHard,
+    // randomFleetLayout
+    Placement,
+    Count
+};
+
+constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(Counter::Count);
+constexpr std::size_t TIMER_COUNT = static_cast<std::size_t>(Timer::Count);
+
+class Metrics
+{
+public:
+    // Upper bounds of the histogram buckets, in nanoseconds; one more
+    // bucket catches everything above the last
+    static constexpr std::size_t BUCKET_COUNT = 19;
+    static const std::uint64_t BUCKET_LIMITS[BUCKET_COUNT];
+
+    static void add(Counter counter, std::uint64_t amount = 1)
+    {
+        bump(local().counters[static_cast<std::size_t>(counter)], amount);
+    }
+
+    // True when this call should be timed and passed to record()
+    static bool sample(Timer timer) { return --local().countdown[static_cast<std::size_t>(timer)] == 0; }
+    static void record(Timer timer, std::uint64_t nanos);
+
+    // Every metric in the Prometheus text exposition format
+    static std::string render();
+
+private:
+    struct Histogram
+    {
+        std::atomic<std::uint64_t> buckets[BUCKET_COUNT + 1];
+        std::atomic<std::uint64_t> nanos;
+    };
+
+    struct Block
+    {
+        std::atomic<std::uint64_t> counters[COUNTER_COUNT];
+        Histogram timers[TIMER_COUNT];
+        // Only touched by the owning thread. Calls left until the next
+        // sample, and the number of calls the next sample stands for; both
+        // start at 1 so the first call of each timer is measured.
+        std::uint32_t countdown[TIMER_COUNT];
+        std::uint32_t interval[TIMER_COUNT];
+        Block *next = nullptr;
+        bool inUse = false;
+    };
+
+    // Single writer, so no read-modify-write instruction is needed
+    static void bump(std::atomic<std::uint64_t> &value, std::uint64_t amount)
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static Block &local()
+    {
+        static thread_local Block *block = nullptr;
+        if (!block)
+        {
+            block = attach();
+        }
+        return *block;
+    }
+
+    // Every block ever attached. Blocks are never freed, only reused, so a
+    // scrape can walk the list while threads come and go.
+    static std::atomic<Block *> blocks;
+
+    static Block *attach();
+    static void detach(Block *block);
+    static std::uint64_t total(Counter counter);
+    friend struct MetricsThreadExit;
+};
+
+// Times its scope into a histogram when the timer's sample comes up
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Timer timer)
+        : timer(timer), sampled(Metrics::sample(timer))
+    {
+        if (sampled)
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer()
+    {
+        if (sampled)
+        {
+            Metrics::record(timer, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                  std::chrono::steady_clock::now() - start)
+                                                                  .count()));
+        }
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Timer timer;
+    bool sampled;
+    std::chrono::steady_clock::time_point start;
+};
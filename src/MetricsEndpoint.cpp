@@ -0,0 +1,198 @@
+#include "MetricsEndpoint.h"
+#include "Metrics.h"
+#include <iostream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+constexpr std::size_t MAX_REQUEST = 4096;
+
+// Writes all of data unless the scraper goes away
+void sendAll(int fd, const std::string &data)
+{
+    std::size_t offset = 0;
+    while (offset < data.size())
+    {
+        ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (sent <= 0)
+        {
+            return;
+        }
+        offset += static_cast<std::size_t>(sent);
+    }
+}
+
+std::string response(const char *status, const char *contentType, const std::string &body)
+{
+    return std::string("HTTP/1.0 ") + status + "\r\nContent-Type: " + contentType +
+           "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+#endif
+}
+
+// ============================================================================
+// MetricsEndpoint Implementation
+// ============================================================================
+
+MetricsEndpoint::~MetricsEndpoint()
+{
+    stop();
+}
+
+#ifndef _WIN32
+
+bool MetricsEndpoint::start(std::uint16_t requestedPort, const std::string &host)
+{
+    stop();
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0 || pipe(wakePipe) != 0)
+    {
+        std::cerr << "Metrics endpoint: " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(requestedPort);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+    {
+        std::cerr << "Invalid metrics address " << host << std::endl;
+        stop();
+        return false;
+    }
+    socklen_t length = sizeof(address);
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listenFd, 16) != 0 ||
+        getsockname(listenFd, reinterpret_cast<sockaddr *>(&address), &length) != 0)
+    {
+        std::cerr << "Unable to serve metrics on " << host << ":" << requestedPort << ": " << std::strerror(errno)
+                  << std::endl;
+        stop();
+        return false;
+    }
+
+    port = ntohs(address.sin_port);
+    thread = std::thread([this] { serve(); });
+    return true;
+}
+
+void MetricsEndpoint::stop()
+{
+    if (thread.joinable())
+    {
+        const char wake = 0;
+        [[maybe_unused]] ssize_t written = write(wakePipe[1], &wake, 1);
+        thread.join();
+    }
+    for (int *fd : {&listenFd, &wakePipe[0], &wakePipe[1]})
+    {
+        if (*fd >= 0)
+        {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void MetricsEndpoint::serve()
+{
+    while (true)
+    {
+        pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents)
+        {
+            return;
+        }
+
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0)
+        {
+            answer(fd);
+            close(fd);
+        }
+    }
+}
+
+void MetricsEndpoint::answer(int fd)
+{
+    // A scraper that stalls mid-request is given a second, then dropped
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST)
+    {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            return;
+        }
+        request.append(buffer, static_cast<std::size_t>(received));
+    }
+
+    // Only the request line matters: "GET /metrics HTTP/1.1"
+    const std::string line = request.substr(0, request.find("\r\n"));
+    const std::size_t space = line.find(' ');
+    const std::string method = line.substr(0, space);
+    std::string path = space == std::string::npos ? "" : line.substr(space + 1, line.find(' ', space + 1) - space - 1);
+    path = path.substr(0, path.find('?'));
+
+    if (method != "GET")
+    {
+        sendAll(fd, response("405 Method Not Allowed", "text/plain", "Only GET is supported\n"));
+    }
+    else if (path != "/metrics")
+    {
+        sendAll(fd, response("404 Not Found", "text/plain", "Metrics are at /metrics\n"));
+    }
+    else
+    {
+        sendAll(fd, response("200 OK", "text/plain; version=0.0.4; charset=utf-8", Metrics::render()));
+    }
+}
+
+#else
+
+bool MetricsEndpoint::start(std::uint16_t, const std::string &)
+{
+    std::cerr << "The metrics endpoint is not available on Windows" << std::endl;
+    return false;
+}
+
+void MetricsEndpoint::stop()
+{
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Minimal HTTP/1.0 server for Prometheus scrapes. GET /metrics returns
+// Metrics::render(); anything else is a 404. Requests are answered one at
+// a time on a thread of its own, so a scrape never runs on a game thread.
+//
+// Meant for a local scraper, so it listens on 127.0.0.1 unless told
+// otherwise. Not available on Windows.
+class MetricsEndpoint
+{
+public:
+    MetricsEndpoint() = default;
+    ~MetricsEndpoint();
+
+    MetricsEndpoint(const MetricsEndpoint &) = delete;
+    MetricsEndpoint &operator=(const MetricsEndpoint &) = delete;
+
+    // Binds and starts serving; false (with a message on stderr) on failure.
+    // Port 0 picks a free port, see getPort().
+    bool start(std::uint16_t port, const std::string &host = "127.0.0.1");
+    void stop();
+
+    std::uint16_t getPort() const { return port; }
+
+private:
+    int listenFd = -1;
+    // Written by stop() to end the serving thread's poll()
+    int wakePipe[2] = {-1, -1};
+    std::uint16_t port = 0;
+    std::thread thread;
+
+    void serve();
+    void answer(int fd);
+};
@@ -0,0 +1,231 @@
+#include "NetworkManager.h"
+#include <iostream>
+
+namespace
+{
+constexpr std::size_t RECEIVE_CHUNK = 4096;
+const sf::Time PING_INTERVAL = sf::seconds(1.0f);
+// A join started before the host is listening is retried at this interval
+const sf::Time CONNECT_RETRY = sf::seconds(1.0f);
+}
+
+// ============================================================================
+// NetworkManager Implementation
+// ============================================================================
+
+NetworkManager::~NetworkManager()
+{
+    disconnect();
+}
+
+bool NetworkManager::host(unsigned short port)
+{
+    disconnect();
+    listener.setBlocking(false);
+    if (listener.listen(port) != sf::Socket::Done)
+    {
+        std::cerr << "Unable to listen on port " << port << std::endl;
+        return false;
+    }
+
+    hosting = true;
+    status = Status::Listening;
+    endpoint = "port " + std::to_string(port);
+    return true;
+}
+
+bool NetworkManager::join(const std::string &address, unsigned short port)
+{
+    disconnect();
+    remoteAddress = sf::IpAddress(address);
+    if (remoteAddress == sf::IpAddress::None)
+    {
+        std::cerr << "Unknown host " << address << std::endl;
+        return false;
+    }
+
+    hosting = false;
+    remotePort = port;
+    status = Status::Connecting;
+    endpoint = address + ":" + std::to_string(port);
+    startConnect();
+    return true;
+}
+
+void NetworkManager::disconnect()
+{
+    socket.disconnect();
+    listener.close();
+    status = Status::Offline;
+    in.clear();
+    out.clear();
+    roundTripMs = -1.0f;
+}
+
+void NetworkManager::startConnect()
+{
+    socket.setBlocking(false);
+    // Non-blocking connect reports NotReady; completion shows up as a
+    // remote address in poll()
+    socket.connect(remoteAddress, remotePort);
+    lastAttempt = clock.getElapsedTime();
+}
+
+void NetworkManager::poll(std::vector<Event> &events)
+{
+    switch (status)
+    {
+    case Status::Offline:
+        return;
+
+    case Status::Listening:
+        if (listener.accept(socket) != sf::Socket::Done)
+        {
+            return;
+        }
+        socket.setBlocking(false);
+        listener.close();
+        break;
+
+    case Status::Connecting:
+        if (socket.getRemoteAddress() == sf::IpAddress::None)
+        {
+            if (clock.getElapsedTime() - lastAttempt >= CONNECT_RETRY)
+            {
+                startConnect();
+            }
+            return;
+        }
+        break;
+
+    case Status::Connected:
+        readFrames(events);
+        break;
+    }
+
+    if (status != Status::Connected)
+    {
+        if (status == Status::Offline)
+        {
+            return;
+        }
+        status = Status::Connected;
+        lastPing = sf::Time::Zero;
+        events.push_back(Event{Event::Type::Connected});
+    }
+
+    const sf::Time now = clock.getElapsedTime();
+    if (lastPing == sf::Time::Zero || now - lastPing >= PING_INTERVAL)
+    {
+        appendPing(out, static_cast<std::uint64_t>(now.asMicroseconds()));
+        lastPing = now;
+    }
+    flush(events);
+}
+
+void NetworkManager::sendPlace(const FleetLayout &layout)
+{
+    appendPlace(out, layout);
+}
+
+void NetworkManager::sendFire(const Coordinate &target)
+{
+    appendFire(out, target.first * Board::SIZE + target.second);
+}
+
+void NetworkManager::readFrames(std::vector<Event> &events)
+{
+    char buffer[RECEIVE_CHUNK];
+    while (true)
+    {
+        std::size_t received = 0;
+        const sf::Socket::Status result = socket.receive(buffer, sizeof(buffer), received);
+        if (result == sf::Socket::Done)
+        {
+            in.insert(in.end(), buffer, buffer + received);
+            continue;
+        }
+        if (result != sf::Socket::NotReady)
+        {
+            lostConnection(events);
+            return;
+        }
+        break;
+    }
+
+    std::size_t consumed = 0;
+    Frame frame;
+    while (std::size_t length = parseFrame(in.data() + consumed, in.size() - consumed, frame))
+    {
+        handleFrame(frame, events);
+        consumed += length;
+    }
+    in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(consumed));
+}
+
+void NetworkManager::handleFrame(const Frame &frame, std::vector<Event> &events)
+{
+    switch (frame.type)
+    {
+    case MessageType::Place:
+        if (frame.size == FLEET_SIZE)
+        {
+            Event event{Event::Type::Place};
+            std::copy(frame.payload, frame.payload + FLEET_SIZE, event.layout.begin());
+            events.push_back(event);
+        }
+        break;
+    case MessageType::Fire:
+        if (frame.size == 1 && frame.payload[0] < Board::SIZE * Board::SIZE)
+        {
+            Event event{Event::Type::Fire};
+            event.target = Coordinate{frame.payload[0] / Board::SIZE, frame.payload[0] % Board::SIZE};
+            events.push_back(event);
+        }
+        break;
+    case MessageType::Ping:
+        appendPong(out, frame);
+        break;
+    case MessageType::Pong:
+    {
+        std::uint64_t sent = 0;
+        if (readToken(frame, sent))
+        {
+            const float sample =
+                static_cast<float>(static_cast<std::uint64_t>(clock.getElapsedTime().asMicroseconds()) - sent) /
+                1000.0f;
+            // Smoothed like TCP's SRTT
+            roundTripMs = roundTripMs < 0.0f ? sample : roundTripMs + (sample - roundTripMs) / 8.0f;
+        }
+        break;
+    }
+    default:
+        // Unknown frames are skipped so newer peers can add messages
+        break;
+    }
+}
+
+void NetworkManager::flush(std::vector<Event> &events)
+{
+    if (out.empty() || status != Status::Connected)
+    {
+        return;
+    }
+
+    std::size_t sent = 0;
+    const sf::Socket::Status result = socket.send(out.data(), out.size(), sent);
+    if (result == sf::Socket::Done || result == sf::Socket::Partial)
+    {
+        out.erase(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(sent));
+    }
+    else if (result != sf::Socket::NotReady)
+    {
+        lostConnection(events);
+    }
+}
+
+void NetworkManager::lostConnection(std::vector<Event> &events)
+{
+    disconnect();
+    events.push_back(Event{Event::Type::Disconnected});
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "GameLogic.h"
+#include "Protocol.h"
+#include <SFML/Network.hpp>
+#include <SFML/System.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Direct TCP link between two GUIs. One side hosts, the other joins; both
+// then trade Protocol.h frames. The host fires first.
+//
+// Every socket is non-blocking. poll() does all the I/O and is called once
+// per frame from GameGUI::processEvents, so a slow or silent peer never
+// stalls rendering.
+class NetworkManager
+{
+public:
+    static constexpr unsigned short DEFAULT_PORT = 7778;
+
+    enum class Status
+    {
+        Offline,
+        Listening,
+        Connecting,
+        Connected
+    };
+
+    struct Event
+    {
+        enum class Type
+        {
+            Connected,
+            Place,
+            Fire,
+            Disconnected
+        };
+
+        Type type;
+        FleetLayout layout{};
+        Coordinate target{0, 0};
+    };
+
+    ~NetworkManager();
+
+    // Both return false (with a message on stderr) if the socket cannot be set up
+    bool host(unsigned short port);
+    bool join(const std::string &address, unsigned short port);
+    void disconnect();
+
+    // Accepts or completes the connection, reads every complete frame,
+    // answers pings and flushes queued output. Peer messages are appended
+    // to events in arrival order.
+    void poll(std::vector<Event> &events);
+
+    void sendPlace(const FleetLayout &layout);
+    void sendFire(const Coordinate &target);
+
+    Status getStatus() const { return status; }
+    bool isActive() const { return status != Status::Offline; }
+    bool isConnected() const { return status == Status::Connected; }
+    bool isHost() const { return hosting; }
+    // Smoothed round-trip time in milliseconds, negative until measured
+    float getRoundTripMs() const { return roundTripMs; }
+    // "host:port" being listened on or connected to
+    const std::string &getEndpoint() const { return endpoint; }
+
+private:
+    sf::TcpListener listener;
+    sf::TcpSocket socket;
+    Status status = Status::Offline;
+    bool hosting = false;
+    sf::IpAddress remoteAddress;
+    unsigned short remotePort = 0;
+    std::string endpoint;
+
+    std::vector<std::uint8_t> in;
+    std::vector<std::uint8_t> out;
+    sf::Clock clock;
+    sf::Time lastPing;
+    sf::Time lastAttempt;
+    float roundTripMs = -1.0f;
+
+    void startConnect();
+    void readFrames(std::vector<Event> &events);
+    void handleFrame(const Frame &frame, std::vector<Event> &events);
+    void flush(std::vector<Event> &events);
+    void lostConnection(std::vector<Event> &events);
+};
@@ -0,0 +1,151 @@
+#include "OpeningBook.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+constexpr std::uint8_t MAGIC[3] = {'F', 'C', 'B'};
+constexpr std::size_t HEADER_SIZE = 8;
+constexpr std::size_t ENTRY_HEADER_SIZE = 17;
+
+bool maskLess(const CellMask &a, const CellMask &b)
+{
+    return a.words[1] != b.words[1] ? a.words[1] < b.words[1] : a.words[0] < b.words[0];
+}
+
+std::uint64_t getU64(const std::uint8_t *data)
+{
+    std::uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+void putU64(std::vector<std::uint8_t> &out, std::uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+}
+
+// ============================================================================
+// OpeningBook Implementation
+// ============================================================================
+
+void OpeningBook::clear()
+{
+    entries.clear();
+    cells.clear();
+}
+
+void OpeningBook::add(const CellMask &misses, const std::vector<std::uint8_t> &bestCells)
+{
+    Entry entry{misses, static_cast<std::uint32_t>(cells.size()), static_cast<std::uint8_t>(bestCells.size())};
+    cells.insert(cells.end(), bestCells.begin(), bestCells.end());
+
+    auto it = std::lower_bound(entries.begin(), entries.end(), misses, [](const Entry &e, const CellMask &m)
+                               { return maskLess(e.misses, m); });
+    if (it != entries.end() && it->misses == misses)
+    {
+        *it = entry;
+    }
+    else
+    {
+        entries.insert(it, entry);
+    }
+}
+
+const std::uint8_t *OpeningBook::lookup(const CellMask &misses, std::size_t &count) const
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), misses, [](const Entry &e, const CellMask &m)
+                               { return maskLess(e.misses, m); });
+    if (it == entries.end() || !(it->misses == misses) || it->count == 0)
+    {
+        count = 0;
+        return nullptr;
+    }
+    count = it->count;
+    return cells.data() + it->offset;
+}
+
+std::vector<std::uint8_t> OpeningBook::serialize() const
+{
+    std::vector<std::uint8_t> out(MAGIC, MAGIC + 3);
+    out.push_back(VERSION);
+    const auto count = static_cast<std::uint32_t>(entries.size());
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(count >> (8 * i)));
+    }
+
+    for (const auto &entry : entries)
+    {
+        putU64(out, entry.misses.words[0]);
+        putU64(out, entry.misses.words[1]);
+        out.push_back(entry.count);
+        out.insert(out.end(), cells.begin() + entry.offset, cells.begin() + entry.offset + entry.count);
+    }
+    return out;
+}
+
+bool OpeningBook::deserialize(const std::vector<std::uint8_t> &data)
+{
+    clear();
+    if (data.size() < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 3, data.begin()) || data[3] != VERSION)
+    {
+        return false;
+    }
+
+    const std::uint32_t count = static_cast<std::uint32_t>(data[4]) | static_cast<std::uint32_t>(data[5]) << 8 |
+                                static_cast<std::uint32_t>(data[6]) << 16 | static_cast<std::uint32_t>(data[7]) << 24;
+    std::size_t pos = HEADER_SIZE;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (data.size() - pos < ENTRY_HEADER_SIZE)
+        {
+            clear();
+            return false;
+        }
+
+        CellMask misses;
+        misses.words[0] = getU64(&data[pos]);
+        misses.words[1] = getU64(&data[pos + 8]);
+        const std::uint8_t cellCount = data[pos + 16];
+        pos += ENTRY_HEADER_SIZE;
+        if (data.size() - pos < cellCount)
+        {
+            clear();
+            return false;
+        }
+
+        std::vector<std::uint8_t> best(data.begin() + static_cast<std::ptrdiff_t>(pos),
+                                       data.begin() + static_cast<std::ptrdiff_t>(pos + cellCount));
+        pos += cellCount;
+        for (std::uint8_t cell : best)
+        {
+            if (cell >= Board::SIZE * Board::SIZE || misses.test(cell))
+            {
+                clear();
+                return false;
+            }
+        }
+        add(misses, best);
+    }
+    return pos == data.size();
+}
+
+bool OpeningBook::load(const std::string &path)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+    {
+        return false;
+    }
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    return deserialize(data);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "GameLogic.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Precomputed opening moves. While every shot has missed, the best next
+// shot depends only on which cells were tried, so each book entry maps that
+// set of misses to the cells tied for the highest hunt density.
+//
+// File layout (little-endian):
+//   'F' 'C' 'B' version:u8  entries:u32
+//   per entry: misses:u64[2]  count:u8  cells:u8[count]
+class OpeningBook
+{
+public:
+    static constexpr std::uint8_t VERSION = 1;
+
+    bool load(const std::string &path);
+    bool deserialize(const std::vector<std::uint8_t> &data);
+    std::vector<std::uint8_t> serialize() const;
+
+    // Adds or replaces the entry for this set of misses
+    void add(const CellMask &misses, const std::vector<std::uint8_t> &bestCells);
+    // Book cells for this position, or nullptr when it is out of book
+    const std::uint8_t *lookup(const CellMask &misses, std::size_t &count) const;
+
+    void clear();
+    std::size_t size() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        CellMask misses;
+        std::uint32_t offset;
+        std::uint8_t count;
+    };
+
+    // Sorted by misses for binary search
+    std::vector<Entry> entries;
+    std::vector<std::uint8_t> cells;
+};
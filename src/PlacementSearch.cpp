@@ -0,0 +1,114 @@
+#include "PlacementSearch.h"
+#include "Random.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+#include <vector>
+
+namespace
+{
+// Hunter games per candidate. More trials cut the noise in each score but
+// leave fewer candidates within the budget.
+constexpr int TRIALS_PER_CANDIDATE = 4;
+// Hunter games that re-score the winner. Its search score is the best of
+// many noisy means and so overstates how long it survives.
+constexpr int VALIDATION_TRIALS = 32;
+}
+
+const char *placementModeName(PlacementMode mode)
+{
+    switch (mode)
+    {
+    case PlacementMode::Random:
+        return "Random";
+    case PlacementMode::Adversarial:
+        return "Adversarial";
+    }
+    return "Unknown";
+}
+
+PlacementSearchResult searchAdversarialLayout(WorkStealingPool &pool, std::uint64_t seed,
+                                              std::chrono::milliseconds budget, const OpeningBook *book)
+{
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    std::vector<PlacementSearchResult> best(pool.size());
+
+    for (unsigned worker = 0; worker < pool.size(); ++worker)
+    {
+        pool.submit([&best, worker, seed, deadline, book]
+                    {
+            std::uint64_t state = seed + worker;
+            Xoshiro256 rng(splitmix64(state));
+            PlacementSearchResult &result = best[worker];
+            // The heuristic hunter; a time-budgeted one would score only a
+            // handful of candidates
+            const PlayerConfig hunter{Difficulty::Hard, SearchLimits{}, book};
+            result.meanShots = -1.0;
+
+            // Always score at least one candidate so a tiny budget still
+            // returns a valid layout
+            do
+            {
+                FleetLayout layout = randomFleetLayout(rng);
+                int total = 0;
+                for (int trial = 0; trial < TRIALS_PER_CANDIDATE; ++trial)
+                {
+                    total += huntLayout(layout, hunter, rng()).shots;
+                }
+                result.games += TRIALS_PER_CANDIDATE;
+                ++result.candidates;
+
+                const double mean = static_cast<double>(total) / TRIALS_PER_CANDIDATE;
+                if (mean > result.meanShots)
+                {
+                    result.meanShots = mean;
+                    result.layout = layout;
+                }
+            } while (std::chrono::steady_clock::now() < deadline); });
+    }
+    pool.wait();
+
+    PlacementSearchResult overall = best[0];
+    overall.candidates = 0;
+    overall.games = 0;
+    for (const auto &result : best)
+    {
+        if (result.meanShots > overall.meanShots)
+        {
+            overall.meanShots = result.meanShots;
+            overall.layout = result.layout;
+        }
+        overall.candidates += result.candidates;
+        overall.games += result.games;
+    }
+
+    // Fresh seeds from a stream none of the search workers used
+    std::uint64_t state = seed + pool.size();
+    Xoshiro256 rng(splitmix64(state));
+    std::vector<std::uint64_t> seeds(VALIDATION_TRIALS);
+    for (auto &trialSeed : seeds)
+    {
+        trialSeed = rng();
+    }
+    std::vector<int> shots(VALIDATION_TRIALS);
+    const FleetLayout &layout = overall.layout;
+    for (unsigned worker = 0; worker < pool.size(); ++worker)
+    {
+        pool.submit([&seeds, &shots, &layout, worker, workers = pool.size(), book]
+                    {
+            const PlayerConfig hunter{Difficulty::Hard, SearchLimits{}, book};
+            for (std::size_t trial = worker; trial < seeds.size(); trial += workers)
+            {
+                shots[trial] = huntLayout(layout, hunter, seeds[trial]).shots;
+            } });
+    }
+    pool.wait();
+
+    int total = 0;
+    for (int trialShots : shots)
+    {
+        total += trialShots;
+    }
+    overall.meanShots = static_cast<double>(total) / VALIDATION_TRIALS;
+    overall.games += VALIDATION_TRIALS;
+    return overall;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "GameLogic.h"
+#include <chrono>
+#include <cstdint>
+
+class OpeningBook;
+class WorkStealingPool;
+
+// How the computer deploys its fleet
+enum class PlacementMode
+{
+    Random,
+    Adversarial
+};
+
+const char *placementModeName(PlacementMode mode);
+
+struct PlacementSearchResult
+{
+    FleetLayout layout{};
+    // Average shots the reference hunter needed against layout, re-measured
+    // on games the search did not see
+    double meanShots = 0.0;
+    std::uint64_t candidates = 0;
+    std::uint64_t games = 0;
+};
+
+// Samples uniformly random layouts on every pool worker until the budget
+// runs out, scoring each by the average shots the Hard density heuristic
+// (without the anytime search) needs to sink it, and returns the layout
+// that survived longest. The winner is then re-scored on fresh games, so
+// meanShots is not inflated by picking the luckiest of the search's noisy
+// estimates. Uses the whole pool; do not share it with other work while
+// searching.
+PlacementSearchResult searchAdversarialLayout(WorkStealingPool &pool, std::uint64_t seed,
+                                              std::chrono::milliseconds budget, const OpeningBook *book = nullptr);
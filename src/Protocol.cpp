@@ -0,0 +1,341 @@
+#include "Protocol.h"
+#include <algorithm>
+
+std::size_t parseFrame(const std::uint8_t *data, std::size_t size, Frame &frame)
+{
+    if (size < FRAME_HEADER_SIZE || size < FRAME_HEADER_SIZE + data[1])
+    {
+        return 0;
+    }
+    frame.type = static_cast<MessageType>(data[0]);
+    frame.payload = data + FRAME_HEADER_SIZE;
+    frame.size = data[1];
+    return FRAME_HEADER_SIZE + frame.size;
+}
+
+void appendFrame(std::vector<std::uint8_t> &out, MessageType type, const std::uint8_t *payload, std::size_t size)
+{
+    out.push_back(static_cast<std::uint8_t>(type));
+    out.push_back(static_cast<std::uint8_t>(size));
+    out.insert(out.end(), payload, payload + size);
+}
+
+void appendJoin(std::vector<std::uint8_t> &out)
+{
+    appendFrame(out, MessageType::Join);
+}
+
+void appendPlace(std::vector<std::uint8_t> &out, const FleetLayout &layout)
+{
+    appendFrame(out, MessageType::Place, layout.data(), layout.size());
+}
+
+void appendFire(std::vector<std::uint8_t> &out, int cell)
+{
+    const std::uint8_t payload[1] = {static_cast<std::uint8_t>(cell)};
+    appendFrame(out, MessageType::Fire, payload, sizeof(payload));
+}
+
+namespace
+{
+constexpr std::size_t MASK_BYTES = 13;
+constexpr std::size_t SIDE_BYTES = 2 * MASK_BYTES + 1;
+constexpr std::size_t VIEW_HEADER_BYTES = 4 + 2 + 1;
+constexpr std::size_t DELTA_HEADER_BYTES = 2 + 1;
+constexpr std::uint8_t NO_SUNK_SHIP = 0xF;
+
+void putU16(std::uint8_t *out, std::uint16_t value)
+{
+    out[0] = static_cast<std::uint8_t>(value);
+    out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void putU32(std::uint8_t *out, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint16_t getU16(const std::uint8_t *in)
+{
+    return static_cast<std::uint16_t>(in[0] | in[1] << 8);
+}
+
+std::uint32_t getU32(const std::uint8_t *in)
+{
+    return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+           static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+}
+
+std::uint8_t packStatus(const MatchStatus &status)
+{
+    return static_cast<std::uint8_t>((status.phase & 3) | (status.turn & 1) << 2 | (status.placed[0] ? 8 : 0) |
+                                     (status.placed[1] ? 16 : 0) | (status.seat == 1 ? 32 : 0) |
+                                     (status.seat < 0 ? 64 : 0));
+}
+
+MatchStatus unpackStatus(std::uint8_t packed)
+{
+    MatchStatus status;
+    status.phase = packed & 3;
+    status.turn = (packed >> 2) & 1;
+    status.placed[0] = (packed & 8) != 0;
+    status.placed[1] = (packed & 16) != 0;
+    status.seat = (packed & 64) ? -1 : (packed >> 5) & 1;
+    return status;
+}
+
+// Cells 0-63 fill the first eight bytes, cells 64-99 the next five
+void putMask(std::uint8_t *out, const CellMask &mask)
+{
+    for (std::size_t i = 0; i < MASK_BYTES; ++i)
+    {
+        out[i] = static_cast<std::uint8_t>(mask.words[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+CellMask getMask(const std::uint8_t *in)
+{
+    CellMask mask;
+    for (std::size_t i = 0; i < MASK_BYTES; ++i)
+    {
+        mask.words[i / 8] |= static_cast<std::uint64_t>(in[i]) << (8 * (i % 8));
+    }
+    return mask;
+}
+
+void appendMatchIdFrame(std::vector<std::uint8_t> &out, MessageType type, std::uint32_t matchId)
+{
+    std::uint8_t payload[4];
+    putU32(payload, matchId);
+    appendFrame(out, type, payload, sizeof(payload));
+}
+}
+
+void appendMatched(std::vector<std::uint8_t> &out, std::uint32_t matchId, int seat, std::uint32_t token)
+{
+    std::uint8_t payload[9];
+    putU32(payload, matchId);
+    payload[4] = static_cast<std::uint8_t>(seat);
+    putU32(payload + 5, token);
+    appendFrame(out, MessageType::Matched, payload, sizeof(payload));
+}
+
+bool readMatched(const Frame &frame, std::uint32_t &matchId, int &seat, std::uint32_t &token)
+{
+    if (frame.size != 9)
+    {
+        return false;
+    }
+    matchId = getU32(frame.payload);
+    seat = frame.payload[4];
+    token = getU32(frame.payload + 5);
+    return true;
+}
+
+void appendStart(std::vector<std::uint8_t> &out)
+{
+    appendFrame(out, MessageType::Start);
+}
+
+void appendShot(std::vector<std::uint8_t> &out, int seat, int cell, Board::AttackResult result, int sunkShip)
+{
+    const std::uint8_t payload[4] = {
+        static_cast<std::uint8_t>(seat), static_cast<std::uint8_t>(cell), static_cast<std::uint8_t>(result),
+        sunkShip < 0 ? NO_SHIP : static_cast<std::uint8_t>(sunkShip)};
+    appendFrame(out, MessageType::Shot, payload, sizeof(payload));
+}
+
+void appendGameOver(std::vector<std::uint8_t> &out, int winner, GameOverReason reason)
+{
+    const std::uint8_t payload[2] = {static_cast<std::uint8_t>(winner), static_cast<std::uint8_t>(reason)};
+    appendFrame(out, MessageType::GameOver, payload, sizeof(payload));
+}
+
+void appendError(std::vector<std::uint8_t> &out, ProtocolError code)
+{
+    const std::uint8_t payload[1] = {static_cast<std::uint8_t>(code)};
+    appendFrame(out, MessageType::Error, payload, sizeof(payload));
+}
+
+void appendPing(std::vector<std::uint8_t> &out, std::uint64_t token)
+{
+    std::uint8_t payload[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        payload[i] = static_cast<std::uint8_t>(token >> (8 * i));
+    }
+    appendFrame(out, MessageType::Ping, payload, sizeof(payload));
+}
+
+void appendPong(std::vector<std::uint8_t> &out, const Frame &ping)
+{
+    appendFrame(out, MessageType::Pong, ping.payload, std::min<std::size_t>(ping.size, 8));
+}
+
+bool readToken(const Frame &frame, std::uint64_t &token)
+{
+    if (frame.size != 8)
+    {
+        return false;
+    }
+    token = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        token = token << 8 | frame.payload[i];
+    }
+    return true;
+}
+
+void appendSpectate(std::vector<std::uint8_t> &out, std::uint32_t matchId)
+{
+    appendMatchIdFrame(out, MessageType::Spectate, matchId);
+}
+
+void appendWatching(std::vector<std::uint8_t> &out, std::uint32_t matchId)
+{
+    appendMatchIdFrame(out, MessageType::Watching, matchId);
+}
+
+bool readMatchId(const Frame &frame, std::uint32_t &matchId)
+{
+    if (frame.size != 4)
+    {
+        return false;
+    }
+    matchId = getU32(frame.payload);
+    return true;
+}
+
+void appendRejoin(std::vector<std::uint8_t> &out, std::uint32_t matchId, std::uint32_t token, std::uint16_t since)
+{
+    std::uint8_t payload[10];
+    putU32(payload, matchId);
+    putU32(payload + 4, token);
+    putU16(payload + 8, since);
+    appendFrame(out, MessageType::Rejoin, payload, sizeof(payload));
+}
+
+bool readRejoin(const Frame &frame, std::uint32_t &matchId, std::uint32_t &token, std::uint16_t &since)
+{
+    if (frame.size != 10)
+    {
+        return false;
+    }
+    matchId = getU32(frame.payload);
+    token = getU32(frame.payload + 4);
+    since = getU16(frame.payload + 8);
+    return true;
+}
+
+// ============================================================================
+// Views and deltas
+// ============================================================================
+
+PackedShot packShot(const ShotRecord &shot)
+{
+    const std::uint8_t sunk = shot.sunkShip < 0 ? NO_SUNK_SHIP : static_cast<std::uint8_t>(shot.sunkShip);
+    return PackedShot{static_cast<std::uint8_t>((shot.cell & 0x7F) | (shot.seat ? 0x80 : 0)),
+                      static_cast<std::uint8_t>((static_cast<std::uint8_t>(shot.result) & 0xF) | sunk << 4)};
+}
+
+ShotRecord unpackShot(const PackedShot &packed)
+{
+    ShotRecord shot;
+    shot.seat = packed[0] >> 7;
+    shot.cell = packed[0] & 0x7F;
+    shot.result = static_cast<Board::AttackResult>(packed[1] & 0xF);
+    shot.sunkShip = (packed[1] >> 4) == NO_SUNK_SHIP ? -1 : packed[1] >> 4;
+    return shot;
+}
+
+std::size_t viewFrameSize(bool player)
+{
+    return FRAME_HEADER_SIZE + VIEW_HEADER_BYTES + (player ? FLEET_SIZE : 0) + 2 * SIDE_BYTES;
+}
+
+void appendView(std::vector<std::uint8_t> &out, const MatchView &view)
+{
+    std::uint8_t payload[VIEW_HEADER_BYTES + FLEET_SIZE + 2 * SIDE_BYTES];
+    putU32(payload, view.matchId);
+    putU16(payload + 4, view.shots);
+    payload[6] = packStatus(view.status);
+    std::size_t size = VIEW_HEADER_BYTES;
+    if (view.status.seat >= 0)
+    {
+        std::copy(view.layout.begin(), view.layout.end(), payload + size);
+        size += FLEET_SIZE;
+    }
+    for (const MatchView::Side &side : view.sides)
+    {
+        putMask(payload + size, side.attacked);
+        putMask(payload + size + MASK_BYTES, side.hits);
+        payload[size + 2 * MASK_BYTES] = side.sunk;
+        size += SIDE_BYTES;
+    }
+    appendFrame(out, MessageType::View, payload, size);
+}
+
+bool readView(const Frame &frame, MatchView &view)
+{
+    if (frame.size < VIEW_HEADER_BYTES)
+    {
+        return false;
+    }
+    MatchView result;
+    result.matchId = getU32(frame.payload);
+    result.shots = getU16(frame.payload + 4);
+    result.status = unpackStatus(frame.payload[6]);
+    const bool player = result.status.seat >= 0;
+    if (frame.size != viewFrameSize(player) - FRAME_HEADER_SIZE)
+    {
+        return false;
+    }
+    std::size_t offset = VIEW_HEADER_BYTES;
+    if (player)
+    {
+        std::copy(frame.payload + offset, frame.payload + offset + FLEET_SIZE, result.layout.begin());
+        offset += FLEET_SIZE;
+    }
+    for (MatchView::Side &side : result.sides)
+    {
+        side.attacked = getMask(frame.payload + offset);
+        side.hits = getMask(frame.payload + offset + MASK_BYTES);
+        side.sunk = frame.payload[offset + 2 * MASK_BYTES];
+        offset += SIDE_BYTES;
+    }
+    view = result;
+    return true;
+}
+
+void appendDelta(std::vector<std::uint8_t> &out, std::uint16_t since, const MatchStatus &status,
+                 const PackedShot *shots, std::size_t count)
+{
+    out.push_back(static_cast<std::uint8_t>(MessageType::Delta));
+    out.push_back(static_cast<std::uint8_t>(DELTA_HEADER_BYTES + 2 * count));
+    out.push_back(static_cast<std::uint8_t>(since));
+    out.push_back(static_cast<std::uint8_t>(since >> 8));
+    out.push_back(packStatus(status));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        out.insert(out.end(), shots[i].begin(), shots[i].end());
+    }
+}
+
+bool readDelta(const Frame &frame, std::uint16_t &since, MatchStatus &status, std::vector<ShotRecord> &shots)
+{
+    if (frame.size < DELTA_HEADER_BYTES || (frame.size - DELTA_HEADER_BYTES) % 2 != 0)
+    {
+        return false;
+    }
+    since = getU16(frame.payload);
+    status = unpackStatus(frame.payload[2]);
+    shots.clear();
+    for (std::size_t offset = DELTA_HEADER_BYTES; offset < frame.size; offset += 2)
+    {
+        shots.push_back(unpackShot(PackedShot{frame.payload[offset], frame.payload[offset + 1]}));
+    }
+    return true;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "GameLogic.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary wire protocol between fleet_server and its clients.
+//
+// Every message is a frame of [type:u8][length:u8][payload:length bytes].
+// Multi-byte fields are little-endian and cells are row * Board::SIZE + col.
+//
+// Client to server:
+//   Join                         queue for the next free opponent
+//   Place   layout:u8[5]         FleetLayout in createStandardFleet order
+//   Fire    cell:u8
+//   Ping    token:u8[0-8]        answered with a Pong echoing the token
+//   Spectate match:u32           watch a live match; 0 follows whichever
+//                                match is newest, moving on as each ends
+//   Rejoin  match:u32 token:u32 since:u16
+//                                take a seat back after losing the
+//                                connection; since counts the shots already
+//                                seen, or is FULL_VIEW
+// Server to client:
+//   Matched match:u32 seat:u8 token:u32
+//                                seat 0 fires first; the token reclaims the
+//                                seat with Rejoin
+//   Start                        both fleets are placed
+//   Shot    seat:u8 cell:u8 result:u8 sunk:u8
+//           result is a Board::AttackResult; sunk is the ship index or 0xFF
+//   GameOver winner:u8 reason:u8
+//   Error   code:u8              see ProtocolError
+//   Pong    token:u8[0-8]
+//   Watching match:u32           a spectator's view restarts here; followed
+//                                by a View of the match so far
+//   View    see MatchView        the whole match as the receiver may see it
+//   Delta   since:u16 status:u8 shot:u8[2][n]
+//                                the shots fired after the first since, as
+//                                PackedShots, and the status they lead to
+//
+// Two GUIs playing each other directly use the same frames peer to peer:
+// Place, Fire, Ping and Pong in both directions.
+enum class MessageType : std::uint8_t
+{
+    Join = 1,
+    Place = 2,
+    Fire = 3,
+    Ping = 4,
+    Spectate = 5,
+    Rejoin = 6,
+
+    Matched = 16,
+    Start = 17,
+    Shot = 18,
+    GameOver = 19,
+    Error = 20,
+    Pong = 21,
+    Watching = 22,
+    View = 23,
+    Delta = 24
+};
+
+enum class ProtocolError : std::uint8_t
+{
+    None = 0,
+    BadMessage,
+    NotInMatch,
+    AlreadyInMatch,
+    AlreadyPlaced,
+    InvalidLayout,
+    NotYourTurn,
+    InvalidTarget,
+    NoSuchMatch,
+    // The server cannot host another match right now; Join again later
+    ServerFull,
+    // Rejoin with a token that holds no seat in the match
+    BadToken,
+    // The server is shedding load and starts no new matches; Join again
+    // after a back-off. Matches in progress carry on.
+    Overloaded
+};
+
+enum class GameOverReason : std::uint8_t
+{
+    FleetSunk = 0,
+    Forfeit = 1,
+    // The loser let its turn time run out
+    Timeout = 2
+};
+
+constexpr std::size_t FRAME_HEADER_SIZE = 2;
+constexpr std::size_t MAX_PAYLOAD_SIZE = 255;
+constexpr std::uint8_t NO_SHIP = 0xFF;
+// Rejoin's since when the client has nothing to build on
+constexpr std::uint16_t FULL_VIEW = 0xFFFF;
+// Each seat fires at most once per cell
+constexpr std::size_t MAX_SHOTS = 2 * Board::SIZE * Board::SIZE;
+
+// Status carried by View and Delta, packed into one byte: the phase in
+// bits 0-1, the seat to move in bit 2, which seats have placed their fleet
+// in bits 3-4, and the receiver's seat in bit 5, or bit 6 for a spectator
+struct MatchStatus
+{
+    // A Match::Phase
+    std::uint8_t phase = 0;
+    int turn = 0;
+    bool placed[2] = {false, false};
+    // The receiver's seat, or -1 for a spectator
+    int seat = -1;
+};
+
+// Compact state of a match as one seat, or a spectator, may see it: 66
+// bytes at most however far the game has gone. Reconnecting players and
+// joining spectators get one instead of the match's history. Wire form:
+//   match:u32 shots:u16 status:u8 [layout:u8[5], players only] side[2]
+//   side: attacked:u8[13] hits:u8[13] sunk:u8
+// Cell masks are 100 bits, little-endian, and sunk has bit i set for ship
+// i of the standard fleet. A player gets its own layout, so the opponent's
+// side is all it cannot rebuild from its own fleet.
+struct MatchView
+{
+    // The fleet of one seat, as the shots at it revealed it
+    struct Side
+    {
+        CellMask attacked;
+        CellMask hits;
+        std::uint8_t sunk = 0;
+    };
+
+    std::uint32_t matchId = 0;
+    std::uint16_t shots = 0;
+    MatchStatus status;
+    FleetLayout layout{};
+    Side sides[2];
+};
+
+// One shot in two bytes: the cell with the shooter in the high bit (as in
+// replays), then the AttackResult in the low nibble and the sunk ship, or
+// 0xF, in the high nibble
+using PackedShot = std::array<std::uint8_t, 2>;
+
+struct ShotRecord
+{
+    int seat = 0;
+    int cell = 0;
+    Board::AttackResult result = Board::AttackResult::Miss;
+    int sunkShip = -1;
+};
+
+struct Frame
+{
+    MessageType type;
+    const std::uint8_t *payload;
+    std::size_t size;
+};
+
+// Parses the frame at the start of data. Returns the bytes it spans, or 0
+// when more data is needed.
+std::size_t parseFrame(const std::uint8_t *data, std::size_t size, Frame &frame);
+
+void appendFrame(std::vector<std::uint8_t> &out, MessageType type, const std::uint8_t *payload = nullptr,
+                 std::size_t size = 0);
+
+void appendJoin(std::vector<std::uint8_t> &out);
+void appendPlace(std::vector<std::uint8_t> &out, const FleetLayout &layout);
+void appendFire(std::vector<std::uint8_t> &out, int cell);
+void appendMatched(std::vector<std::uint8_t> &out, std::uint32_t matchId, int seat, std::uint32_t token);
+bool readMatched(const Frame &frame, std::uint32_t &matchId, int &seat, std::uint32_t &token);
+void appendStart(std::vector<std::uint8_t> &out);
+void appendShot(std::vector<std::uint8_t> &out, int seat, int cell, Board::AttackResult result, int sunkShip);
+void appendGameOver(std::vector<std::uint8_t> &out, int winner, GameOverReason reason);
+void appendError(std::vector<std::uint8_t> &out, ProtocolError code);
+// Tokens are little-endian; a send timestamp makes the Pong a round-trip
+// time measurement
+void appendPing(std::vector<std::uint8_t> &out, std::uint64_t token);
+void appendPong(std::vector<std::uint8_t> &out, const Frame &ping);
+bool readToken(const Frame &frame, std::uint64_t &token);
+void appendSpectate(std::vector<std::uint8_t> &out, std::uint32_t matchId);
+void appendWatching(std::vector<std::uint8_t> &out, std::uint32_t matchId);
+// Match id of a Spectate or Watching frame
+bool readMatchId(const Frame &frame, std::uint32_t &matchId);
+void appendRejoin(std::vector<std::uint8_t> &out, std::uint32_t matchId, std::uint32_t token, std::uint16_t since);
+bool readRejoin(const Frame &frame, std::uint32_t &matchId, std::uint32_t &token, std::uint16_t &since);
+
+PackedShot packShot(const ShotRecord &shot);
+ShotRecord unpackShot(const PackedShot &packed);
+void appendView(std::vector<std::uint8_t> &out, const MatchView &view);
+bool readView(const Frame &frame, MatchView &view);
+// Bytes of the View frame for a player, or for a spectator
+std::size_t viewFrameSize(bool player);
+// At most (MAX_PAYLOAD_SIZE - 3) / 2 shots fit one frame
+void appendDelta(std::vector<std::uint8_t> &out, std::uint16_t since, const MatchStatus &status,
+                 const PackedShot *shots, std::size_t count);
+bool readDelta(const Frame &frame, std::uint16_t &since, MatchStatus &status, std::vector<ShotRecord> &shots);
@@ -0,0 +1,33 @@
+#include "Random.h"
+#include <random>
+
+RandomService::RandomService(std::uint64_t sessionSeed)
+    : sessionSeed(sessionSeed), cosmeticRng(deriveSeed(sessionSeed, RandomStream::Cosmetic))
+{
+    restoreGame(sessionSeed);
+}
+
+std::uint64_t RandomService::freshSeed()
+{
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+}
+
+std::uint64_t RandomService::deriveSeed(std::uint64_t seed, RandomStream stream)
+{
+    std::uint64_t state = seed ^ (static_cast<std::uint64_t>(stream) * 0xD1B54A32D192ED03ull);
+    return splitmix64(state);
+}
+
+std::uint64_t RandomService::beginGame()
+{
+    std::uint64_t state = sessionSeed + gameCounter++;
+    restoreGame(splitmix64(state));
+    return gameSeed;
+}
+
+void RandomService::restoreGame(std::uint64_t seed)
+{
+    gameSeed = seed;
+    placementRng.seed(deriveSeed(seed, RandomStream::Placement));
+}
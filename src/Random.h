@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// splitmix64 step, used to expand seeds into generator state
+inline std::uint64_t splitmix64(std::uint64_t &state)
+{
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256** - 32 bytes of state, a few cycles per number. Satisfies
+// UniformRandomBitGenerator so it works with std::shuffle and the
+// std::*_distribution types.
+class Xoshiro256
+{
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256(std::uint64_t seed = 0) { this->seed(seed); }
+
+    void seed(std::uint64_t seed)
+    {
+        for (auto &word : s)
+        {
+            word = splitmix64(seed);
+        }
+    }
+
+    // The raw generator words, for save games
+    using State = std::array<std::uint64_t, 4>;
+    State state() const { return {s[0], s[1], s[2], s[3]}; }
+    void setState(const State &state)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            s[i] = state[static_cast<std::size_t>(i)];
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        const std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+private:
+    std::uint64_t s[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// Named sub-streams. Each one is derived from the game (or session) seed, so
+// cosmetic randomness never perturbs placement or AI decisions.
+enum class RandomStream : std::uint64_t
+{
+    Placement = 1,
+    AI = 2,
+    Cosmetic = 3
+};
+
+// Single source of randomness for a session. The session seed is shown in
+// the UI and can be passed back on the command line; every game seed is
+// derived from it in order, so replaying a session with the same seed and
+// the same inputs reproduces every game.
+class RandomService
+{
+public:
+    explicit RandomService(std::uint64_t sessionSeed = freshSeed());
+
+    // One std::random_device read, for when no seed was given
+    static std::uint64_t freshSeed();
+    static std::uint64_t deriveSeed(std::uint64_t seed, RandomStream stream);
+
+    std::uint64_t getSessionSeed() const { return sessionSeed; }
+    std::uint64_t getGameSeed() const { return gameSeed; }
+
+    // Advances to the next game seed and reseeds the per-game streams
+    std::uint64_t beginGame();
+    // Reseeds the per-game streams from a recorded game seed
+    void restoreGame(std::uint64_t seed);
+
+    Xoshiro256 &placement() { return placementRng; }
+    Xoshiro256 &cosmetic() { return cosmeticRng; }
+    std::uint64_t aiSeed() const { return deriveSeed(gameSeed, RandomStream::AI); }
+
+private:
+    std::uint64_t sessionSeed;
+    std::uint64_t gameCounter = 0;
+    std::uint64_t gameSeed = 0;
+    Xoshiro256 placementRng;
+    Xoshiro256 cosmeticRng;
+};
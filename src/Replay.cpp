@@ -0,0 +1,224 @@
+#include "Replay.h"
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+constexpr std::uint8_t MAGIC[3] = {'F', 'C', 'R'};
+constexpr std::uint8_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 4 + 8 + 2 * FLEET_SIZE + 2;
+constexpr std::size_t COUNT_OFFSET = HEADER_SIZE - 2;
+}
+
+// ============================================================================
+// Shot encoding
+// ============================================================================
+
+std::uint8_t encodeShot(Shooter shooter, const Coordinate &target)
+{
+    int cell = target.first * Board::SIZE + target.second;
+    return static_cast<std::uint8_t>((cell & 0x7F) | (shooter == Shooter::Computer ? 0x80 : 0));
+}
+
+Shooter decodeShooter(std::uint8_t shot)
+{
+    return (shot & 0x80) ? Shooter::Computer : Shooter::Player;
+}
+
+Coordinate decodeTarget(std::uint8_t shot)
+{
+    int cell = shot & 0x7F;
+    return Coordinate{cell / Board::SIZE, cell % Board::SIZE};
+}
+
+bool isFinishedGame(const ReplayRecord &record)
+{
+    CellMask shots[2];
+    for (std::uint8_t shot : record.shots)
+    {
+        const int cell = shot & 0x7F;
+        if (cell < Board::SIZE * Board::SIZE)
+        {
+            shots[static_cast<int>(decodeShooter(shot))].set(cell);
+        }
+    }
+    return shots[static_cast<int>(Shooter::Player)].contains(fleetMask(record.computerLayout)) ||
+           shots[static_cast<int>(Shooter::Computer)].contains(fleetMask(record.playerLayout));
+}
+
+// ============================================================================
+// ReplayWriter Implementation
+// ============================================================================
+
+ReplayWriter::ReplayWriter(std::string path)
+    : path(std::move(path))
+{
+    buffer.reserve(FLUSH_THRESHOLD + 512);
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    if (recording)
+    {
+        endGame();
+    }
+    flush();
+}
+
+void ReplayWriter::beginGame(std::uint64_t seed, const FleetLayout &playerLayout, const FleetLayout &computerLayout)
+{
+    if (recording)
+    {
+        endGame();
+    }
+
+    current.seed = seed;
+    current.playerLayout = playerLayout;
+    current.computerLayout = computerLayout;
+    current.shots.clear();
+    recording = true;
+}
+
+void ReplayWriter::recordShot(Shooter shooter, const Coordinate &target)
+{
+    if (recording)
+    {
+        current.shots.push_back(encodeShot(shooter, target));
+    }
+}
+
+const ReplayRecord &ReplayWriter::endGame()
+{
+    if (!recording)
+    {
+        return current;
+    }
+    recording = false;
+
+    const std::size_t count = current.shots.size();
+    buffer.insert(buffer.end(), std::begin(MAGIC), std::end(MAGIC));
+    buffer.push_back(VERSION);
+    for (int i = 0; i < 8; ++i)
+    {
+        buffer.push_back(static_cast<std::uint8_t>(current.seed >> (8 * i)));
+    }
+    buffer.insert(buffer.end(), current.playerLayout.begin(), current.playerLayout.end());
+    buffer.insert(buffer.end(), current.computerLayout.begin(), current.computerLayout.end());
+    buffer.push_back(static_cast<std::uint8_t>(count & 0xFF));
+    buffer.push_back(static_cast<std::uint8_t>(count >> 8));
+    buffer.insert(buffer.end(), current.shots.begin(), current.shots.end());
+
+    if (buffer.size() >= FLUSH_THRESHOLD)
+    {
+        flush();
+    }
+    return current;
+}
+
+void ReplayWriter::flush()
+{
+    if (buffer.empty())
+    {
+        return;
+    }
+
+    if (!output.is_open())
+    {
+        output.open(path, std::ios::binary | std::ios::app);
+        if (!output)
+        {
+            std::cerr << "Warning: Unable to write replays to " << path << std::endl;
+            return;
+        }
+    }
+
+    output.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    output.flush();
+    buffer.clear();
+}
+
+// ============================================================================
+// Replay reading
+// ============================================================================
+
+bool readReplayFile(const std::string &path, std::vector<ReplayRecord> &records)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+    {
+        return false;
+    }
+
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    std::size_t offset = 0;
+    while (offset < data.size())
+    {
+        if (data.size() - offset < HEADER_SIZE || data[offset] != MAGIC[0] || data[offset + 1] != MAGIC[1] ||
+            data[offset + 2] != MAGIC[2] || data[offset + 3] != VERSION)
+        {
+            return false;
+        }
+
+        const std::uint8_t *header = data.data() + offset;
+        ReplayRecord record;
+        for (int i = 0; i < 8; ++i)
+        {
+            record.seed |= static_cast<std::uint64_t>(header[4 + i]) << (8 * i);
+        }
+        std::copy(header + 12, header + 12 + FLEET_SIZE, record.playerLayout.begin());
+        std::copy(header + 12 + FLEET_SIZE, header + 12 + 2 * FLEET_SIZE, record.computerLayout.begin());
+
+        std::size_t count = header[COUNT_OFFSET] | (header[COUNT_OFFSET + 1] << 8);
+        offset += HEADER_SIZE;
+        if (data.size() - offset < count)
+        {
+            return false;
+        }
+
+        record.shots.assign(data.begin() + static_cast<std::ptrdiff_t>(offset),
+                            data.begin() + static_cast<std::ptrdiff_t>(offset + count));
+        offset += count;
+        records.push_back(std::move(record));
+    }
+
+    return true;
+}
+
+// ============================================================================
+// ReplayPlayer Implementation
+// ============================================================================
+
+ReplayPlayer::ReplayPlayer(ReplayRecord replay)
+    : record(std::move(replay))
+{
+    createStandardFleet(playerFleet);
+    createStandardFleet(computerFleet);
+    valid = applyFleetLayout(playerBoard, playerFleet, record.playerLayout) &&
+            applyFleetLayout(computerBoard, computerFleet, record.computerLayout);
+}
+
+bool ReplayPlayer::step(Event &event)
+{
+    if (!valid || finished())
+    {
+        return false;
+    }
+
+    std::uint8_t shot = record.shots[nextShot++];
+    event.shooter = decodeShooter(shot);
+    event.target = decodeTarget(shot);
+    event.shipName.clear();
+
+    Board &target = event.shooter == Shooter::Player ? computerBoard : playerBoard;
+    event.result = target.attack(event.target, event.shipName);
+    return true;
+}
+
+void ReplayPlayer::skipToEnd()
+{
+    Event event;
+    while (step(event))
+    {
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "GameLogic.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Compact game replays.
+//
+// A replay file is a plain concatenation of game records:
+//   magic    'F' 'C' 'R' <version>
+//   seed     u64, little-endian
+//   layouts  FleetLayout of the player, then of the computer (5 bytes each)
+//   count    u16 shot count, little-endian
+//   shots    one byte per shot: target cell (row * Board::SIZE + col) in the
+//            low 7 bits, shooter in the high bit (0 = player, 1 = computer)
+//
+// Attack results are not stored; they are recomputed from the layouts.
+
+enum class Shooter : std::uint8_t
+{
+    Player = 0,
+    Computer = 1
+};
+
+struct ReplayRecord
+{
+    std::uint64_t seed = 0;
+    FleetLayout playerLayout{};
+    FleetLayout computerLayout{};
+    std::vector<std::uint8_t> shots;
+};
+
+// Whether the record ends with a fleet sunk. Abandoned games stop short.
+bool isFinishedGame(const ReplayRecord &record);
+
+std::uint8_t encodeShot(Shooter shooter, const Coordinate &target);
+Shooter decodeShooter(std::uint8_t shot);
+Coordinate decodeTarget(std::uint8_t shot);
+
+// Buffered streaming writer. Shots are collected in memory and whole records
+// are appended to the file in large batches, so recording never issues a
+// syscall per shot. endGame() hands back the finished record for callers
+// that aggregate games (see Heatmaps.h).
+class ReplayWriter
+{
+public:
+    static constexpr std::size_t FLUSH_THRESHOLD = 64 * 1024;
+
+    explicit ReplayWriter(std::string path);
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter &) = delete;
+    ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+    void beginGame(std::uint64_t seed, const FleetLayout &playerLayout, const FleetLayout &computerLayout);
+    void recordShot(Shooter shooter, const Coordinate &target);
+    const ReplayRecord &endGame();
+    void flush();
+
+    bool isRecording() const { return recording; }
+    const std::string &getPath() const { return path; }
+
+private:
+    std::string path;
+    std::ofstream output;
+    std::vector<std::uint8_t> buffer;
+    ReplayRecord current;
+    bool recording = false;
+};
+
+// Reads every record from a replay file. Returns false if the file cannot be
+// opened or a record is truncated/corrupt (records read so far are kept).
+bool readReplayFile(const std::string &path, std::vector<ReplayRecord> &records);
+
+// Steps through a recorded game on its own pair of boards.
+class ReplayPlayer
+{
+public:
+    struct Event
+    {
+        Shooter shooter = Shooter::Player;
+        Coordinate target{0, 0};
+        Board::AttackResult result = Board::AttackResult::Invalid;
+        std::string shipName;
+    };
+
+    explicit ReplayPlayer(ReplayRecord record);
+
+    bool isValid() const { return valid; }
+    bool finished() const { return nextShot >= record.shots.size(); }
+    std::size_t getShotIndex() const { return nextShot; }
+    std::size_t getShotCount() const { return record.shots.size(); }
+    std::uint64_t getSeed() const { return record.seed; }
+
+    bool step(Event &event);
+    void skipToEnd();
+
+    const Board &getPlayerBoard() const { return playerBoard; }
+    const Board &getComputerBoard() const { return computerBoard; }
+
+private:
+    ReplayRecord record;
+    Board playerBoard;
+    Board computerBoard;
+    std::vector<std::unique_ptr<Ship>> playerFleet;
+    std::vector<std::unique_ptr<Ship>> computerFleet;
+    std::size_t nextShot = 0;
+    bool valid = false;
+};
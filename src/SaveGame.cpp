@@ -0,0 +1,328 @@
+#include "SaveGame.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr std::uint8_t MAGIC[3] = {'F', 'C', 'S'};
+constexpr std::uint8_t NO_CELL = 0xFF;
+
+std::uint32_t fnv1a(const std::uint8_t *data, std::size_t size)
+{
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putU32(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+std::uint8_t cellOf(const Coordinate &coord)
+{
+    if (coord.first < 0 || coord.first >= Board::SIZE || coord.second < 0 || coord.second >= Board::SIZE)
+    {
+        return NO_CELL;
+    }
+    return static_cast<std::uint8_t>(coord.first * Board::SIZE + coord.second);
+}
+
+Coordinate coordOf(std::uint8_t cell)
+{
+    if (cell == NO_CELL)
+    {
+        return Coordinate{-1, -1};
+    }
+    return Coordinate{cell / Board::SIZE, cell % Board::SIZE};
+}
+
+void putCells(std::vector<std::uint8_t> &out, const std::vector<Coordinate> &cells)
+{
+    out.push_back(static_cast<std::uint8_t>(cells.size()));
+    for (const auto &coord : cells)
+    {
+        out.push_back(cellOf(coord));
+    }
+}
+
+// Bounds-checked sequential reader over a snapshot buffer
+struct Reader
+{
+    const std::vector<std::uint8_t> &data;
+    std::size_t offset = 0;
+    bool ok = true;
+
+    std::uint8_t u8()
+    {
+        if (offset >= data.size())
+        {
+            ok = false;
+            return 0;
+        }
+        return data[offset++];
+    }
+
+    std::uint32_t u32()
+    {
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            value |= static_cast<std::uint32_t>(u8()) << (8 * i);
+        }
+        return value;
+    }
+
+    void cells(std::vector<Coordinate> &out)
+    {
+        std::size_t count = u8();
+        out.clear();
+        for (std::size_t i = 0; i < count && ok; ++i)
+        {
+            out.push_back(coordOf(u8()));
+        }
+    }
+};
+}
+
+// ============================================================================
+// Snapshot encoding
+// ============================================================================
+
+std::vector<std::uint8_t> serializeSnapshot(const BattleSnapshot &snapshot)
+{
+    std::vector<std::uint8_t> out;
+    out.reserve(512);
+
+    out.insert(out.end(), std::begin(MAGIC), std::end(MAGIC));
+    out.push_back(BattleSnapshot::VERSION);
+    putU32(out, static_cast<std::uint32_t>(snapshot.seed));
+    putU32(out, static_cast<std::uint32_t>(snapshot.seed >> 32));
+    out.push_back(snapshot.difficulty);
+    out.push_back(static_cast<std::uint8_t>((snapshot.computerToMove ? 1 : 0) | (snapshot.huntingMode ? 2 : 0)));
+    out.insert(out.end(), snapshot.playerLayout.begin(), snapshot.playerLayout.end());
+    out.insert(out.end(), snapshot.computerLayout.begin(), snapshot.computerLayout.end());
+    out.push_back(static_cast<std::uint8_t>(snapshot.shots.size() & 0xFF));
+    out.push_back(static_cast<std::uint8_t>(snapshot.shots.size() >> 8));
+    out.insert(out.end(), snapshot.shots.begin(), snapshot.shots.end());
+    putCells(out, snapshot.hitQueue);
+    out.push_back(cellOf(snapshot.lastHit));
+    putCells(out, snapshot.computerShots);
+    for (std::uint64_t word : snapshot.aiRng)
+    {
+        putU32(out, static_cast<std::uint32_t>(word));
+        putU32(out, static_cast<std::uint32_t>(word >> 32));
+    }
+    putU32(out, static_cast<std::uint32_t>(snapshot.shotsFired));
+    putU32(out, static_cast<std::uint32_t>(snapshot.hits));
+    putU32(out, fnv1a(out.data(), out.size()));
+    return out;
+}
+
+bool deserializeSnapshot(const std::vector<std::uint8_t> &data, BattleSnapshot &snapshot)
+{
+    // Version 1 differs only in lacking the AI generator state
+    if (data.size() < 8 || data[0] != MAGIC[0] || data[1] != MAGIC[1] || data[2] != MAGIC[2] || data[3] < 1 ||
+        data[3] > BattleSnapshot::VERSION)
+    {
+        return false;
+    }
+    const std::uint8_t version = data[3];
+
+    Reader tail{data, data.size() - 4};
+    if (tail.u32() != fnv1a(data.data(), data.size() - 4))
+    {
+        return false;
+    }
+
+    Reader in{data, 4};
+    BattleSnapshot result;
+    result.seed = in.u32();
+    result.seed |= static_cast<std::uint64_t>(in.u32()) << 32;
+    result.difficulty = in.u8();
+    std::uint8_t flags = in.u8();
+    result.computerToMove = (flags & 1) != 0;
+    result.huntingMode = (flags & 2) != 0;
+    for (auto &cell : result.playerLayout)
+    {
+        cell = in.u8();
+    }
+    for (auto &cell : result.computerLayout)
+    {
+        cell = in.u8();
+    }
+    std::size_t shotCount = in.u8();
+    shotCount |= static_cast<std::size_t>(in.u8()) << 8;
+    for (std::size_t i = 0; i < shotCount && in.ok; ++i)
+    {
+        result.shots.push_back(in.u8());
+    }
+    in.cells(result.hitQueue);
+    result.lastHit = coordOf(in.u8());
+    in.cells(result.computerShots);
+    if (version >= 2)
+    {
+        for (auto &word : result.aiRng)
+        {
+            word = in.u32();
+            word |= static_cast<std::uint64_t>(in.u32()) << 32;
+        }
+    }
+    result.shotsFired = static_cast<std::int32_t>(in.u32());
+    result.hits = static_cast<std::int32_t>(in.u32());
+
+    if (!in.ok || in.offset != data.size() - 4)
+    {
+        return false;
+    }
+
+    snapshot = std::move(result);
+    return true;
+}
+
+bool loadSnapshot(const std::string &path, BattleSnapshot &snapshot)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+    {
+        return false;
+    }
+
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    return deserializeSnapshot(data, snapshot);
+}
+
+bool writeFileAtomically(const std::string &path, const std::vector<std::uint8_t> &data)
+{
+    const std::string tempPath = path + ".tmp";
+
+    std::FILE *file = std::fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = std::fflush(file) == 0 && ok;
+#ifndef _WIN32
+    ok = ::fsync(::fileno(file)) == 0 && ok;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+
+    std::error_code error;
+    if (ok)
+    {
+        std::filesystem::rename(tempPath, path, error);
+    }
+    if (!ok || error)
+    {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// SnapshotWriter Implementation
+// ============================================================================
+
+SnapshotWriter::SnapshotWriter(std::string path, std::string action)
+    : path(std::move(path)), action(std::move(action))
+{
+    worker = std::thread(&SnapshotWriter::workerLoop, this);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void SnapshotWriter::submit(std::vector<std::uint8_t> data)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(data);
+        hasPending = true;
+        removePending = false;
+    }
+    wake.notify_one();
+}
+
+void SnapshotWriter::remove()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        hasPending = false;
+        removePending = true;
+    }
+    wake.notify_one();
+}
+
+void SnapshotWriter::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]
+              { return !hasPending && !removePending && !busy; });
+}
+
+void SnapshotWriter::workerLoop()
+{
+    std::vector<std::uint8_t> data;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this]
+                  { return stopping || hasPending || removePending; });
+
+        // Pending work is always finished before stopping so a final
+        // autosave is not lost on exit
+        if (hasPending)
+        {
+            data.swap(pending);
+            hasPending = false;
+            busy = true;
+            lock.unlock();
+            if (!writeFileAtomically(path, data))
+            {
+                std::cerr << "Warning: Unable to " << action << " to " << path << std::endl;
+            }
+            lock.lock();
+            busy = false;
+        }
+        else if (removePending)
+        {
+            removePending = false;
+            busy = true;
+            lock.unlock();
+            std::error_code error;
+            std::filesystem::remove(path, error);
+            lock.lock();
+            busy = false;
+        }
+        else if (stopping)
+        {
+            break;
+        }
+
+        idle.notify_all();
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "GameLogic.h"
+#include "Random.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Versioned binary snapshot of an in-progress battle.
+//
+// Boards are not stored cell by cell: both fleet layouts plus the ordered
+// shot log (encodeShot bytes, see Replay.h) rebuild them exactly, and keep
+// the replay of a resumed game complete. Layout on disk:
+//   magic 'F' 'C' 'S' <version>, fixed fields, length-prefixed lists,
+//   FNV-1a checksum of everything before it.
+struct BattleSnapshot
+{
+    static constexpr std::uint8_t VERSION = 2;
+
+    std::uint64_t seed = 0;
+    std::uint8_t difficulty = 0;
+    bool computerToMove = false;
+    FleetLayout playerLayout{};
+    FleetLayout computerLayout{};
+    std::vector<std::uint8_t> shots;
+
+    // Computer AI state
+    std::vector<Coordinate> hitQueue;
+    Coordinate lastHit{-1, -1};
+    bool huntingMode = false;
+    std::vector<Coordinate> computerShots;
+    // All zero when read from a version 1 save, which did not store it
+    Xoshiro256::State aiRng{};
+
+    // Per-game counters
+    std::int32_t shotsFired = 0;
+    std::int32_t hits = 0;
+};
+
+std::vector<std::uint8_t> serializeSnapshot(const BattleSnapshot &snapshot);
+bool deserializeSnapshot(const std::vector<std::uint8_t> &data, BattleSnapshot &snapshot);
+bool loadSnapshot(const std::string &path, BattleSnapshot &snapshot);
+
+// Writes to "<path>.tmp", syncs it and renames it over path, so a crash
+// leaves either the old or the new file, never a torn one.
+bool writeFileAtomically(const std::string &path, const std::vector<std::uint8_t> &data);
+
+// Background autosave. submit() only swaps a buffer under a mutex; the disk
+// write happens on a worker thread. Only the newest pending snapshot is kept.
+class SnapshotWriter
+{
+public:
+    // action completes the failure warning "Unable to <action> to <path>"
+    SnapshotWriter(std::string path, std::string action);
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter &) = delete;
+    SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+    void submit(std::vector<std::uint8_t> data);
+    void remove();
+    void waitIdle();
+
+    const std::string &getPath() const { return path; }
+
+private:
+    std::string path;
+    std::string action;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<std::uint8_t> pending;
+    bool hasPending = false;
+    bool removePending = false;
+    bool busy = false;
+    bool stopping = false;
+    std::thread worker;
+
+    void workerLoop();
+};
@@ -0,0 +1,2215 @@
+#include "ServerShard.h"
+#include "AllocationCount.h"
+#include "GameServer.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr int MAX_EVENTS = 256;
+constexpr std::size_t READ_CHUNK = 16 * 1024;
+// Clients that stop reading are dropped rather than buffered forever. A
+// player is owed a few hundred bytes at most; spectators skip ahead long
+// before this.
+constexpr std::size_t MAX_PENDING_OUTPUT = 256 * 1024;
+// Likewise clients that keep sending while out of tokens
+constexpr std::size_t MAX_PENDING_INPUT = 64 * 1024;
+// A spectator with more than this queued behind a full socket skips ahead.
+// The kernel send buffer absorbs ordinary jitter long before it is reached.
+constexpr std::size_t SPECTATOR_BACKLOG = 16 * 1024;
+constexpr int MAX_IOVECS = 64;
+// Spectator sockets written per loop iteration. The rest wait for the next
+// pass, collecting more events per write, so player turns are not queued
+// behind thousands of spectator sends.
+constexpr std::size_t SPECTATOR_FLUSH_BUDGET = 256;
+// Turn deadlines are checked this often, so a time-out fires up to this
+// much late
+constexpr std::chrono::seconds SWEEP_INTERVAL{1};
+// Joins stay refused this long after the loop last broke its latency SLO,
+// so admission does not flap with every batch
+constexpr std::chrono::milliseconds SHED_HOLD{500};
+
+// io_uring sizes, per shard. A receive buffer is only held from its recv's
+// completion until the frames in it are parsed, so a few thousand cover a
+// busy batch; a recv that finds none is re-armed after the batch.
+constexpr unsigned RING_ENTRIES = 4096;
+constexpr unsigned RECEIVE_BUFFERS = 4096;
+constexpr unsigned RECEIVE_BUFFER_SIZE = 1024;
+
+// io_uring user data: the operation in the top byte, then an eventKey with
+// the generation cut to 24 bits, or for a send its UringSend
+enum class Operation : std::uint8_t
+{
+    Accept = 1,
+    Wake,
+    Receive,
+    Cancel,
+    Send
+};
+
+constexpr std::uint32_t GENERATION_MASK = 0xFFFFFFu;
+constexpr std::uint64_t PAYLOAD_MASK = (std::uint64_t{1} << 56) - 1;
+
+// epoll user data: fd in the low half, connection generation in the high
+// half, so events for a closed fd that was reused in the same batch are
+// recognised as stale
+std::uint64_t eventKey(int fd, std::uint32_t generation)
+{
+    return static_cast<std::uint64_t>(generation) << 32 | static_cast<std::uint32_t>(fd);
+}
+
+// Match log payloads are little-endian, like the wire format
+void putU32(std::uint8_t *out, std::uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint32_t getU32(const std::uint8_t *in)
+{
+    return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+           static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+}
+
+std::uint64_t ringKey(Operation operation, std::uint64_t payload)
+{
+    return static_cast<std::uint64_t>(operation) << 56 | payload;
+}
+
+std::uint64_t receiveKey(int fd, std::uint32_t generation)
+{
+    return ringKey(Operation::Receive, eventKey(fd, generation & GENERATION_MASK));
+}
+}
+
+struct ServerShard::UringSend
+{
+    int fd = -1;
+    // Its connection closed while the send was in flight
+    bool orphaned = false;
+    // Holds the bytes until the kernel is done with them
+    std::vector<SharedBytes> chunks;
+    std::vector<std::uint8_t> tail;
+    iovec parts[MAX_IOVECS];
+    // Parts before first went out in an earlier, short send
+    int first = 0;
+    int count = 0;
+    std::size_t remaining = 0;
+    msghdr message{};
+};
+
+// ============================================================================
+// ServerStats Implementation
+// ============================================================================
+
+ServerStats &ServerStats::operator+=(const ServerStats &other)
+{
+    connectionsAccepted += other.connectionsAccepted;
+    connectionsMigrated += other.connectionsMigrated;
+    matchesStarted += other.matchesStarted;
+    matchesFinished += other.matchesFinished;
+    shots += other.shots;
+    framesIn += other.framesIn;
+    bytesIn += other.bytesIn;
+    bytesOut += other.bytesOut;
+    spectatorEvents += other.spectatorEvents;
+    spectatorSkips += other.spectatorSkips;
+    spectatorsDropped += other.spectatorsDropped;
+    matchesTimedOut += other.matchesTimedOut;
+    rejoins += other.rejoins;
+    joinsRefused += other.joinsRefused;
+    clientsThrottled += other.clientsThrottled;
+    clientsShed += other.clientsShed;
+    loopLag.merge(other.loopLag);
+    sessionAllocations += other.sessionAllocations;
+    heapAllocations += other.heapAllocations;
+    return *this;
+}
+
+// ============================================================================
+// ServerShard Implementation
+// ============================================================================
+
+ServerShard::ServerShard(GameServer &server, std::size_t index)
+    : server(server), index(index), tokenRng(RandomService::freshSeed()),
+      log(index < server.logs.size() ? server.logs[index].get() : nullptr)
+{
+    addMatchSlab();
+}
+
+ServerShard::~ServerShard()
+{
+    for (auto &connection : connections)
+    {
+        if (connection.open)
+        {
+            close(connection.fd);
+        }
+    }
+    for (auto &handoff : inbox)
+    {
+        close(handoff.connection.fd);
+    }
+    for (int fd : {listenFd, epollFd, wakeFd})
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+bool ServerShard::start(const std::string &host, std::uint16_t port, int backlog)
+{
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+    {
+        std::cerr << "socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    // Every shard binds the same port; the kernel spreads new connections
+    // across their accept queues
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+    {
+        std::cerr << "Invalid listen address " << host << std::endl;
+        return false;
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, backlog) != 0)
+    {
+        std::cerr << "Unable to listen on " << host << ":" << port << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0)
+    {
+        std::cerr << "eventfd: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (server.options.backend == GameServer::Backend::Uring)
+    {
+        ring = std::make_unique<IoUring>();
+        return ring->open(RING_ENTRIES, RECEIVE_BUFFERS, RECEIVE_BUFFER_SIZE);
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+    {
+        std::cerr << "epoll: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = eventKey(listenFd, 0);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.u64 = eventKey(wakeFd, 0);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    return true;
+}
+
+void ServerShard::wake()
+{
+    std::uint64_t one = 1;
+    if (wakeFd >= 0)
+    {
+        [[maybe_unused]] ssize_t written = write(wakeFd, &one, sizeof(one));
+    }
+}
+
+void ServerShard::run()
+{
+    const std::uint64_t allocationsBefore = threadAllocations();
+    if (ring)
+    {
+        runRing();
+    }
+    else
+    {
+        runEpoll();
+    }
+    submitLog();
+    stats.heapAllocations = threadAllocations() - allocationsBefore;
+}
+
+void ServerShard::runEpoll()
+{
+    epoll_event events[MAX_EVENTS];
+    while (true)
+    {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, waitTimeout());
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "epoll_wait: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        loopTime = std::chrono::steady_clock::now();
+        if (!behind)
+        {
+            behindSince = loopTime;
+            eventsBehind = 0;
+        }
+        eventsBehind += static_cast<std::size_t>(count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const int fd = static_cast<int>(events[i].data.u64 & 0xFFFFFFFFu);
+            const auto generation = static_cast<std::uint32_t>(events[i].data.u64 >> 32);
+            if (fd == wakeFd)
+            {
+                std::uint64_t wakeups = 0;
+                [[maybe_unused]] ssize_t drained = read(wakeFd, &wakeups, sizeof(wakeups));
+                if (server.stopping.load(std::memory_order_acquire))
+                {
+                    return;
+                }
+                drainInbox();
+                continue;
+            }
+            if (fd == listenFd)
+            {
+                acceptConnections();
+                continue;
+            }
+
+            Connection &connection = connections[static_cast<std::size_t>(fd)];
+            if (!connection.open || connection.generation != generation)
+            {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                closeConnection(connection);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT)
+            {
+                flush(connection);
+            }
+            if (connection.open && (events[i].events & EPOLLIN))
+            {
+                readFrom(connection);
+            }
+        }
+        if (sweepDue())
+        {
+            expireTurns();
+        }
+        resumeThrottled();
+        flushDirty();
+        submitLog();
+        // Level-triggered epoll rotates through the ready connections, so
+        // once the run of full batches has covered as many events as there
+        // are connections, every client waiting at its start was served
+        checkLoad(count == MAX_EVENTS && eventsBehind < connectionCount);
+    }
+}
+
+void ServerShard::acceptConnections()
+{
+    while (true)
+    {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                std::cerr << "accept: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+        openConnection(fd);
+    }
+}
+
+void ServerShard::openConnection(int fd)
+{
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    if (static_cast<std::size_t>(fd) >= connections.size())
+    {
+        connections.resize(static_cast<std::size_t>(fd) + 1);
+    }
+    Connection &connection = connections[static_cast<std::size_t>(fd)];
+    const std::uint32_t generation = connection.generation + 1;
+    connection = Connection();
+    connection.fd = fd;
+    connection.generation = generation;
+    connection.open = true;
+    connection.tokens = server.options.messageBurst;
+    connection.refilledAt = loopTime;
+    if (!watchInput(connection))
+    {
+        connection.open = false;
+        close(fd);
+        return;
+    }
+
+    ++connectionCount;
+    ++stats.connectionsAccepted;
+    Metrics::add(Counter::ConnectionsOpened);
+}
+
+bool ServerShard::watchInput(Connection &connection)
+{
+    if (ring)
+    {
+        return armReceive(connection);
+    }
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.u64 = eventKey(connection.fd, connection.generation);
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, connection.fd, &event) == 0;
+}
+
+void ServerShard::readFrom(Connection &connection)
+{
+    std::uint8_t buffer[READ_CHUNK];
+    ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+        closeConnection(connection);
+        return;
+    }
+    if (received < 0)
+    {
+        return;
+    }
+    stats.bytesIn += static_cast<std::uint64_t>(received);
+    Metrics::add(Counter::BytesIn, static_cast<std::uint64_t>(received));
+    parseInput(connection, buffer, static_cast<std::size_t>(received));
+}
+
+void ServerShard::parseInput(Connection &connection, const std::uint8_t *received, std::size_t count)
+{
+    // Parse straight out of the caller's buffer when nothing is left over
+    // from a previous read, which is the common case for small frames
+    const std::uint8_t *data = received;
+    std::size_t size = count;
+    if (!connection.in.empty())
+    {
+        connection.in.insert(connection.in.end(), received, received + count);
+        data = connection.in.data();
+        size = connection.in.size();
+    }
+
+    // A frame that moves the connection ends the batch; the rest is parsed
+    // by the shard it moves to
+    std::size_t consumed = 0;
+    Frame frame;
+    while (connection.open && !connection.move && !connection.throttled)
+    {
+        std::size_t length = parseFrame(data + consumed, size - consumed, frame);
+        if (length == 0)
+        {
+            break;
+        }
+        if (!takeToken(connection))
+        {
+            // The rest waits in connection.in until the bucket refills
+            connection.throttled = true;
+            throttled.push_back(eventKey(connection.fd, connection.generation));
+            ++stats.clientsThrottled;
+            break;
+        }
+        consumed += length;
+        ++stats.framesIn;
+        handleFrame(connection, frame);
+    }
+
+    if (!connection.open)
+    {
+        return;
+    }
+    if (data == received)
+    {
+        connection.in.assign(received + consumed, received + size);
+    }
+    else
+    {
+        connection.in.erase(connection.in.begin(), connection.in.begin() + static_cast<std::ptrdiff_t>(consumed));
+    }
+    if (connection.in.size() > MAX_PENDING_INPUT)
+    {
+        ++stats.clientsShed;
+        closeConnection(connection);
+        return;
+    }
+    if (connection.move)
+    {
+        migrate(connection);
+    }
+}
+
+bool ServerShard::takeToken(Connection &connection)
+{
+    const double rate = server.options.messageRate;
+    if (rate <= 0)
+    {
+        return true;
+    }
+    if (connection.tokens < 1)
+    {
+        const double elapsed = std::chrono::duration<double>(loopTime - connection.refilledAt).count();
+        connection.tokens = std::min(server.options.messageBurst, connection.tokens + elapsed * rate);
+        connection.refilledAt = loopTime;
+        if (connection.tokens < 1)
+        {
+            return false;
+        }
+    }
+    connection.tokens -= 1;
+    return true;
+}
+
+void ServerShard::resumeThrottled()
+{
+    if (throttled.empty())
+    {
+        return;
+    }
+    // Connections still short of tokens go back on throttled
+    throttledNow.swap(throttled);
+    for (std::uint64_t key : throttledNow)
+    {
+        Connection &connection = connections[static_cast<std::size_t>(key & 0xFFFFFFFFu)];
+        if (connection.open && connection.generation == static_cast<std::uint32_t>(key >> 32) &&
+            connection.throttled)
+        {
+            // Running short again is the same episode, so it is not counted
+            const std::uint64_t episodes = stats.clientsThrottled;
+            connection.throttled = false;
+            parseInput(connection, nullptr, 0);
+            stats.clientsThrottled = episodes;
+        }
+    }
+    throttledNow.clear();
+}
+
+void ServerShard::checkLoad(bool backlogged)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const auto lag = now - behindSince;
+    stats.loopLag.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(lag).count()));
+    const std::chrono::milliseconds slo = server.options.latencySlo;
+    if (slo.count() > 0 && lag > slo)
+    {
+        shedUntil = now + SHED_HOLD;
+    }
+    behind = backlogged;
+}
+
+bool ServerShard::shedding() const
+{
+    return loopTime < shedUntil || pendingMatches >= server.options.maxPendingMatches;
+}
+
+void ServerShard::handleFrame(Connection &connection, const Frame &frame)
+{
+    switch (frame.type)
+    {
+    case MessageType::Join:
+        handleJoin(connection);
+        break;
+    case MessageType::Place:
+        handlePlace(connection, frame);
+        break;
+    case MessageType::Fire:
+        handleFire(connection, frame);
+        break;
+    case MessageType::Spectate:
+        handleSpectate(connection, frame);
+        break;
+    case MessageType::Rejoin:
+        handleRejoin(connection, frame);
+        break;
+    case MessageType::Ping:
+        appendPong(outbox(connection), frame);
+        break;
+    default:
+        appendError(outbox(connection), ProtocolError::BadMessage);
+        break;
+    }
+}
+
+void ServerShard::handleJoin(Connection &connection)
+{
+    if (connection.matchId != 0 || connection.inLobby)
+    {
+        appendError(outbox(connection), ProtocolError::AlreadyInMatch);
+        return;
+    }
+    if (shedding())
+    {
+        appendError(outbox(connection), ProtocolError::Overloaded);
+        ++stats.joinsRefused;
+        return;
+    }
+    leaveAudience(connection);
+
+    GameServer::Seat partner;
+    if (!server.pairOrWait(GameServer::Seat{index, connection.fd, connection.generation}, partner))
+    {
+        connection.inLobby = true;
+        return;
+    }
+    if (partner.shard == index)
+    {
+        startMatch(connections[static_cast<std::size_t>(partner.fd)], connection);
+        return;
+    }
+
+    // The match is played on the shard where the first player waited
+    connection.move = Move{partner.shard, Move::Reason::Pair, partner.fd, partner.generation, 0};
+}
+
+void ServerShard::startMatch(Connection &first, Connection &second)
+{
+    first.inLobby = false;
+    // The joining shard checked its own load; a pairing across shards can
+    // still find this one at its cap
+    if (pendingMatches >= server.options.maxPendingMatches)
+    {
+        appendError(outbox(first), ProtocolError::Overloaded);
+        appendError(outbox(second), ProtocolError::Overloaded);
+        stats.joinsRefused += 2;
+        return;
+    }
+    ActiveMatch *slot = acquireMatch();
+    if (!slot)
+    {
+        appendError(outbox(first), ProtocolError::ServerFull);
+        appendError(outbox(second), ProtocolError::ServerFull);
+        return;
+    }
+
+    ActiveMatch &created = *slot;
+    const std::uint32_t matchId = created.match.getId();
+    created.fds[0] = first.fd;
+    created.fds[1] = second.fd;
+    for (std::uint32_t &token : created.tokens)
+    {
+        token = static_cast<std::uint32_t>(tokenRng());
+    }
+    newestMatchId = matchId;
+    if (log)
+    {
+        std::uint8_t record[12];
+        putU32(record, matchId);
+        putU32(record + 4, created.tokens[0]);
+        putU32(record + 8, created.tokens[1]);
+        log->append(LogRecord::Started, record, sizeof(record));
+    }
+    created.pending = true;
+    ++pendingMatches;
+    ++stats.matchesStarted;
+
+    std::vector<int> followers;
+    followers.swap(idleFollowers);
+    for (int fd : followers)
+    {
+        watch(connections[static_cast<std::size_t>(fd)], matchId, created);
+    }
+
+    first.matchId = matchId;
+    first.seat = 0;
+    second.matchId = matchId;
+    second.seat = 1;
+    appendMatched(outbox(first), matchId, 0, created.tokens[0]);
+    appendMatched(outbox(second), matchId, 1, created.tokens[1]);
+
+    created.session = playMatch(created);
+    stats.sessionAllocations = frames.getHeapAllocations();
+}
+
+ServerShard::ActiveMatch *ServerShard::findMatch(std::uint32_t matchId)
+{
+    if (matchId == 0)
+    {
+        return nullptr;
+    }
+    const std::uint32_t slot = ((matchId - 1) / static_cast<std::uint32_t>(server.shards.size())) % MAX_MATCH_SLOTS;
+    if (slot >= matchSlabs.size() * MATCH_SLAB_SIZE)
+    {
+        return nullptr;
+    }
+    ActiveMatch &active = matchSlot(slot);
+    return active.live && active.match.getId() == matchId ? &active : nullptr;
+}
+
+bool ServerShard::addMatchSlab()
+{
+    const auto first = static_cast<std::uint32_t>(matchSlabs.size() * MATCH_SLAB_SIZE);
+    if (first >= MAX_MATCH_SLOTS)
+    {
+        return false;
+    }
+    matchSlabs.push_back(std::make_unique<ActiveMatch[]>(MATCH_SLAB_SIZE));
+    freeSlots.reserve(first + MATCH_SLAB_SIZE);
+    liveSlots.reserve(first + MATCH_SLAB_SIZE);
+    // Pushed in reverse, so the lowest slot is taken first
+    for (std::uint32_t slot = first + MATCH_SLAB_SIZE; slot-- > first;)
+    {
+        matchSlot(slot).slot = slot;
+        freeSlots.push_back(slot);
+    }
+    return true;
+}
+
+ServerShard::ActiveMatch *ServerShard::acquireMatch()
+{
+    if (freeSlots.empty() && !addMatchSlab())
+    {
+        return nullptr;
+    }
+
+    ActiveMatch &active = matchSlot(freeSlots.back());
+    freeSlots.pop_back();
+    occupy(active);
+    return &active;
+}
+
+void ServerShard::occupy(ActiveMatch &active)
+{
+    active.live = true;
+    active.liveIndex = liveSlots.size();
+    liveSlots.push_back(active.slot);
+    active.match.reset(matchIdOf(active));
+    for (int seat = 0; seat < Match::SEATS; ++seat)
+    {
+        active.fds[seat] = -1;
+        active.absentUntil[seat] = std::chrono::steady_clock::time_point::max();
+    }
+    active.deadline = std::chrono::steady_clock::time_point::max();
+    active.action = Action();
+}
+
+void ServerShard::releaseMatch(ActiveMatch &active)
+{
+    // The session and snapshot are let go now; the audience keeps its
+    // capacity for the slot's next match
+    active.session = Session();
+    active.snapshot.reset();
+    active.audience.clear();
+    if (active.pending)
+    {
+        active.pending = false;
+        --pendingMatches;
+    }
+
+    const std::uint32_t moved = liveSlots.back();
+    liveSlots[active.liveIndex] = moved;
+    matchSlot(moved).liveIndex = active.liveIndex;
+    liveSlots.pop_back();
+    active.live = false;
+
+    // The next match here gets a new id, until the sequence numbers wrap
+    const auto shards = static_cast<std::uint32_t>(server.shards.size());
+    const std::uint32_t maxSequence = (UINT32_MAX - 1 - static_cast<std::uint32_t>(index)) / shards;
+    const std::uint32_t useLimit = std::max<std::uint32_t>(1, (maxSequence + 1) >> MATCH_SLOT_BITS);
+    active.uses = (active.uses + 1) % useLimit;
+    freeSlots.push_back(active.slot);
+}
+
+std::uint32_t ServerShard::matchIdOf(const ActiveMatch &active) const
+{
+    // Ids are index + 1 plus a multiple of the shard count, so any shard
+    // can tell which one owns a match. The multiple is the slot, plus the
+    // slot's use count above MATCH_SLOT_BITS, so lookups need no map.
+    const std::uint32_t sequence = (active.uses << MATCH_SLOT_BITS) | active.slot;
+    return static_cast<std::uint32_t>(index) + 1 + sequence * static_cast<std::uint32_t>(server.shards.size());
+}
+
+void ServerShard::handlePlace(Connection &connection, const Frame &frame)
+{
+    ActiveMatch *active = findMatch(connection.matchId);
+    if (!active)
+    {
+        appendError(outbox(connection), ProtocolError::NotInMatch);
+        return;
+    }
+    if (frame.size != FLEET_SIZE)
+    {
+        appendError(outbox(connection), ProtocolError::BadMessage);
+        return;
+    }
+
+    Action action{Action::Kind::Place, connection.seat};
+    std::copy(frame.payload, frame.payload + FLEET_SIZE, action.layout.begin());
+    deliver(*active, action);
+}
+
+void ServerShard::handleFire(Connection &connection, const Frame &frame)
+{
+    ActiveMatch *active = findMatch(connection.matchId);
+    if (!active)
+    {
+        appendError(outbox(connection), ProtocolError::NotInMatch);
+        return;
+    }
+    if (frame.size != 1)
+    {
+        appendError(outbox(connection), ProtocolError::BadMessage);
+        return;
+    }
+
+    Action action{Action::Kind::Fire, connection.seat};
+    action.cell = frame.payload[0];
+    deliver(*active, action);
+}
+
+ServerShard::Session ServerShard::playMatch(ActiveMatch &active)
+{
+    Match &match = active.match;
+
+    // Both fleets, in either order
+    startClock(active);
+    while (match.getPhase() == Match::Phase::Placing)
+    {
+        const Action &action = co_await receive(active);
+        if (action.kind == Action::Kind::Left || action.kind == Action::Kind::TimedOut)
+        {
+            endEarly(active, action);
+            co_return;
+        }
+        const ProtocolError error = action.kind == Action::Kind::Place ? match.place(action.seat, action.layout)
+                                                                         : ProtocolError::NotYourTurn;
+        if (error != ProtocolError::None)
+        {
+            appendError(outbox(active.fds[action.seat]), error);
+        }
+        else if (log)
+        {
+            std::uint8_t record[5 + FLEET_SIZE];
+            putU32(record, match.getId());
+            record[4] = static_cast<std::uint8_t>(action.seat);
+            std::copy(action.layout.begin(), action.layout.end(), record + 5);
+            log->append(LogRecord::Placed, record, sizeof(record));
+        }
+    }
+    active.pending = false;
+    --pendingMatches;
+    eventBuffer.clear();
+    appendStart(eventBuffer);
+    broadcast(active, eventBuffer);
+
+    // Then alternate shots until a fleet is sunk
+    while (true)
+    {
+        startClock(active);
+        Match::ShotOutcome outcome;
+        while (true)
+        {
+            const Action &action = co_await receive(active);
+            if (action.kind == Action::Kind::Left || action.kind == Action::Kind::TimedOut)
+            {
+                endEarly(active, action);
+                co_return;
+            }
+            if (takeShot(active, action, outcome))
+            {
+                break;
+            }
+        }
+
+        if (outcome.gameOver)
+        {
+            eventBuffer.clear();
+            appendGameOver(eventBuffer, match.getWinner(), GameOverReason::FleetSunk);
+            broadcast(active, eventBuffer);
+            logResult(active, GameOverReason::FleetSunk);
+            co_return;
+        }
+    }
+}
+
+bool ServerShard::takeShot(ActiveMatch &active, const Action &action, Match::ShotOutcome &outcome)
+{
+    const ProtocolError error = action.kind == Action::Kind::Fire
+                                    ? active.match.fire(action.seat, action.cell, outcome)
+                                    : ProtocolError::AlreadyPlaced;
+    if (error != ProtocolError::None)
+    {
+        appendError(outbox(active.fds[action.seat]), error);
+        return false;
+    }
+
+    ++stats.shots;
+    if (log)
+    {
+        const PackedShot &shot = active.match.getShot(active.match.getShotCount() - 1);
+        std::uint8_t record[6];
+        putU32(record, active.match.getId());
+        record[4] = shot[0];
+        record[5] = shot[1];
+        log->append(LogRecord::Shot, record, sizeof(record));
+    }
+    eventBuffer.clear();
+    appendShot(eventBuffer, action.seat, action.cell, outcome.result, outcome.sunkShip);
+    broadcast(active, eventBuffer);
+    return true;
+}
+
+void ServerShard::endEarly(ActiveMatch &active, const Action &action)
+{
+    Match &match = active.match;
+    int seat = action.seat;
+    if (action.kind == Action::Kind::TimedOut)
+    {
+        // Whoever the match was waiting for: an unplaced fleet, else the
+        // player to move
+        if (match.getPhase() == Match::Phase::Placing)
+        {
+            seat = match.hasPlaced(0) ? 1 : 0;
+        }
+        else
+        {
+            seat = match.getTurn();
+        }
+        ++stats.matchesTimedOut;
+    }
+    match.forfeit(seat);
+    const GameOverReason reason =
+        action.kind == Action::Kind::TimedOut ? GameOverReason::Timeout : GameOverReason::Forfeit;
+    eventBuffer.clear();
+    appendGameOver(eventBuffer, match.getWinner(), reason);
+    broadcast(active, eventBuffer);
+    logResult(active, reason);
+}
+
+void ServerShard::deliver(ActiveMatch &active, const Action &action)
+{
+    active.action = action;
+    active.session.resume();
+    if (active.session.done())
+    {
+        finishMatch(active.match.getId());
+    }
+}
+
+void ServerShard::startClock(ActiveMatch &active)
+{
+    const std::chrono::seconds timeout = server.options.turnTimeout;
+    active.deadline = timeout.count() > 0 ? loopTime + timeout : std::chrono::steady_clock::time_point::max();
+}
+
+void ServerShard::expireTurns()
+{
+    nextSweep = loopTime + SWEEP_INTERVAL;
+    // Collected first: ending a match takes it out of liveSlots
+    expired.clear();
+    for (std::uint32_t slot : liveSlots)
+    {
+        const ActiveMatch &active = matchSlot(slot);
+        if (active.deadline <= loopTime || active.absentUntil[0] <= loopTime || active.absentUntil[1] <= loopTime)
+        {
+            expired.push_back(active.match.getId());
+        }
+    }
+    for (std::uint32_t matchId : expired)
+    {
+        ActiveMatch *active = findMatch(matchId);
+        if (!active)
+        {
+            continue;
+        }
+        if (active->deadline <= loopTime)
+        {
+            deliver(*active, Action{Action::Kind::TimedOut});
+        }
+        else
+        {
+            // A player who never came back
+            deliver(*active, Action{Action::Kind::Left, active->absentUntil[0] <= loopTime ? 0 : 1});
+        }
+    }
+}
+
+bool ServerShard::sweepDue() const
+{
+    return (server.options.turnTimeout.count() > 0 || server.options.rejoinGrace.count() > 0) &&
+           loopTime >= nextSweep;
+}
+
+int ServerShard::waitTimeout() const
+{
+    if (!spectatorFlushes.empty())
+    {
+        return 0;
+    }
+    if (!throttled.empty())
+    {
+        // Wake for the next tokens
+        return 1;
+    }
+    if ((server.options.turnTimeout.count() == 0 && server.options.rejoinGrace.count() == 0) || liveSlots.empty())
+    {
+        return -1;
+    }
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(nextSweep - std::chrono::steady_clock::now());
+    return static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, remaining.count()));
+}
+
+void ServerShard::handleSpectate(Connection &connection, const Frame &frame)
+{
+    std::uint32_t matchId = 0;
+    if (!readMatchId(frame, matchId))
+    {
+        appendError(outbox(connection), ProtocolError::BadMessage);
+        return;
+    }
+    if (connection.matchId != 0 || connection.inLobby)
+    {
+        appendError(outbox(connection), ProtocolError::AlreadyInMatch);
+        return;
+    }
+
+    if (matchId != 0 && server.ownerOf(matchId) != index)
+    {
+        leaveAudience(connection);
+        connection.move = Move{server.ownerOf(matchId), Move::Reason::Spectate, -1, 0, matchId};
+        return;
+    }
+    startWatching(connection, matchId);
+}
+
+void ServerShard::handleRejoin(Connection &connection, const Frame &frame)
+{
+    std::uint32_t matchId = 0;
+    std::uint32_t token = 0;
+    std::uint16_t since = FULL_VIEW;
+    if (!readRejoin(frame, matchId, token, since) || matchId == 0)
+    {
+        appendError(outbox(connection), ProtocolError::BadMessage);
+        return;
+    }
+    if (connection.matchId != 0 || connection.inLobby)
+    {
+        appendError(outbox(connection), ProtocolError::AlreadyInMatch);
+        return;
+    }
+
+    leaveAudience(connection);
+    if (server.ownerOf(matchId) != index)
+    {
+        Move move{server.ownerOf(matchId), Move::Reason::Rejoin, -1, 0, matchId};
+        move.token = token;
+        move.since = since;
+        connection.move = move;
+        return;
+    }
+    rejoin(connection, matchId, token, since);
+}
+
+void ServerShard::rejoin(Connection &connection, std::uint32_t matchId, std::uint32_t token, std::uint16_t since)
+{
+    ActiveMatch *active = findMatch(matchId);
+    if (!active)
+    {
+        appendError(outbox(connection), ProtocolError::NoSuchMatch);
+        return;
+    }
+    const int seat = token == active->tokens[0] ? 0 : token == active->tokens[1] ? 1 : -1;
+    if (seat < 0)
+    {
+        appendError(outbox(connection), ProtocolError::BadToken);
+        return;
+    }
+
+    // A connection still in the seat is one whose loss the server has not
+    // noticed yet; the token says the player has moved on from it
+    if (active->fds[seat] >= 0)
+    {
+        Connection &stale = connections[static_cast<std::size_t>(active->fds[seat])];
+        stale.matchId = 0;
+        stale.seat = -1;
+        closeConnection(stale);
+    }
+    active->fds[seat] = connection.fd;
+    active->absentUntil[seat] = std::chrono::steady_clock::time_point::max();
+    connection.matchId = matchId;
+    connection.seat = seat;
+
+    // The shots missed, when they take fewer bytes than the whole view
+    const Match &match = active->match;
+    const int shots = match.getShotCount();
+    std::vector<std::uint8_t> &out = outbox(connection);
+    if (since != FULL_VIEW && since <= shots &&
+        FRAME_HEADER_SIZE + 3 + 2 * static_cast<std::size_t>(shots - since) <= viewFrameSize(true))
+    {
+        appendDelta(out, since, match.getStatus(seat), &match.getShot(since), static_cast<std::size_t>(shots - since));
+    }
+    else
+    {
+        appendView(out, match.view(seat));
+    }
+    ++stats.rejoins;
+}
+
+void ServerShard::vacateSeat(ActiveMatch &active, int seat)
+{
+    const std::chrono::seconds grace = server.options.rejoinGrace;
+    if (grace.count() == 0)
+    {
+        deliver(active, Action{Action::Kind::Left, seat});
+        return;
+    }
+    active.fds[seat] = -1;
+    active.absentUntil[seat] = loopTime + grace;
+}
+
+void ServerShard::startWatching(Connection &connection, std::uint32_t matchId)
+{
+    // Following (match 0) stays on this shard and picks up its matches
+    const bool follow = matchId == 0;
+    ActiveMatch *active = findMatch(follow ? newestMatchId : matchId);
+    if (!follow && !active)
+    {
+        appendError(outbox(connection), ProtocolError::NoSuchMatch);
+        return;
+    }
+
+    leaveAudience(connection);
+    ++spectatorCount;
+    connection.following = follow;
+    if (!active)
+    {
+        // Nothing live to follow yet; the next match to start picks it up
+        connection.spectating = true;
+        connection.audienceSlot = idleFollowers.size();
+        idleFollowers.push_back(connection.fd);
+        return;
+    }
+    watch(connection, active->match.getId(), *active);
+}
+
+void ServerShard::finishMatch(std::uint32_t matchId)
+{
+    ActiveMatch *active = findMatch(matchId);
+    if (!active)
+    {
+        return;
+    }
+    for (int fd : active->fds)
+    {
+        if (fd < 0)
+        {
+            continue;
+        }
+        Connection &player = connections[static_cast<std::size_t>(fd)];
+        if (player.open && player.matchId == matchId)
+        {
+            player.matchId = 0;
+            player.seat = -1;
+        }
+    }
+    for (int fd : active->audience)
+    {
+        Connection &spectator = connections[static_cast<std::size_t>(fd)];
+        spectator.watching = 0;
+        if (spectator.following)
+        {
+            spectator.audienceSlot = idleFollowers.size();
+            idleFollowers.push_back(fd);
+        }
+        else
+        {
+            spectator.spectating = false;
+            --spectatorCount;
+        }
+    }
+    releaseMatch(*active);
+    ++stats.matchesFinished;
+}
+
+bool ServerShard::recover(std::size_t &restored)
+{
+    restored = 0;
+    if (!log)
+    {
+        return true;
+    }
+    loopTime = std::chrono::steady_clock::now();
+    if (!log->replay([this](LogRecord type, const std::uint8_t *payload, std::size_t size)
+                     { restore(type, payload, size); }))
+    {
+        return false;
+    }
+
+    // A match whose last shot made it to disk without its Ended is over.
+    // Without a rejoin grace nobody could come back to the rest.
+    const std::chrono::seconds grace = server.options.rejoinGrace;
+    expired.clear();
+    for (std::uint32_t slot : liveSlots)
+    {
+        if (grace.count() == 0 || matchSlot(slot).match.getPhase() == Match::Phase::Finished)
+        {
+            expired.push_back(slot);
+        }
+    }
+    for (std::uint32_t slot : expired)
+    {
+        ActiveMatch &active = matchSlot(slot);
+        if (active.match.getPhase() == Match::Phase::Finished)
+        {
+            logResult(active, GameOverReason::FleetSunk);
+        }
+        else
+        {
+            std::uint8_t record[4];
+            putU32(record, active.match.getId());
+            log->append(LogRecord::Ended, record, sizeof(record));
+        }
+        releaseMatch(active);
+    }
+    if (grace.count() == 0 && !expired.empty())
+    {
+        std::cerr << "Abandoned " << expired.size() << " matches in progress on shard " << index
+                  << "; --rejoin-grace 0 leaves their players no way back" << std::endl;
+    }
+
+    // Slots were claimed out of order; the rest are free, lowest first
+    freeSlots.clear();
+    for (auto slot = static_cast<std::uint32_t>(matchSlabs.size() * MATCH_SLAB_SIZE); slot-- > 0;)
+    {
+        if (!matchSlot(slot).live)
+        {
+            freeSlots.push_back(slot);
+        }
+    }
+
+    // Both seats are empty until their players Rejoin. playMatch counts a
+    // match out of pendingMatches once its fleets are placed.
+    for (std::uint32_t slot : liveSlots)
+    {
+        ActiveMatch &active = matchSlot(slot);
+        for (auto &until : active.absentUntil)
+        {
+            until = loopTime + grace;
+        }
+        newestMatchId = active.match.getId();
+        active.pending = true;
+        ++pendingMatches;
+        active.session = playMatch(active);
+    }
+    restored = liveSlots.size();
+    writeCheckpoint();
+    log->submit();
+    return true;
+}
+
+void ServerShard::restore(LogRecord type, const std::uint8_t *payload, std::size_t size)
+{
+    const std::uint32_t matchId = size >= 4 ? getU32(payload) : 0;
+    ActiveMatch *active = nullptr;
+    switch (type)
+    {
+    case LogRecord::Started:
+        if (size == 12 && (active = claimMatch(matchId)))
+        {
+            active->tokens[0] = getU32(payload + 4);
+            active->tokens[1] = getU32(payload + 8);
+        }
+        break;
+    case LogRecord::Placed:
+        if (size == 5 + FLEET_SIZE && payload[4] < Match::SEATS && (active = findMatch(matchId)))
+        {
+            FleetLayout layout;
+            std::copy(payload + 5, payload + 5 + FLEET_SIZE, layout.begin());
+            active->match.place(payload[4], layout);
+        }
+        break;
+    case LogRecord::Shot:
+        if (size == 6 && (active = findMatch(matchId)))
+        {
+            const ShotRecord shot = unpackShot(PackedShot{payload[4], payload[5]});
+            Match::ShotOutcome outcome;
+            active->match.fire(shot.seat, shot.cell, outcome);
+        }
+        break;
+    case LogRecord::Ended:
+        if ((active = findMatch(matchId)))
+        {
+            releaseMatch(*active);
+        }
+        break;
+    case LogRecord::CheckpointBegin:
+    {
+        // The checkpoint describes every match, so whatever was replayed
+        // before it goes
+        const std::size_t slots = size / 4;
+        while (matchSlabs.size() * MATCH_SLAB_SIZE < slots && addMatchSlab())
+        {
+        }
+        for (std::uint32_t slot = 0; slot < slots && slot < matchSlabs.size() * MATCH_SLAB_SIZE; ++slot)
+        {
+            ActiveMatch &emptied = matchSlot(slot);
+            if (emptied.live)
+            {
+                releaseMatch(emptied);
+            }
+            emptied.uses = getU32(payload + 4 * slot);
+        }
+        break;
+    }
+    case LogRecord::Live:
+    {
+        if (size < 15 || !(active = claimMatch(matchId)))
+        {
+            break;
+        }
+        active->tokens[0] = getU32(payload + 4);
+        active->tokens[1] = getU32(payload + 8);
+        std::size_t offset = 13;
+        for (int seat = 0; seat < Match::SEATS; ++seat)
+        {
+            if ((payload[12] & (1 << seat)) && offset + FLEET_SIZE <= size)
+            {
+                FleetLayout layout;
+                std::copy(payload + offset, payload + offset + FLEET_SIZE, layout.begin());
+                active->match.place(seat, layout);
+                offset += FLEET_SIZE;
+            }
+        }
+        const std::size_t shots = offset + 2 <= size ? payload[offset] | payload[offset + 1] << 8 : 0;
+        offset += 2;
+        for (std::size_t i = 0; i < shots && offset + 2 <= size; ++i, offset += 2)
+        {
+            const ShotRecord shot = unpackShot(PackedShot{payload[offset], payload[offset + 1]});
+            Match::ShotOutcome outcome;
+            active->match.fire(shot.seat, shot.cell, outcome);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+ServerShard::ActiveMatch *ServerShard::claimMatch(std::uint32_t matchId)
+{
+    if (matchId == 0 || server.ownerOf(matchId) != index)
+    {
+        return nullptr;
+    }
+    // The inverse of matchIdOf
+    const std::uint32_t sequence = (matchId - 1) / static_cast<std::uint32_t>(server.shards.size());
+    const std::uint32_t slot = sequence % MAX_MATCH_SLOTS;
+    while (slot >= matchSlabs.size() * MATCH_SLAB_SIZE)
+    {
+        if (!addMatchSlab())
+        {
+            return nullptr;
+        }
+    }
+    ActiveMatch &active = matchSlot(slot);
+    if (active.live)
+    {
+        releaseMatch(active);
+    }
+    active.uses = sequence >> MATCH_SLOT_BITS;
+    occupy(active);
+    return &active;
+}
+
+void ServerShard::logResult(const ActiveMatch &active, GameOverReason reason)
+{
+    if (!log)
+    {
+        return;
+    }
+    const Match &match = active.match;
+    std::uint8_t ended[4];
+    putU32(ended, match.getId());
+    log->append(LogRecord::Ended, ended, sizeof(ended));
+
+    logRecord.resize(6);
+    putU32(logRecord.data(), match.getId());
+    logRecord[4] = static_cast<std::uint8_t>(match.getWinner());
+    logRecord[5] = static_cast<std::uint8_t>(reason);
+    // The View payload without its frame header
+    const std::size_t view = logRecord.size();
+    appendView(logRecord, match.view(-1));
+    logRecord.erase(logRecord.begin() + static_cast<std::ptrdiff_t>(view),
+                    logRecord.begin() + static_cast<std::ptrdiff_t>(view + FRAME_HEADER_SIZE));
+    log->appendResult(logRecord.data(), logRecord.size());
+}
+
+void ServerShard::submitLog()
+{
+    if (!log)
+    {
+        return;
+    }
+    if (log->checkpointDue())
+    {
+        writeCheckpoint();
+    }
+    log->submit();
+}
+
+void ServerShard::writeCheckpoint()
+{
+    log->beginCheckpoint();
+    const std::size_t slots = matchSlabs.size() * MATCH_SLAB_SIZE;
+    logRecord.resize(4 * slots);
+    for (std::uint32_t slot = 0; slot < slots; ++slot)
+    {
+        putU32(logRecord.data() + 4 * slot, matchSlot(slot).uses);
+    }
+    log->append(LogRecord::CheckpointBegin, logRecord.data(), logRecord.size());
+
+    for (std::uint32_t slot : liveSlots)
+    {
+        const ActiveMatch &active = matchSlot(slot);
+        const Match &match = active.match;
+        logRecord.resize(13);
+        putU32(logRecord.data(), match.getId());
+        putU32(logRecord.data() + 4, active.tokens[0]);
+        putU32(logRecord.data() + 8, active.tokens[1]);
+        logRecord[12] = 0;
+        for (int seat = 0; seat < Match::SEATS; ++seat)
+        {
+            if (match.hasPlaced(seat))
+            {
+                logRecord[12] = static_cast<std::uint8_t>(logRecord[12] | 1 << seat);
+                logRecord.insert(logRecord.end(), match.getLayout(seat).begin(), match.getLayout(seat).end());
+            }
+        }
+        const int shots = match.getShotCount();
+        logRecord.push_back(static_cast<std::uint8_t>(shots));
+        logRecord.push_back(static_cast<std::uint8_t>(shots >> 8));
+        for (int i = 0; i < shots; ++i)
+        {
+            logRecord.insert(logRecord.end(), match.getShot(i).begin(), match.getShot(i).end());
+        }
+        log->append(LogRecord::Live, logRecord.data(), logRecord.size());
+    }
+    log->append(LogRecord::CheckpointEnd, nullptr, 0);
+}
+
+void ServerShard::broadcast(ActiveMatch &active, const std::vector<std::uint8_t> &event)
+{
+    // Frames are a few bytes, so the seats get a copy in their own queue
+    for (int fd : active.fds)
+    {
+        if (fd < 0)
+        {
+            continue;
+        }
+        Connection &player = connections[static_cast<std::size_t>(fd)];
+        if (player.open)
+        {
+            std::vector<std::uint8_t> &out = outbox(player);
+            out.insert(out.end(), event.begin(), event.end());
+        }
+    }
+
+    if (!active.audience.empty())
+    {
+        const SharedBytes shared = std::make_shared<const std::vector<std::uint8_t>>(event);
+        stats.spectatorEvents += active.audience.size();
+        // Backwards, so a spectator dropped mid-loop is swapped out for one
+        // already served
+        for (std::size_t i = active.audience.size(); i-- > 0;)
+        {
+            queueShared(connections[static_cast<std::size_t>(active.audience[i])], shared, &active);
+        }
+    }
+
+    active.snapshot.reset();
+}
+
+void ServerShard::watch(Connection &spectator, std::uint32_t matchId, ActiveMatch &active)
+{
+    spectator.spectating = true;
+    spectator.watching = matchId;
+    spectator.audienceSlot = active.audience.size();
+    active.audience.push_back(spectator.fd);
+    queueShared(spectator, snapshot(active), nullptr);
+}
+
+void ServerShard::leaveAudience(Connection &spectator)
+{
+    if (!spectator.spectating)
+    {
+        return;
+    }
+
+    std::vector<int> &audience = spectator.watching != 0 ? findMatch(spectator.watching)->audience : idleFollowers;
+    const int moved = audience.back();
+    audience[spectator.audienceSlot] = moved;
+    connections[static_cast<std::size_t>(moved)].audienceSlot = spectator.audienceSlot;
+    audience.pop_back();
+
+    spectator.spectating = false;
+    spectator.following = false;
+    spectator.watching = 0;
+    --spectatorCount;
+}
+
+const ServerShard::SharedBytes &ServerShard::snapshot(ActiveMatch &active)
+{
+    // Shared by every spectator that joins or skips ahead before the next event
+    if (!active.snapshot)
+    {
+        std::vector<std::uint8_t> bytes;
+        bytes.reserve(FRAME_HEADER_SIZE + 4 + viewFrameSize(false));
+        appendWatching(bytes, active.match.getId());
+        appendView(bytes, active.match.view(-1));
+        active.snapshot = std::make_shared<const std::vector<std::uint8_t>>(std::move(bytes));
+    }
+    return active.snapshot;
+}
+
+void ServerShard::queueShared(Connection &spectator, const SharedBytes &chunk, ActiveMatch *active)
+{
+    if (!spectator.open)
+    {
+        return;
+    }
+
+    // Private bytes (pongs, errors) become a chunk of their own so they
+    // keep their place in the stream
+    std::vector<std::uint8_t> &out = outbox(spectator);
+    if (spectator.outOffset < out.size())
+    {
+        auto sealed = std::make_shared<const std::vector<std::uint8_t>>(
+            out.begin() + static_cast<std::ptrdiff_t>(spectator.outOffset), out.end());
+        spectator.queuedBytes += sealed->size();
+        spectator.queued.push_back(std::move(sealed));
+        out.clear();
+        spectator.outOffset = 0;
+    }
+
+    if (active && pendingOutput(spectator) + chunk->size() > SPECTATOR_BACKLOG)
+    {
+        skipAhead(spectator, *active);
+        if (!spectator.open)
+        {
+            return;
+        }
+    }
+    spectator.queued.push_back(chunk);
+    spectator.queuedBytes += chunk->size();
+}
+
+void ServerShard::skipAhead(Connection &spectator, ActiveMatch &active)
+{
+    // Still stuck since the last skip: the reader is gone, not just slow
+    if (spectator.stalled)
+    {
+        ++stats.spectatorsDropped;
+        closeConnection(spectator);
+        return;
+    }
+
+    // A partly written chunk stays so the stream remains frame aligned
+    const std::size_t keep = spectator.queuedOffset > 0 ? 1 : 0;
+    while (spectator.queued.size() > keep)
+    {
+        spectator.queuedBytes -= spectator.queued.back()->size();
+        spectator.queued.pop_back();
+    }
+    const SharedBytes &fresh = snapshot(active);
+    spectator.queued.push_back(fresh);
+    spectator.queuedBytes += fresh->size();
+    spectator.stalled = true;
+    ++stats.spectatorSkips;
+}
+
+std::vector<std::uint8_t> &ServerShard::outbox(Connection &connection)
+{
+    if (!connection.dirty)
+    {
+        connection.dirty = true;
+        if (connection.spectating)
+        {
+            spectatorFlushes.push_back(eventKey(connection.fd, connection.generation));
+        }
+        else
+        {
+            dirtyFds.push_back(connection.fd);
+        }
+    }
+    return connection.out;
+}
+
+void ServerShard::flushDirty()
+{
+    // Indexed loop: closing a connection can queue a forfeit notice for its
+    // opponent, which appends to dirtyFds
+    for (std::size_t i = 0; i < dirtyFds.size(); ++i)
+    {
+        Connection &connection = connections[static_cast<std::size_t>(dirtyFds[i])];
+        connection.dirty = false;
+        if (connection.open)
+        {
+            flush(connection);
+        }
+    }
+    dirtyFds.clear();
+
+    for (std::size_t flushed = 0; flushed < SPECTATOR_FLUSH_BUDGET && !spectatorFlushes.empty(); ++flushed)
+    {
+        const std::uint64_t key = spectatorFlushes.front();
+        spectatorFlushes.pop_front();
+        Connection &connection = connections[static_cast<std::size_t>(key & 0xFFFFFFFFu)];
+        if (connection.open && connection.generation == static_cast<std::uint32_t>(key >> 32))
+        {
+            connection.dirty = false;
+            flush(connection);
+        }
+    }
+}
+
+std::size_t ServerShard::pendingOutput(const Connection &connection) const
+{
+    return connection.queuedBytes + connection.out.size() - connection.outOffset +
+           (connection.sending ? connection.sending->remaining : 0);
+}
+
+void ServerShard::flush(Connection &connection)
+{
+    if (ring)
+    {
+        sendWithRing(connection);
+        return;
+    }
+
+    while (pendingOutput(connection) > 0)
+    {
+        // One sendmsg covers the shared chunks and the private tail
+        iovec parts[MAX_IOVECS];
+        int count = 0;
+        std::size_t offset = connection.queuedOffset;
+        for (const SharedBytes &chunk : connection.queued)
+        {
+            if (count == MAX_IOVECS)
+            {
+                break;
+            }
+            parts[count].iov_base = const_cast<std::uint8_t *>(chunk->data() + offset);
+            parts[count].iov_len = chunk->size() - offset;
+            ++count;
+            offset = 0;
+        }
+        if (count < MAX_IOVECS && connection.outOffset < connection.out.size())
+        {
+            parts[count].iov_base = connection.out.data() + connection.outOffset;
+            parts[count].iov_len = connection.out.size() - connection.outOffset;
+            ++count;
+        }
+
+        msghdr message{};
+        message.msg_iov = parts;
+        message.msg_iovlen = static_cast<std::size_t>(count);
+        ssize_t sent = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            closeConnection(connection);
+            return;
+        }
+        consumeOutput(connection, static_cast<std::size_t>(sent));
+        stats.bytesOut += static_cast<std::uint64_t>(sent);
+        Metrics::add(Counter::BytesOut, static_cast<std::uint64_t>(sent));
+    }
+
+    if (pendingOutput(connection) == 0)
+    {
+        connection.out.clear();
+        connection.outOffset = 0;
+        updateInterest(connection, false);
+    }
+    else if (pendingOutput(connection) > MAX_PENDING_OUTPUT)
+    {
+        ++stats.clientsShed;
+        closeConnection(connection);
+    }
+    else
+    {
+        updateInterest(connection, true);
+    }
+}
+
+void ServerShard::consumeOutput(Connection &connection, std::size_t sent)
+{
+    if (sent > 0)
+    {
+        connection.stalled = false;
+    }
+    while (sent > 0 && !connection.queued.empty())
+    {
+        const std::size_t remaining = connection.queued.front()->size() - connection.queuedOffset;
+        if (sent < remaining)
+        {
+            connection.queuedOffset += sent;
+            connection.queuedBytes -= sent;
+            return;
+        }
+        sent -= remaining;
+        connection.queuedBytes -= remaining;
+        connection.queued.pop_front();
+        connection.queuedOffset = 0;
+    }
+    connection.outOffset += sent;
+}
+
+void ServerShard::updateInterest(Connection &connection, bool wantWrite)
+{
+    if (connection.wantWrite == wantWrite)
+    {
+        return;
+    }
+    connection.wantWrite = wantWrite;
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? EPOLLOUT : 0u);
+    event.data.u64 = eventKey(connection.fd, connection.generation);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void ServerShard::closeConnection(Connection &connection)
+{
+    if (!connection.open)
+    {
+        return;
+    }
+    connection.open = false;
+    --connectionCount;
+    Metrics::add(Counter::ConnectionsClosed);
+
+    if (connection.inLobby)
+    {
+        server.leaveLobby(GameServer::Seat{index, connection.fd, connection.generation});
+    }
+    leaveAudience(connection);
+
+    if (ActiveMatch *active = findMatch(connection.matchId))
+    {
+        vacateSeat(*active, connection.seat);
+    }
+
+    if (ring)
+    {
+        // A send still in flight is released when it completes. Shutting
+        // the socket down ends the multishot recv, which holds a reference
+        // of its own that close() would leave open.
+        if (connection.sending)
+        {
+            connection.sending->orphaned = true;
+            connection.sending = nullptr;
+        }
+        connection.receiving = false;
+        shutdown(connection.fd, SHUT_RDWR);
+    }
+    else
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    }
+    close(connection.fd);
+    connection.in.clear();
+    connection.in.shrink_to_fit();
+    connection.out.clear();
+    connection.out.shrink_to_fit();
+    connection.queued.clear();
+    connection.queued.shrink_to_fit();
+    connection.queuedBytes = 0;
+    connection.queuedOffset = 0;
+}
+
+void ServerShard::runRing()
+{
+    // The ring starts disabled so that this thread, rather than the one
+    // that called start(), becomes its only submitter
+    if (!ring->enable() || !armAccept() || !armWake())
+    {
+        std::cerr << "io_uring: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    while (true)
+    {
+        // One system call submits the last batch's sends and re-arms, and
+        // collects the next batch
+        if (!ring->submitAndWait(waitTimeout()))
+        {
+            std::cerr << "io_uring_enter: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        loopTime = std::chrono::steady_clock::now();
+        behindSince = loopTime;
+
+        bool running = true;
+        ring->forEachCompletion([this, &running](const io_uring_cqe &cqe) { running = complete(cqe) && running; });
+        if (!running)
+        {
+            return;
+        }
+
+        for (std::uint64_t key : receivesToArm)
+        {
+            Connection &connection = connections[static_cast<std::size_t>(key & 0xFFFFFFFFu)];
+            if (connection.open && (connection.generation & GENERATION_MASK) == key >> 32 &&
+                !connection.receiving && !armReceive(connection))
+            {
+                closeConnection(connection);
+            }
+        }
+        receivesToArm.clear();
+        if (sweepDue())
+        {
+            expireTurns();
+        }
+        resumeThrottled();
+        flushDirty();
+        submitLog();
+        // Every completion ready is reaped at once, so each batch starts
+        // caught up
+        checkLoad(false);
+    }
+}
+
+bool ServerShard::complete(const io_uring_cqe &cqe)
+{
+    switch (static_cast<Operation>(cqe.user_data >> 56))
+    {
+    case Operation::Accept:
+        if (cqe.res >= 0)
+        {
+            openConnection(cqe.res);
+        }
+        else if (cqe.res != -EAGAIN && cqe.res != -EINTR && cqe.res != -ECANCELED)
+        {
+            std::cerr << "accept: " << std::strerror(-cqe.res) << std::endl;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            armAccept();
+        }
+        break;
+    case Operation::Wake:
+        if (server.stopping.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        drainInbox();
+        armWake();
+        break;
+    case Operation::Receive:
+        completeReceive(cqe);
+        break;
+    case Operation::Send:
+        completeSend(*reinterpret_cast<UringSend *>(cqe.user_data & PAYLOAD_MASK), cqe.res);
+        break;
+    case Operation::Cancel:
+        break;
+    }
+    return true;
+}
+
+void ServerShard::completeReceive(const io_uring_cqe &cqe)
+{
+    const auto fd = static_cast<std::size_t>(cqe.user_data & 0xFFFFFFFFu);
+    const auto generation = static_cast<std::uint32_t>((cqe.user_data & PAYLOAD_MASK) >> 32);
+    const auto bufferId = static_cast<unsigned>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+    // Completions for a connection that has since closed or moved only
+    // return their buffer
+    Connection *connection = fd < connections.size() ? &connections[fd] : nullptr;
+    if (connection && (!connection->open || (connection->generation & GENERATION_MASK) != generation))
+    {
+        connection = nullptr;
+    }
+
+    if (connection)
+    {
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            connection->receiving = false;
+        }
+        if (cqe.res > 0)
+        {
+            stats.bytesIn += static_cast<std::uint64_t>(cqe.res);
+            Metrics::add(Counter::BytesIn, static_cast<std::uint64_t>(cqe.res));
+            parseInput(*connection, ring->buffer(bufferId), static_cast<std::size_t>(cqe.res));
+        }
+        else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED && !connection->move)
+        {
+            // A connection on its way to another shard is closed there
+            closeConnection(*connection);
+        }
+    }
+    if (cqe.flags & IORING_CQE_F_BUFFER)
+    {
+        ring->recycleBuffer(bufferId);
+    }
+
+    if (connection && connection->open && !connection->receiving)
+    {
+        if (connection->move)
+        {
+            migrate(*connection);
+        }
+        else
+        {
+            receivesToArm.push_back(eventKey(connection->fd, generation));
+        }
+    }
+}
+
+void ServerShard::completeSend(UringSend &send, int result)
+{
+    if (send.orphaned)
+    {
+        releaseSend(send);
+        return;
+    }
+
+    Connection &connection = connections[static_cast<std::size_t>(send.fd)];
+    auto sent = static_cast<std::size_t>(std::max(result, 0));
+    if (sent > 0)
+    {
+        stats.bytesOut += sent;
+        Metrics::add(Counter::BytesOut, sent);
+        connection.stalled = false;
+    }
+    if (result > 0 && sent < send.remaining)
+    {
+        // Short write; the rest goes before anything queued since
+        send.remaining -= sent;
+        while (sent >= send.parts[send.first].iov_len)
+        {
+            sent -= send.parts[send.first].iov_len;
+            ++send.first;
+        }
+        send.parts[send.first].iov_base = static_cast<std::uint8_t *>(send.parts[send.first].iov_base) + sent;
+        send.parts[send.first].iov_len -= sent;
+        submitSend(send);
+        return;
+    }
+
+    connection.sending = nullptr;
+    releaseSend(send);
+    if (connection.move)
+    {
+        migrate(connection);
+    }
+    else if (result <= 0)
+    {
+        closeConnection(connection);
+    }
+    else if (pendingOutput(connection) > 0)
+    {
+        // Queued while this send was in flight; goes out with the batch
+        outbox(connection);
+    }
+}
+
+bool ServerShard::armAccept()
+{
+    io_uring_sqe *sqe = ring->getSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = ringKey(Operation::Accept, 0);
+    return true;
+}
+
+bool ServerShard::armWake()
+{
+    io_uring_sqe *sqe = ring->getSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeFd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&wakeCount);
+    sqe->len = sizeof(wakeCount);
+    sqe->user_data = ringKey(Operation::Wake, 0);
+    return true;
+}
+
+bool ServerShard::armReceive(Connection &connection)
+{
+    io_uring_sqe *sqe = ring->getSqe();
+    if (!sqe)
+    {
+        return false;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection.fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = IoUring::BUFFER_GROUP;
+    sqe->user_data = receiveKey(connection.fd, connection.generation);
+    connection.receiving = true;
+    return true;
+}
+
+void ServerShard::sendWithRing(Connection &connection)
+{
+    // One send at a time keeps the stream in order. Output queued meanwhile
+    // goes out when it completes, and a connection about to move takes its
+    // output along.
+    if (connection.sending || connection.move)
+    {
+        if (pendingOutput(connection) > MAX_PENDING_OUTPUT)
+        {
+            ++stats.clientsShed;
+            closeConnection(connection);
+        }
+        return;
+    }
+    if (pendingOutput(connection) == 0)
+    {
+        return;
+    }
+
+    // The send takes the chunks and the private tail, so the connection
+    // can queue more while the kernel holds these
+    UringSend &send = acquireSend();
+    send.fd = connection.fd;
+    while (!connection.queued.empty() && send.count < MAX_IOVECS)
+    {
+        SharedBytes &chunk = connection.queued.front();
+        send.parts[send.count].iov_base = const_cast<std::uint8_t *>(chunk->data());
+        send.parts[send.count].iov_len = chunk->size();
+        ++send.count;
+        send.remaining += chunk->size();
+        connection.queuedBytes -= chunk->size();
+        send.chunks.push_back(std::move(chunk));
+        connection.queued.pop_front();
+    }
+    if (connection.queued.empty() && send.count < MAX_IOVECS && !connection.out.empty())
+    {
+        send.tail.swap(connection.out);
+        send.parts[send.count].iov_base = send.tail.data();
+        send.parts[send.count].iov_len = send.tail.size();
+        ++send.count;
+        send.remaining += send.tail.size();
+    }
+    connection.sending = &send;
+    submitSend(send);
+}
+
+void ServerShard::submitSend(UringSend &send)
+{
+    io_uring_sqe *sqe = ring->getSqe();
+    if (!sqe)
+    {
+        completeSend(send, -errno);
+        return;
+    }
+    send.message.msg_iov = send.parts + send.first;
+    send.message.msg_iovlen = static_cast<std::size_t>(send.count - send.first);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = send.fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&send.message);
+    sqe->len = 1;
+    // The kernel retries a short write itself, so the completion normally
+    // covers everything
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = ringKey(Operation::Send, reinterpret_cast<std::uintptr_t>(&send));
+}
+
+ServerShard::UringSend &ServerShard::acquireSend()
+{
+    if (idleSends.empty())
+    {
+        sends.push_back(std::make_unique<UringSend>());
+        idleSends.push_back(sends.back().get());
+    }
+    UringSend &send = *idleSends.back();
+    idleSends.pop_back();
+    return send;
+}
+
+void ServerShard::releaseSend(UringSend &send)
+{
+    // The tail keeps its capacity for the next connection that swaps it in
+    send.orphaned = false;
+    send.chunks.clear();
+    send.tail.clear();
+    send.first = 0;
+    send.count = 0;
+    send.remaining = 0;
+    idleSends.push_back(&send);
+}
+
+void ServerShard::post(Handoff handoff)
+{
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        inbox.push_back(std::move(handoff));
+    }
+    wake();
+}
+
+void ServerShard::drainInbox()
+{
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        arrivals.swap(inbox);
+    }
+    for (Handoff &handoff : arrivals)
+    {
+        adopt(handoff);
+    }
+    arrivals.clear();
+}
+
+void ServerShard::migrate(Connection &connection)
+{
+    if (ring)
+    {
+        // The socket is handed over once this ring is done with it: the
+        // recv cancelled and any send in flight complete. Both completions
+        // come back here.
+        if (connection.receiving)
+        {
+            if (!connection.cancelling)
+            {
+                io_uring_sqe *sqe = ring->getSqe();
+                if (!sqe)
+                {
+                    closeConnection(connection);
+                    return;
+                }
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = receiveKey(connection.fd, connection.generation);
+                sqe->user_data = ringKey(Operation::Cancel, 0);
+                connection.cancelling = true;
+            }
+            return;
+        }
+        if (connection.sending)
+        {
+            return;
+        }
+    }
+    else
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    }
+    --connectionCount;
+    ++stats.connectionsMigrated;
+
+    // The slot keeps its generation, so stale events and queued flushes for
+    // the fd are ignored here
+    const std::uint32_t generation = connection.generation;
+    Handoff handoff{*connection.move, std::move(connection)};
+    connection = Connection();
+    connection.fd = handoff.connection.fd;
+    connection.generation = generation;
+
+    server.shards[handoff.move.shard]->post(std::move(handoff));
+}
+
+void ServerShard::adopt(Handoff &handoff)
+{
+    const int fd = handoff.connection.fd;
+    if (static_cast<std::size_t>(fd) >= connections.size())
+    {
+        connections.resize(static_cast<std::size_t>(fd) + 1);
+    }
+    Connection &connection = connections[static_cast<std::size_t>(fd)];
+    const std::uint32_t generation = connection.generation + 1;
+    connection = std::move(handoff.connection);
+    connection.generation = generation;
+    connection.move.reset();
+    connection.dirty = false;
+    connection.wantWrite = false;
+    connection.cancelling = false;
+    connection.throttled = false;
+    if (!watchInput(connection))
+    {
+        connection.open = false;
+        close(fd);
+        return;
+    }
+    ++connectionCount;
+
+    const Move &move = handoff.move;
+    if (move.reason == Move::Reason::Pair)
+    {
+        // The waiting player may have left while this one was in transit,
+        // in which case this one goes back to the lobby
+        const auto slot = static_cast<std::size_t>(move.partnerFd);
+        if (slot < connections.size() && connections[slot].open &&
+            connections[slot].generation == move.partnerGeneration && connections[slot].inLobby)
+        {
+            startMatch(connections[slot], connection);
+        }
+        else
+        {
+            handleJoin(connection);
+        }
+    }
+    else if (move.reason == Move::Reason::Rejoin)
+    {
+        rejoin(connection, move.matchId, move.token, move.since);
+    }
+    else
+    {
+        startWatching(connection, move.matchId);
+    }
+
+    if (connection.move)
+    {
+        migrate(connection);
+        return;
+    }
+    // Frames that arrived behind the one that moved it, and any output it
+    // still owes
+    if (!connection.in.empty())
+    {
+        parseInput(connection, nullptr, 0);
+    }
+    if (connection.open)
+    {
+        outbox(connection);
+    }
+}
@@ -0,0 +1,445 @@
+#pragma once
+
+#include "FramePool.h"
+#include "IoUring.h"
+#include "LatencyHistogram.h"
+#include "Match.h"
+#include "MatchLog.h"
+#include "Protocol.h"
+#include "Random.h"
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class GameServer;
+
+// Totals for one shard; GameServer adds them up
+struct ServerStats
+{
+    std::uint64_t connectionsAccepted = 0;
+    std::uint64_t connectionsMigrated = 0;
+    std::uint64_t matchesStarted = 0;
+    std::uint64_t matchesFinished = 0;
+    std::uint64_t shots = 0;
+    std::uint64_t framesIn = 0;
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t spectatorEvents = 0;
+    std::uint64_t spectatorSkips = 0;
+    std::uint64_t spectatorsDropped = 0;
+    std::uint64_t matchesTimedOut = 0;
+    std::uint64_t rejoins = 0;
+    // Joins answered with Overloaded
+    std::uint64_t joinsRefused = 0;
+    // Times a client ran out of message budget with frames to handle
+    std::uint64_t clientsThrottled = 0;
+    // Clients dropped for a backlog past MAX_PENDING_INPUT or
+    // MAX_PENDING_OUTPUT
+    std::uint64_t clientsShed = 0;
+    // Nanoseconds from the start of each batch of events, or of a run of
+    // full batches, to the end of its replies: about the longest a client
+    // with a frame waiting went unserved
+    LatencyHistogram loopLag;
+    // Match coroutine frames taken from the heap rather than the pool
+    std::uint64_t sessionAllocations = 0;
+    // Every heap allocation made on the shard's thread while it ran
+    std::uint64_t heapAllocations = 0;
+
+    ServerStats &operator+=(const ServerStats &other);
+};
+
+// One event loop of fleet_server (epoll or io_uring) on its own thread. It
+// owns its connections and matches, each match a coroutine (playMatch), so
+// nothing on the shot path is shared between shards. Linux only.
+class ServerShard
+{
+public:
+    ServerShard(GameServer &server, std::size_t index);
+    ~ServerShard();
+
+    ServerShard(const ServerShard &) = delete;
+    ServerShard &operator=(const ServerShard &) = delete;
+
+    // Binds this shard's listening socket; false (with a message on stderr)
+    // on failure
+    bool start(const std::string &host, std::uint16_t port, int backlog);
+    // Rebuilds the matches the log holds and checkpoints them; call after
+    // start() and before run(). False (with a message on stderr) when the
+    // log cannot be read.
+    bool recover(std::size_t &restored);
+    // Serves until GameServer::stop()
+    void run();
+    // Interrupts epoll_wait. Safe to call from a signal handler or another
+    // shard's thread.
+    void wake();
+
+    const ServerStats &getStats() const { return stats; }
+    std::size_t getConnectionCount() const { return connectionCount; }
+    std::size_t getMatchCount() const { return liveSlots.size(); }
+    std::size_t getSpectatorCount() const { return spectatorCount; }
+
+private:
+    using SharedBytes = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+    static constexpr std::uint32_t MATCH_SLAB_SIZE = 256;
+    // Slot numbers take the low bits of a match's sequence number
+    static constexpr std::uint32_t MATCH_SLOT_BITS = 16;
+    static constexpr std::uint32_t MAX_MATCH_SLOTS = std::uint32_t{1} << MATCH_SLOT_BITS;
+
+    // Output handed to the kernel in one io_uring sendmsg
+    struct UringSend;
+
+    // Why a connection is moving to another shard
+    struct Move
+    {
+        enum class Reason
+        {
+            // Paired with the player waiting there
+            Pair,
+            // Watching a match that lives there
+            Spectate,
+            // Taking back a seat in a match that lives there
+            Rejoin
+        };
+
+        std::size_t shard = 0;
+        Reason reason = Reason::Pair;
+        int partnerFd = -1;
+        std::uint32_t partnerGeneration = 0;
+        std::uint32_t matchId = 0;
+        std::uint32_t token = 0;
+        std::uint16_t since = FULL_VIEW;
+    };
+
+    struct Connection
+    {
+        int fd = -1;
+        std::uint32_t generation = 0;
+        std::vector<std::uint8_t> in;
+        // Message budget; refilled lazily when it runs out
+        double tokens = 0;
+        std::chrono::steady_clock::time_point refilledAt;
+        // Out of tokens with frames waiting in in
+        bool throttled = false;
+        // Output goes out as the shared chunks in queued, then the private
+        // bytes in out
+        std::deque<SharedBytes> queued;
+        std::size_t queuedOffset = 0;
+        std::size_t queuedBytes = 0;
+        std::vector<std::uint8_t> out;
+        std::size_t outOffset = 0;
+        std::uint32_t matchId = 0;
+        int seat = -1;
+        // Waiting in the lobby, or taken from it by a shard that has not
+        // handed over the opponent yet
+        bool inLobby = false;
+        // Set while handling a frame; carried out once the read is done
+        std::optional<Move> move;
+        // Spectators sit in their match's audience, or in idleFollowers
+        // between matches when following
+        std::uint32_t watching = 0;
+        std::size_t audienceSlot = 0;
+        bool spectating = false;
+        bool following = false;
+        // Skipped ahead and not a byte written since
+        bool stalled = false;
+        bool open = false;
+        bool dirty = false;
+        bool wantWrite = false;
+        // io_uring only: a multishot recv is armed, it is being cancelled
+        // for a move, and the send in flight
+        bool receiving = false;
+        bool cancelling = false;
+        UringSend *sending = nullptr;
+    };
+
+    struct ActiveMatch;
+
+    // Coroutine that runs one match. Starts eagerly, runs to its first
+    // co_await, and is destroyed with its ActiveMatch.
+    class Session
+    {
+    public:
+        struct promise_type
+        {
+            // The coroutine is a member of ServerShard, so its frame comes
+            // from that shard's pool
+            static void *operator new(std::size_t size, ServerShard &shard, ActiveMatch &)
+            {
+                return shard.frames.allocate(size);
+            }
+            static void operator delete(void *frame, std::size_t size) { FramePool::release(frame, size); }
+
+            Session get_return_object()
+            {
+                return Session(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        Session() = default;
+        Session(Session &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        Session &operator=(Session &&other) noexcept
+        {
+            std::swap(handle, other.handle);
+            return *this;
+        }
+        ~Session()
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+        }
+
+        void resume() { handle.resume(); }
+        bool done() const { return !handle || handle.done(); }
+
+    private:
+        explicit Session(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    // What the event loop hands a suspended match
+    struct Action
+    {
+        enum class Kind
+        {
+            Place,
+            Fire,
+            Left,
+            TimedOut
+        };
+
+        Kind kind = Kind::Left;
+        int seat = -1;
+        FleetLayout layout{};
+        int cell = -1;
+    };
+
+    // A slot of the match pool, reset in place for each match it hosts
+    struct ActiveMatch
+    {
+        Match match;
+        // -1 while the seat's player is away
+        int fds[Match::SEATS] = {-1, -1};
+        // Proof of seat for Rejoin, and when an absent player forfeits
+        std::uint32_t tokens[Match::SEATS] = {0, 0};
+        std::chrono::steady_clock::time_point absentUntil[Match::SEATS];
+        std::vector<int> audience;
+        // Watching frame plus a View of the match; rebuilt lazily after
+        // each event
+        SharedBytes snapshot;
+        // The move awaited by session is due by deadline
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        Action action;
+        Session session;
+        std::uint32_t slot = 0;
+        // Matches hosted so far, folded into the ids the slot hands out
+        std::uint32_t uses = 0;
+        // Position in liveSlots while a match is in progress
+        std::size_t liveIndex = 0;
+        bool live = false;
+        // Counted in pendingMatches until both fleets are placed
+        bool pending = false;
+    };
+
+    // co_await receive(active) suspends the match until the next Action
+    struct Receive
+    {
+        ActiveMatch &active;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        const Action &await_resume() const noexcept { return active.action; }
+    };
+
+    // A connection with everything it had buffered, in another shard's inbox
+    struct Handoff
+    {
+        Move move;
+        Connection connection;
+    };
+
+    GameServer &server;
+    std::size_t index;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    ServerStats stats;
+    // Declared before the match slabs, so it outlives every session frame
+    FramePool frames;
+    std::vector<Connection> connections;
+    std::size_t connectionCount = 0;
+    std::vector<int> dirtyFds;
+    // Spectators with queued output, as epoll keys; drained a budget at a time
+    std::deque<std::uint64_t> spectatorFlushes;
+    // Matches live in fixed-size slabs that are never freed, so a slot is
+    // reused in place, keeping the capacity of its buffers, and a running
+    // match makes no heap allocations of its own. The first slab is
+    // allocated with the shard. A match id names its slot (see matchIdOf).
+    std::vector<std::unique_ptr<ActiveMatch[]>> matchSlabs;
+    std::vector<std::uint32_t> freeSlots;
+    std::vector<std::uint32_t> liveSlots;
+    std::uint32_t newestMatchId = 0;
+    std::vector<int> idleFollowers;
+    std::size_t spectatorCount = 0;
+    std::vector<std::uint8_t> eventBuffer;
+    // Seat tokens for Rejoin
+    Xoshiro256 tokenRng;
+    // Time at the top of the current loop iteration, for turn deadlines
+    std::chrono::steady_clock::time_point loopTime;
+    std::chrono::steady_clock::time_point nextSweep;
+    std::vector<std::uint32_t> expired;
+
+    // Overload state. The loop is behind while its batches come back full;
+    // Joins are refused until shedUntil.
+    std::size_t pendingMatches = 0;
+    std::chrono::steady_clock::time_point behindSince;
+    std::size_t eventsBehind = 0;
+    bool behind = false;
+    std::chrono::steady_clock::time_point shedUntil;
+    // Connections out of tokens, as event keys, and a spare for swapping
+    std::vector<std::uint64_t> throttled;
+    std::vector<std::uint64_t> throttledNow;
+
+    // Null without --log-dir. logRecord is scratch for building records.
+    MatchLog *log = nullptr;
+    std::vector<std::uint8_t> logRecord;
+
+    // Filled by other shards
+    std::mutex inboxMutex;
+    std::vector<Handoff> inbox;
+    std::vector<Handoff> arrivals;
+
+    // io_uring backend; no ring under epoll. Sends belong to the shard
+    // rather than their connection, since one may still be in flight when
+    // its connection closes. The ring is declared last, so it is torn
+    // down before anything it might still write to.
+    std::vector<std::unique_ptr<UringSend>> sends;
+    std::vector<UringSend *> idleSends;
+    // Connections whose multishot recv ended, often for want of buffers;
+    // re-armed after the batch, once its buffers are back
+    std::vector<std::uint64_t> receivesToArm;
+    std::uint64_t wakeCount = 0;
+    std::unique_ptr<IoUring> ring;
+
+    void runEpoll();
+    void acceptConnections();
+    void openConnection(int fd);
+    // Starts reading: an epoll registration or an armed multishot recv
+    bool watchInput(Connection &connection);
+    void readFrom(Connection &connection);
+    // Parses connection.in plus the new bytes, which are parsed in place
+    // when nothing was left over
+    void parseInput(Connection &connection, const std::uint8_t *data, std::size_t size);
+    // Spends one of the connection's tokens; false when it has none
+    bool takeToken(Connection &connection);
+    // Parses what throttled connections have waiting, as far as their
+    // tokens allow
+    void resumeThrottled();
+    // Records the lag of the batch just handled and starts shedding when it
+    // breaks the SLO; backlogged when the batch did not drain the events
+    void checkLoad(bool backlogged);
+    bool shedding() const;
+    void handleFrame(Connection &connection, const Frame &frame);
+    void handleJoin(Connection &connection);
+    void handlePlace(Connection &connection, const Frame &frame);
+    void handleFire(Connection &connection, const Frame &frame);
+    void handleSpectate(Connection &connection, const Frame &frame);
+    void handleRejoin(Connection &connection, const Frame &frame);
+    // Seats the connection in the match again and brings it up to date
+    void rejoin(Connection &connection, std::uint32_t matchId, std::uint32_t token, std::uint16_t since);
+    // Keeps the seat for a Rejoin, or ends the match when there is no grace
+    void vacateSeat(ActiveMatch &active, int seat);
+    void startMatch(Connection &first, Connection &second);
+    ActiveMatch &matchSlot(std::uint32_t slot)
+    {
+        return matchSlabs[slot / MATCH_SLAB_SIZE][slot % MATCH_SLAB_SIZE];
+    }
+    // The live match with this id on this shard, or nullptr
+    ActiveMatch *findMatch(std::uint32_t matchId);
+    // False once the shard has MAX_MATCH_SLOTS
+    bool addMatchSlab();
+    // A fresh slot, or nullptr when the shard hosts all it can
+    ActiveMatch *acquireMatch();
+    // Starts a match in the slot and adds it to liveSlots
+    void occupy(ActiveMatch &active);
+    void releaseMatch(ActiveMatch &active);
+    std::uint32_t matchIdOf(const ActiveMatch &active) const;
+    Session playMatch(ActiveMatch &active);
+    static Receive receive(ActiveMatch &active) { return Receive{active}; }
+    // Resumes the match with the action and retires it once it ends
+    void deliver(ActiveMatch &active, const Action &action);
+    // Gives the player to move a full turn from now
+    void startClock(ActiveMatch &active);
+    // A player left or ran out of time; the opponent wins
+    void endEarly(ActiveMatch &active, const Action &action);
+    bool takeShot(ActiveMatch &active, const Action &action, Match::ShotOutcome &outcome);
+    void expireTurns();
+    bool sweepDue() const;
+    int waitTimeout() const;
+    void startWatching(Connection &connection, std::uint32_t matchId);
+    void finishMatch(std::uint32_t matchId);
+
+    // Appends the match's end, and its summary to results.log
+    void logResult(const ActiveMatch &active, GameOverReason reason);
+    // Writes a checkpoint when one is due and hands the iteration's
+    // records to the committer
+    void submitLog();
+    void writeCheckpoint();
+    // Applies one replayed record
+    void restore(LogRecord type, const std::uint8_t *payload, std::size_t size);
+    // The slot matchId names, emptied and hosting a fresh match under that
+    // id; nullptr when the id is not this shard's
+    ActiveMatch *claimMatch(std::uint32_t matchId);
+
+    void post(Handoff handoff);
+    void drainInbox();
+    void adopt(Handoff &handoff);
+    void migrate(Connection &connection);
+
+    // Sends one serialised event to both seats and every spectator
+    void broadcast(ActiveMatch &active, const std::vector<std::uint8_t> &event);
+    void watch(Connection &spectator, std::uint32_t matchId, ActiveMatch &active);
+    void leaveAudience(Connection &spectator);
+    const SharedBytes &snapshot(ActiveMatch &active);
+    // With a match, a spectator too far behind skips ahead to its snapshot
+    void queueShared(Connection &spectator, const SharedBytes &chunk, ActiveMatch *active);
+    void skipAhead(Connection &spectator, ActiveMatch &active);
+
+    // Appends to the connection's queue; sent at the end of the batch
+    std::vector<std::uint8_t> &outbox(Connection &connection);
+    std::vector<std::uint8_t> &outbox(int fd) { return outbox(connections[static_cast<std::size_t>(fd)]); }
+    std::size_t pendingOutput(const Connection &connection) const;
+    void flush(Connection &connection);
+    void consumeOutput(Connection &connection, std::size_t sent);
+    void flushDirty();
+    void updateInterest(Connection &connection, bool wantWrite);
+    void closeConnection(Connection &connection);
+
+    void runRing();
+    // False once the server is stopping
+    bool complete(const io_uring_cqe &cqe);
+    void completeReceive(const io_uring_cqe &cqe);
+    void completeSend(UringSend &send, int result);
+    bool armAccept();
+    bool armWake();
+    bool armReceive(Connection &connection);
+    void sendWithRing(Connection &connection);
+    void submitSend(UringSend &send);
+    UringSend &acquireSend();
+    void releaseSend(UringSend &send);
+};
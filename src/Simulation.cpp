@@ -0,0 +1,185 @@
+#include "Simulation.h"
+#include "Metrics.h"
+#include "Random.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+std::uint64_t threadCpuNanos()
+{
+#ifndef _WIN32
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(now.tv_nsec);
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+PlayerConfig playerConfig(Difficulty difficulty, const OpeningBook *book)
+{
+    return PlayerConfig{difficulty, defaultSearchLimits(difficulty), book};
+}
+
+namespace
+{
+ComputerAI makePlayer(const PlayerConfig &config, std::uint64_t seed)
+{
+    ComputerAI player(config.difficulty, seed);
+    player.setSearchLimits(config.limits);
+    player.setOpeningBook(config.book);
+    return player;
+}
+}
+
+SimulatedGame simulateGame(const PlayerConfig &first, const PlayerConfig &second, std::uint64_t seed,
+                           RuleSet rules)
+{
+    RandomService random(seed);
+    random.beginGame();
+
+    Board boards[2];
+    std::vector<std::unique_ptr<Ship>> fleets[2];
+    for (int side = 0; side < 2; ++side)
+    {
+        createStandardFleet(fleets[side]);
+        applyFleetLayout(boards[side], fleets[side], randomFleetLayout(random.placement()));
+    }
+
+    ComputerAI players[2] = {
+        makePlayer(first, random.aiSeed()),
+        makePlayer(second, RandomService::deriveSeed(random.aiSeed(), RandomStream::AI))};
+
+    SimulatedGame game;
+    std::vector<Board::ShotResult> results;
+    Metrics::add(Counter::GamesStarted);
+    // Each side needs at most one shot, so at most one turn, per cell
+    for (int turn = 0; turn < 2 * Board::SIZE * Board::SIZE; ++turn)
+    {
+        const int side = turn % 2;
+        Board &opponent = boards[1 - side];
+
+        const std::uint64_t start = threadCpuNanos();
+        const ComputerAI::Volley volley =
+            players[side].chooseVolley(targetView(opponent), shotsPerTurn(rules, boards[side]));
+        game.thinkNanos[side] += threadCpuNanos() - start;
+        game.iterations[side] += volley.iterations;
+
+        opponent.attackBatch(volley.targets, results);
+        players[side].recordVolley(volley.targets, results, opponent);
+        game.shots[side] += static_cast<int>(volley.targets.size());
+        ++game.turns;
+
+        if (opponent.allShipsSunk())
+        {
+            game.winner = side;
+            break;
+        }
+    }
+    Metrics::add(Counter::GamesFinished);
+    return game;
+}
+
+SimulatedBattle simulateBattle(const std::vector<PlayerConfig> &players, TurnOrder order, std::uint64_t seed)
+{
+    const std::uint64_t start = threadCpuNanos();
+    RandomService random(seed);
+    random.beginGame();
+
+    const std::size_t count = players.size();
+    std::vector<FleetLayout> layouts;
+    for (std::size_t seat = 0; seat < count; ++seat)
+    {
+        layouts.push_back(randomFleetLayout(random.placement()));
+    }
+    SimulatedBattle result;
+    Battle battle;
+    if (!battle.start(layouts, order, random.aiSeed()))
+    {
+        return result;
+    }
+    result.shots.assign(count, 0);
+    result.thinkNanos.assign(count, 0);
+
+    // Indexed by shooter * count + target
+    std::vector<std::unique_ptr<ComputerAI>> ais(count * count);
+    // Target and cell of every shot, for timing the engine alone
+    std::vector<std::pair<int, int>> moves;
+    // Every live fleet needs at most one shot per cell
+    for (std::size_t shot = 0; shot < count * Board::SIZE * Board::SIZE && !battle.isOver(); ++shot)
+    {
+        const int shooter = battle.getTurn();
+        const int target = chooseBattleTarget(battle, shooter);
+        const TargetView &view = battle.view(target);
+        auto &ai = ais[static_cast<std::size_t>(shooter) * count + static_cast<std::size_t>(target)];
+        if (!ai)
+        {
+            ai = std::make_unique<ComputerAI>(makePlayer(
+                players[static_cast<std::size_t>(shooter)],
+                RandomService::deriveSeed(random.aiSeed() + static_cast<std::uint64_t>(&ai - ais.data()),
+                                          RandomStream::AI)));
+        }
+
+        const std::uint64_t thinkStart = threadCpuNanos();
+        const ComputerAI::Move move = ai->chooseMove(view);
+        result.thinkNanos[static_cast<std::size_t>(shooter)] += threadCpuNanos() - thinkStart;
+
+        const int cell = move.target.first * Board::SIZE + move.target.second;
+        const Battle::ShotOutcome outcome = battle.fire(shooter, target, cell);
+        moves.emplace_back(target, cell);
+        ai->recordResult(move.target, outcome.result, view);
+        ++result.shots[static_cast<std::size_t>(shooter)];
+    }
+    result.winner = battle.getWinner();
+    result.rounds = battle.getRound();
+    result.eliminations = battle.getEliminations();
+    result.totalNanos = threadCpuNanos() - start;
+
+    const std::uint64_t replayStart = threadCpuNanos();
+    Battle replay;
+    replay.setCountMetrics(false);
+    replay.start(layouts, order, random.aiSeed());
+    for (const auto &[target, cell] : moves)
+    {
+        const int shooter = replay.getTurn();
+        chooseBattleTarget(replay, shooter);
+        replay.fire(shooter, target, cell);
+    }
+    result.engineNanos = threadCpuNanos() - replayStart;
+    return result;
+}
+
+HuntResult huntLayout(const FleetLayout &layout, const PlayerConfig &hunter, std::uint64_t seed)
+{
+    HuntResult hunt;
+    Board board;
+    std::vector<std::unique_ptr<Ship>> fleet;
+    createStandardFleet(fleet);
+    if (!applyFleetLayout(board, fleet, layout))
+    {
+        return hunt;
+    }
+
+    ComputerAI player = makePlayer(hunter, seed);
+    std::string shipName;
+    Metrics::add(Counter::GamesStarted);
+    while (hunt.shots < Board::SIZE * Board::SIZE && !board.allShipsSunk())
+    {
+        const std::uint64_t start = threadCpuNanos();
+        ComputerAI::Move move = player.chooseMove(board);
+        hunt.thinkNanos += threadCpuNanos() - start;
+        hunt.iterations += move.iterations;
+
+        player.recordResult(move.target, board.attack(move.target, shipName), board);
+        ++hunt.shots;
+    }
+    Metrics::add(Counter::GamesFinished);
+    return hunt;
+}
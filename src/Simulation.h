@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Battle.h"
+#include "ComputerAI.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// One simulated player: a difficulty with its search limits and book
+struct PlayerConfig
+{
+    Difficulty difficulty = Difficulty::Medium;
+    SearchLimits limits;
+    const OpeningBook *book = nullptr;
+};
+
+// Player with the difficulty's default search limits
+PlayerConfig playerConfig(Difficulty difficulty, const OpeningBook *book = nullptr);
+
+// Result of one headless computer-vs-computer game. Index 0 is the side that
+// fires first.
+struct SimulatedGame
+{
+    int winner = -1;
+    // Turns taken by both sides together; equal to the total shots under
+    // Classic rules
+    int turns = 0;
+    std::array<int, 2> shots{0, 0};
+    // CPU time spent choosing moves, per side
+    std::array<std::uint64_t, 2> thinkNanos{0, 0};
+    // Search iterations, per side
+    std::array<std::uint64_t, 2> iterations{0, 0};
+};
+
+// Plays one game between two players. Fleet layouts and both AIs are
+// derived from seed, so the same seed replays the same game as long as
+// neither search is cut short by its time budget. Under Salvo rules each
+// turn's volley is fired with Board::attackBatch().
+SimulatedGame simulateGame(const PlayerConfig &first, const PlayerConfig &second, std::uint64_t seed,
+                           RuleSet rules = RuleSet::Classic);
+
+// Result of one headless free-for-all, indexed by seat
+struct SimulatedBattle
+{
+    int winner = -1;
+    int rounds = 0;
+    // Seats in the order they were eliminated
+    std::vector<int> eliminations;
+    std::vector<int> shots;
+    std::vector<std::uint64_t> thinkNanos;
+    // CPU time of the whole battle, AI included
+    std::uint64_t totalNanos = 0;
+    // CPU time to replay the battle's shots without the AI: target choice,
+    // rules and fog views
+    std::uint64_t engineNanos = 0;
+};
+
+// Plays one free-for-all between players.size() computer players, each
+// firing at chooseBattleTarget(). Every shooter keeps one ComputerAI per
+// opponent it has fired at, created on first use. Derived from seed like
+// simulateGame().
+SimulatedBattle simulateBattle(const std::vector<PlayerConfig> &players, TurnOrder order, std::uint64_t seed);
+
+// A single hunter firing at a fixed layout until every ship is sunk
+struct HuntResult
+{
+    int shots = 0;
+    std::uint64_t thinkNanos = 0;
+    std::uint64_t iterations = 0;
+};
+
+HuntResult huntLayout(const FleetLayout &layout, const PlayerConfig &hunter, std::uint64_t seed);
+
+// CPU time consumed by the calling thread, in nanoseconds
+std::uint64_t threadCpuNanos();
@@ -0,0 +1,128 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+namespace
+{
+thread_local int workerIndex = -1;
+thread_local const WorkStealingPool *workerPool = nullptr;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+int WorkStealingPool::currentWorker()
+{
+    return workerIndex;
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    unsigned target = workerPool == this ? static_cast<unsigned>(workerIndex)
+                                         : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    unfinished.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+        // Counted while the deque is still locked so a thief can never
+        // take the task before it is counted
+        queued.fetch_add(1);
+    }
+    {
+        // Empty critical section orders the notify after a sleeping
+        // worker's predicate check
+        std::lock_guard<std::mutex> lock(stateMutex);
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    idle.wait(lock, [this]
+              { return unfinished.load() == 0; });
+}
+
+bool WorkStealingPool::tryTake(unsigned self, Task &task)
+{
+    {
+        Queue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (unsigned offset = 1; offset < size(); ++offset)
+    {
+        Queue &victim = *queues[(self + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned index)
+{
+    workerIndex = static_cast<int>(index);
+    workerPool = this;
+
+    Task task;
+    while (true)
+    {
+        if (tryTake(index, task))
+        {
+            queued.fetch_sub(1);
+            task();
+            task = nullptr;
+            if (unfinished.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        wake.wait(lock, [this]
+                  { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0)
+        {
+            return;
+        }
+    }
+}
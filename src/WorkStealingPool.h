@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker. Workers take from
+// the back of their own deque and steal from the front of the others when it
+// runs dry, so uneven task lengths still keep every core busy.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // threads == 0 uses one worker per hardware thread
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    // Called from a worker, queues locally; otherwise round-robin
+    void submit(Task task);
+    // Blocks until every submitted task has finished
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+    // Index of the calling worker, or -1 outside the pool
+    static int currentWorker();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> unfinished{0};
+    std::atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+
+    bool tryTake(unsigned self, Task &task);
+    void workerLoop(unsigned index);
+};
@@ -1,3 +1,14 @@
+#include "BotProtocol.h"
+#include "ComputerAI.h"
+#include "GameLogic.h"
+#include "Heatmaps.h"
+#include "LayoutPool.h"
+#include "OpeningBook.h"
+#include "PlacementSearch.h"
+#include "Random.h"
+#include "Replay.h"
+#include "SaveGame.h"
+#include "WorkStealingPool.h"
 #include <algorithm>
 #include <array>
 #include <chrono>
@@ -7,15 +18,12 @@
 #include <iostream>
 #include <limits>
 #include <memory>
-#include <random>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
-using Coordinate = std::pair<int, int>;
-
 static std::string coordinateToString(const Coordinate &coord)
 {
     char letter = static_cast<char>('A' + coord.first);
@@ -78,341 +86,18 @@ static bool parseCoordinate(const std::string &input, Coordinate &out)
     return true;
 }
 
-static std::string colorizeSymbol(char symbol)
-{
-    constexpr const char *RED = "\033[31m";
-    constexpr const char *BLUE = "\033[34m";
-    constexpr const char *GREEN = "\033[32m";
-    constexpr const char *RESET = "\033[0m";
-
-    switch (symbol)
-    {
-    case 'X':
-        return std::string(RED) + 'X' + RESET;
-    case 'O':
-        return std::string(BLUE) + 'O' + RESET;
-    case 'S':
-        return std::string(GREEN) + 'S' + RESET;
-    default:
-        return std::string(1, symbol);
-    }
-}
-
-class Ship
-{
-public:
-    Ship(std::string shipName, int shipSize) : name(std::move(shipName)), size(shipSize) {}
-    virtual ~Ship() = default;
-
-    const std::string &getName() const
-    {
-        return name;
-    }
-
-    virtual std::string getType() const
-    {
-        return name;
-    }
-
-    int getSize() const
-    {
-        return size;
-    }
-
-    void setPositions(const std::vector<Coordinate> &coords)
-    {
-        positions = coords;
-        hits.assign(coords.size(), false);
-    }
-
-    const std::vector<Coordinate> &getPositions() const
-    {
-        return positions;
-    }
-
-    bool isPlaced() const
-    {
-        return static_cast<int>(positions.size()) == size;
-    }
-
-    bool occupies(const Coordinate &coord) const
-    {
-        for (const auto &pos : positions)
-        {
-            if (pos.first == coord.first && pos.second == coord.second)
-            {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    bool registerHit(const Coordinate &coord)
-    {
-        for (std::size_t i = 0; i < positions.size(); ++i)
-        {
-            if (positions[i] == coord)
-            {
-                hits[i] = true;
-                return true;
-            }
-        }
-        return false;
-    }
-
-    bool isSunk() const
-    {
-        if (hits.empty())
-        {
-            return false;
-        }
-        return std::all_of(hits.begin(), hits.end(), [](bool hit)
-                           { return hit; });
-    }
-
-    void reset()
-    {
-        positions.clear();
-        hits.clear();
-    }
-
-private:
-    std::string name;
-    int size;
-    std::vector<Coordinate> positions;
-    std::vector<bool> hits;
-};
-
-class AircraftCarrier : public Ship
-{
-public:
-    AircraftCarrier() : Ship("Aircraft Carrier", 5) {}
-    std::string getType() const override
-    {
-        return "Aircraft Carrier";
-    }
-};
-
-class Battleship : public Ship
-{
-public:
-    Battleship() : Ship("Battleship", 4) {}
-    std::string getType() const override
-    {
-        return "Battleship";
-    }
-};
-
-class Cruiser : public Ship
-{
-public:
-    Cruiser() : Ship("Cruiser", 3) {}
-    std::string getType() const override
-    {
-        return "Cruiser";
-    }
-};
-
-class Submarine : public Ship
-{
-public:
-    Submarine() : Ship("Submarine", 3) {}
-    std::string getType() const override
-    {
-        return "Submarine";
-    }
-};
-
-class Destroyer : public Ship
-{
-public:
-    Destroyer() : Ship("Destroyer", 2) {}
-    std::string getType() const override
-    {
-        return "Destroyer";
-    }
-};
-
-class Board
-{
-public:
-    static constexpr int SIZE = 10;
-
-    enum class AttackResult
-    {
-        Invalid,
-        AlreadyTried,
-        Miss,
-        Hit,
-        Sunk
-    };
-
-    Board()
-    {
-        clear();
-    }
-
-    void clear()
-    {
-        for (auto &row : grid)
-        {
-            for (auto &cell : row)
-            {
-                cell.ship = nullptr;
-                cell.attacked = false;
-            }
-        }
-        ships.clear();
-    }
-
-    bool placeShip(Ship &ship, const Coordinate &start, bool horizontal)
-    {
-        std::vector<Coordinate> prospective;
-        prospective.reserve(ship.getSize());
-
-        for (int i = 0; i < ship.getSize(); ++i)
-        {
-            int row = start.first + (horizontal ? 0 : i);
-            int col = start.second + (horizontal ? i : 0);
-
-            Coordinate candidate{row, col};
-            if (!inBounds(candidate) || isOccupied(candidate))
-            {
-                return false;
-            }
-            prospective.push_back(candidate);
-        }
-
-        ship.setPositions(prospective);
-
-        for (const auto &coord : prospective)
-        {
-            Cell &cell = grid[coord.first][coord.second];
-            cell.ship = &ship;
-        }
-
-        if (std::find(ships.begin(), ships.end(), &ship) == ships.end())
-        {
-            ships.push_back(&ship);
-        }
-
-        return true;
-    }
-
-    AttackResult attack(const Coordinate &target, std::string &shipName)
-    {
-        if (!inBounds(target))
-        {
-            return AttackResult::Invalid;
-        }
-
-        Cell &cell = grid[target.first][target.second];
-        if (cell.attacked)
-        {
-            return AttackResult::AlreadyTried;
-        }
-
-        cell.attacked = true;
-
-        if (cell.ship == nullptr)
-        {
-            return AttackResult::Miss;
-        }
-
-        Ship *hitShip = cell.ship;
-        hitShip->registerHit(target);
-        shipName = hitShip->getName();
-
-        if (hitShip->isSunk())
-        {
-            return AttackResult::Sunk;
-        }
-
-        return AttackResult::Hit;
-    }
-
-    bool allShipsSunk() const
-    {
-        return std::all_of(ships.begin(), ships.end(), [](const Ship *ship)
-                           { return ship->isSunk(); });
-    }
-
-    void displayOwn() const
-    {
-        display(false);
-    }
-
-    void displayFogged() const
-    {
-        display(true);
-    }
-
-private:
-    struct Cell
-    {
-        Ship *ship = nullptr;
-        bool attacked = false;
-    };
-
-    std::array<std::array<Cell, SIZE>, SIZE> grid{};
-    std::vector<Ship *> ships;
-
-    bool inBounds(const Coordinate &coord) const
-    {
-        return coord.first >= 0 && coord.first < SIZE && coord.second >= 0 && coord.second < SIZE;
-    }
-
-    bool isOccupied(const Coordinate &coord) const
-    {
-        const Cell &cell = grid[coord.first][coord.second];
-        return cell.ship != nullptr;
-    }
-
-    void display(bool hideShips) const
-    {
-        std::cout << "    ";
-        for (int col = 1; col <= SIZE; ++col)
-        {
-            if (col < 10)
-            {
-                std::cout << ' ';
-            }
-            std::cout << col << ' ';
-        }
-        std::cout << "\n";
-
-        for (int row = 0; row < SIZE; ++row)
-        {
-            char label = static_cast<char>('A' + row);
-            std::cout << ' ' << label << "  ";
-            for (int col = 0; col < SIZE; ++col)
-            {
-                const Cell &cell = grid[row][col];
-                char symbol = '~';
-                if (cell.attacked)
-                {
-                    symbol = cell.ship ? 'X' : 'O';
-                }
-                else if (cell.ship && !hideShips)
-                {
-                    symbol = 'S';
-                }
-                const std::string decorated = colorizeSymbol(symbol);
-                std::cout << ' ' << decorated << ' ';
-            }
-            std::cout << "\n";
-        }
-    }
-};
-
 class Game
 {
 public:
-    Game() : placementFile("placement.txt"), rng(std::random_device{}())
+    Game(std::uint64_t sessionSeed, PlacementMode placementMode)
+        : placementFile("placement.txt"), replayWriter("replays.bin"), random(sessionSeed), computerAI(Difficulty::Easy),
+          placementMode(placementMode)
     {
         createFleet(playerFleet);
         createFleet(computerFleet);
-        refillComputerShots();
+        random.beginGame();
+        computerAI.reset(random.aiSeed());
+        layoutPool.open("layouts.bin");
     }
 
     void run()
@@ -424,6 +109,7 @@ public:
 
         setupPlayerFleet();
         setupComputerFleet();
+        replayWriter.beginGame(random.getGameSeed(), encodeFleetLayout(playerFleet), encodeFleetLayout(computerFleet));
 
         std::cout << "\nBattle commencing!\n";
         showBoards();
@@ -444,6 +130,10 @@ public:
             }
             waitForEnter();
         }
+
+        const ReplayRecord &record = replayWriter.endGame();
+        replayWriter.flush();
+        updateHeatmaps(record);
     }
 
 private:
@@ -452,8 +142,23 @@ private:
     std::vector<std::unique_ptr<Ship>> playerFleet;
     std::vector<std::unique_ptr<Ship>> computerFleet;
     std::string placementFile;
-    std::vector<Coordinate> computerShots;
-    std::mt19937 rng;
+    ReplayWriter replayWriter;
+    LayoutPool layoutPool;
+    RandomService random;
+    ComputerAI computerAI;
+    PlacementMode placementMode;
+
+    void updateHeatmaps(const ReplayRecord &record) const
+    {
+        const std::string heatmapFile = "heatmaps.bin";
+        Heatmaps heatmaps;
+        loadHeatmaps(heatmapFile, heatmaps);
+        heatmaps.addGame(record);
+        if (!writeFileAtomically(heatmapFile, serializeHeatmaps(heatmaps)))
+        {
+            std::cerr << "Warning: Unable to update " << heatmapFile << std::endl;
+        }
+    }
 
     void waitForEnter(const std::string &prompt = "Press Enter to continue...") const
     {
@@ -469,26 +174,7 @@ private:
 
     static void createFleet(std::vector<std::unique_ptr<Ship>> &fleet)
     {
-        fleet.clear();
-        fleet.emplace_back(std::make_unique<AircraftCarrier>());
-        fleet.emplace_back(std::make_unique<Battleship>());
-        fleet.emplace_back(std::make_unique<Cruiser>());
-        fleet.emplace_back(std::make_unique<Submarine>());
-        fleet.emplace_back(std::make_unique<Destroyer>());
-    }
-
-    void refillComputerShots()
-    {
-        computerShots.clear();
-        computerShots.reserve(Board::SIZE * Board::SIZE);
-        for (int row = 0; row < Board::SIZE; ++row)
-        {
-            for (int col = 0; col < Board::SIZE; ++col)
-            {
-                computerShots.emplace_back(row, col);
-            }
-        }
-        std::shuffle(computerShots.begin(), computerShots.end(), rng);
+        createStandardFleet(fleet);
     }
 
     void showWelcome() const
@@ -500,7 +186,8 @@ private:
         std::cout << " - You and the computer each have 5 ships.\n";
         std::cout << " - Take turns firing coordinates like A5 or D10.\n";
         std::cout << " - 'X' = hit, 'O' = miss, 'S' = your ship.\n";
-        std::cout << " - Sink all enemy ships to win.\n\n";
+        std::cout << " - Sink all enemy ships to win.\n";
+        std::cout << "Session seed: " << random.getSessionSeed() << " (pass --seed to replay it)\n\n";
     }
 
     void setupPlayerFleet()
@@ -539,6 +226,25 @@ private:
 
     void setupComputerFleet()
     {
+        if (placementMode == PlacementMode::Adversarial)
+        {
+            WorkStealingPool pool;
+            PlacementSearchResult result =
+                searchAdversarialLayout(pool, random.placement()(), std::chrono::milliseconds(50));
+            if (applyFleetLayout(computerBoard, computerFleet, result.layout))
+            {
+                std::cout << "\nEnemy fleet deployed to survive " << result.meanShots << " shots on average (best of "
+                          << result.candidates << " layouts)." << std::endl;
+                return;
+            }
+        }
+
+        if (layoutPool.isOpen() && applyFleetLayout(computerBoard, computerFleet, layoutPool.pick(random.placement())))
+        {
+            std::cout << "\nEnemy fleet drawn from " << layoutPool.size() << " pre-generated layouts." << std::endl;
+            return;
+        }
+
         if (loadComputerPlacements())
         {
             std::cout << "\nEnemy fleet loaded from saved deployment." << std::endl;
@@ -621,6 +327,7 @@ private:
                 continue;
             }
 
+            replayWriter.recordShot(Shooter::Player, target);
             announceResult("You", target, result, shipName);
             showBoards();
 
@@ -635,22 +342,18 @@ private:
 
         while (true)
         {
-            if (computerShots.empty())
-            {
-                refillComputerShots();
-            }
-
-            Coordinate target = computerShots.back();
-            computerShots.pop_back();
+            Coordinate target = computerAI.chooseTarget(playerBoard);
 
             std::string shipName;
             Board::AttackResult result = playerBoard.attack(target, shipName);
+            computerAI.recordResult(target, result, playerBoard);
 
             if (result == Board::AttackResult::Invalid || result == Board::AttackResult::AlreadyTried)
             {
                 continue;
             }
 
+            replayWriter.recordShot(Shooter::Computer, target);
             std::this_thread::sleep_for(std::chrono::milliseconds(500));
             announceResult("Enemy", target, result, shipName);
             showBoards();
@@ -780,53 +483,7 @@ private:
 
     void generateComputerPlacements()
     {
-        std::uniform_int_distribution<int> orientationDist(0, 1);
-        while (true)
-        {
-            computerBoard.clear();
-            for (auto &ship : computerFleet)
-            {
-                ship->reset();
-            }
-
-            bool success = true;
-            for (auto &ship : computerFleet)
-            {
-                bool placed = false;
-                for (int attempt = 0; attempt < 500 && !placed; ++attempt)
-                {
-                    bool horizontal = orientationDist(rng) == 0;
-                    int maxRow = horizontal ? Board::SIZE - 1 : Board::SIZE - ship->getSize();
-                    int maxCol = horizontal ? Board::SIZE - ship->getSize() : Board::SIZE - 1;
-
-                    if (maxRow < 0 || maxCol < 0)
-                    {
-                        continue;
-                    }
-
-                    std::uniform_int_distribution<int> rowDist(0, maxRow);
-                    std::uniform_int_distribution<int> colDist(0, maxCol);
-
-                    Coordinate start{rowDist(rng), colDist(rng)};
-
-                    if (computerBoard.placeShip(*ship, start, horizontal))
-                    {
-                        placed = true;
-                    }
-                }
-
-                if (!placed)
-                {
-                    success = false;
-                    break;
-                }
-            }
-
-            if (success)
-            {
-                return;
-            }
-        }
+        applyFleetLayout(computerBoard, computerFleet, randomFleetLayout(random.placement()));
     }
 
     void saveComputerPlacements() const
@@ -871,9 +528,197 @@ private:
     }
 };
 
-int main()
+// Plays back one recorded game. speed is shots per second (1x = one shot per
+// second, up to 1000x); jumpToEnd skips straight to the final position.
+static int playReplay(const std::string &path, int gameIndex, int speed, bool jumpToEnd)
+{
+    std::vector<ReplayRecord> records;
+    if (!readReplayFile(path, records) && records.empty())
+    {
+        std::cerr << "Unable to read replays from " << path << std::endl;
+        return 1;
+    }
+    if (records.empty())
+    {
+        std::cerr << "No games recorded in " << path << std::endl;
+        return 1;
+    }
+
+    if (gameIndex < 0)
+    {
+        gameIndex = static_cast<int>(records.size()) - 1;
+    }
+    if (gameIndex >= static_cast<int>(records.size()))
+    {
+        std::cerr << "Replay " << gameIndex + 1 << " not found (" << records.size() << " games recorded)" << std::endl;
+        return 1;
+    }
+
+    ReplayPlayer player(records[gameIndex]);
+    if (!player.isValid())
+    {
+        std::cerr << "Replay " << gameIndex + 1 << " has an invalid fleet layout" << std::endl;
+        return 1;
+    }
+
+    std::cout << "=== Replay " << gameIndex + 1 << " of " << records.size() << " (seed " << player.getSeed()
+              << ", " << player.getShotCount() << " shots) ===\n";
+
+    speed = std::max(1, std::min(1000, speed));
+    const auto interval = std::chrono::microseconds(1000000 / speed);
+
+    if (jumpToEnd)
+    {
+        player.skipToEnd();
+    }
+
+    ReplayPlayer::Event event;
+    while (player.step(event))
+    {
+        const char *attacker = event.shooter == Shooter::Player ? "Player" : "Enemy";
+        std::cout << '[' << player.getShotIndex() << "] " << attacker << " fires at " << coordinateToString(event.target);
+        switch (event.result)
+        {
+        case Board::AttackResult::Miss:
+            std::cout << " - miss\n";
+            break;
+        case Board::AttackResult::Hit:
+            std::cout << " - hit\n";
+            break;
+        case Board::AttackResult::Sunk:
+            std::cout << " - sinks the " << event.shipName << "\n";
+            break;
+        default:
+            std::cout << " - ignored\n";
+            break;
+        }
+        std::this_thread::sleep_for(interval);
+    }
+
+    std::cout << "\nPlayer Fleet:" << std::endl;
+    player.getPlayerBoard().displayOwn();
+    std::cout << "\nEnemy Fleet:" << std::endl;
+    player.getComputerBoard().displayOwn();
+
+    if (player.getComputerBoard().allShipsSunk())
+    {
+        std::cout << "\nResult: player victory.\n";
+    }
+    else if (player.getPlayerBoard().allShipsSunk())
+    {
+        std::cout << "\nResult: enemy victory.\n";
+    }
+    else
+    {
+        std::cout << "\nResult: game abandoned.\n";
+    }
+    return 0;
+}
+
+// Speaks the bot protocol (BotProtocol.h) on stdin/stdout so the built-in
+// computer can be driven by fleet_arena or any other front end.
+static int runBot(Difficulty difficulty, const std::string &bookPath)
 {
-    Game game;
+    OpeningBook book;
+    if (!bookPath.empty() && !book.load(bookPath))
+    {
+        std::cerr << "Unable to read opening book " << bookPath << std::endl;
+        return 1;
+    }
+    BotEngine engine(difficulty, book.size() ? &book : nullptr);
+
+    // Drivers queue several commands per write; read them in bulk
+    std::ios::sync_with_stdio(false);
+    std::string line;
+    std::string reply;
+    while (std::getline(std::cin, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (!engine.handle(line, reply))
+        {
+            break;
+        }
+        if (!reply.empty())
+        {
+            std::cout << reply << '\n' << std::flush;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string replayPath;
+    int replayGame = -1;
+    int replaySpeed = 1;
+    bool replayToEnd = false;
+    std::uint64_t seed = RandomService::freshSeed();
+    PlacementMode placementMode = PlacementMode::Random;
+    bool botMode = false;
+    Difficulty botDifficulty = Difficulty::Hard;
+    std::string bookPath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (arg == "--game" && i + 1 < argc && std::atoi(argv[i + 1]) >= 1)
+        {
+            replayGame = std::atoi(argv[++i]) - 1;
+        }
+        else if (arg == "--speed" && i + 1 < argc)
+        {
+            replaySpeed = std::atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--adversarial")
+        {
+            placementMode = PlacementMode::Adversarial;
+        }
+        else if (arg == "--end")
+        {
+            replayToEnd = true;
+        }
+        else if (arg == "--bot")
+        {
+            botMode = true;
+        }
+        else if (arg == "--difficulty" && i + 1 < argc && parseDifficulty(argv[i + 1], botDifficulty))
+        {
+            ++i;
+        }
+        else if (arg == "--book" && i + 1 < argc)
+        {
+            bookPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--seed S] [--adversarial] [--replay FILE [--game N] [--speed 1-1000] [--end]]" << std::endl;
+            std::cerr << "       " << argv[0] << " --bot [--difficulty easy|medium|hard] [--book opening.bin]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (botMode)
+    {
+        return runBot(botDifficulty, bookPath);
+    }
+
+    if (!replayPath.empty())
+    {
+        return playReplay(replayPath, replayGame, replaySpeed, replayToEnd);
+    }
+
+    Game game(seed, placementMode);
     game.run();
     return 0;
 }
@@ -0,0 +1,348 @@
+#include "BotProcess.h"
+#include "BotProtocol.h"
+#include "ComputerAI.h"
+#include "OpeningBook.h"
+#include "Random.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Plays an external bot engine against the built-in computer over the line
+// protocol in BotProtocol.h. Each worker owns one bot process for the whole
+// run; the driver adjudicates every shot, so a bot that places an invalid
+// fleet, fires at an invalid cell or stops answering forfeits the game.
+
+namespace
+{
+constexpr std::uint64_t GAMES_PER_TASK = 16;
+constexpr std::size_t DIFFICULTY_COUNT = 3;
+
+struct Outcome
+{
+    bool botWon = false;
+    bool forfeit = false;
+    int botShots = 0;
+};
+
+struct Tally
+{
+    std::uint64_t wins[DIFFICULTY_COUNT] = {};
+    std::uint64_t losses[DIFFICULTY_COUNT] = {};
+    std::uint64_t forfeits[DIFFICULTY_COUNT] = {};
+    std::uint64_t winningShots[DIFFICULTY_COUNT] = {};
+};
+
+// Per worker: its bot process, results and move latencies
+struct Worker
+{
+    BotProcess bot;
+    Tally tally;
+    std::vector<std::uint64_t> latencyNanos;
+};
+
+struct ArenaOptions
+{
+    std::string command;
+    std::chrono::milliseconds timeout{5000};
+    const OpeningBook *book = nullptr;
+};
+
+bool ensureRunning(Worker &worker, const ArenaOptions &options)
+{
+    if (worker.bot.isRunning())
+    {
+        return true;
+    }
+    return worker.bot.start(options.command);
+}
+
+// Drops a bot that broke the protocol; its next game starts a fresh process
+Outcome forfeit(Worker &worker, Outcome outcome)
+{
+    worker.bot.stop();
+    outcome.forfeit = true;
+    outcome.botWon = false;
+    return outcome;
+}
+
+Outcome playGame(Worker &worker, const ArenaOptions &options, Difficulty opponent, bool botFirst,
+                 std::uint64_t seed)
+{
+    Outcome outcome;
+    if (!ensureRunning(worker, options))
+    {
+        return forfeit(worker, outcome);
+    }
+    BotProcess &bot = worker.bot;
+
+    RandomService random(seed);
+    random.beginGame();
+    bot.send("newgame " + std::to_string(seed));
+
+    Board boards[2];
+    std::vector<std::unique_ptr<Ship>> fleets[2];
+    FleetLayout layouts[2];
+    createStandardFleet(fleets[0]);
+    createStandardFleet(fleets[1]);
+
+    // Side 0 is the bot, side 1 the built-in computer
+    std::string reply;
+    std::string command;
+    std::string args;
+    if (!bot.request("place", reply, options.timeout))
+    {
+        return forfeit(worker, outcome);
+    }
+    splitCommand(reply, command, args);
+    if (command != "place" || !parseLayout(args, layouts[0]) || !applyFleetLayout(boards[0], fleets[0], layouts[0]))
+    {
+        return forfeit(worker, outcome);
+    }
+    layouts[1] = randomFleetLayout(random.placement());
+    applyFleetLayout(boards[1], fleets[1], layouts[1]);
+
+    PlayerConfig config = playerConfig(opponent, options.book);
+    ComputerAI computer(config.difficulty, random.aiSeed());
+    computer.setSearchLimits(config.limits);
+    computer.setOpeningBook(config.book);
+
+    std::string shipName;
+    for (int turn = botFirst ? 0 : 1; turn < 2 * Board::SIZE * Board::SIZE + 1; ++turn)
+    {
+        if (turn % 2 == 1)
+        {
+            const Coordinate target = computer.chooseMove(boards[0]).target;
+            const Board::AttackResult result = boards[0].attack(target, shipName);
+            computer.recordResult(target, result, boards[0]);
+            bot.send("incoming " + formatCell(target));
+            if (boards[0].allShipsSunk())
+            {
+                bot.send("gameover loss");
+                return outcome;
+            }
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!bot.request("fire", reply, options.timeout))
+        {
+            return forfeit(worker, outcome);
+        }
+        worker.latencyNanos.push_back(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+
+        Coordinate target;
+        splitCommand(reply, command, args);
+        if (command != "fire" || !parseCell(args, target))
+        {
+            return forfeit(worker, outcome);
+        }
+        const Board::AttackResult result = boards[1].attack(target, shipName);
+        ++outcome.botShots;
+
+        switch (result)
+        {
+        case Board::AttackResult::Miss:
+            bot.send("result miss");
+            break;
+        case Board::AttackResult::Hit:
+            bot.send("result hit");
+            break;
+        case Board::AttackResult::Sunk:
+            for (std::size_t i = 0; i < fleets[1].size(); ++i)
+            {
+                if (fleets[1][i]->occupies(target))
+                {
+                    bot.send(std::string("result sunk ") + shipToken(i) + ' ' + formatPlacement(layouts[1][i]));
+                    break;
+                }
+            }
+            break;
+        default:
+            // Repeated or off-board shot
+            return forfeit(worker, outcome);
+        }
+
+        if (boards[1].allShipsSunk())
+        {
+            bot.send("gameover win");
+            outcome.botWon = true;
+            return outcome;
+        }
+    }
+    return outcome;
+}
+
+double percentile(const std::vector<std::uint64_t> &sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const std::size_t index = std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * sorted.size()));
+    return sorted[index] / 1000.0;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    ArenaOptions options;
+    std::uint64_t gamesPerOpponent = 1000;
+    unsigned bots = 1;
+    std::uint64_t seed = RandomService::freshSeed();
+    std::string bookPath;
+    std::vector<Difficulty> opponents = {Difficulty::Easy, Difficulty::Medium, Difficulty::Hard};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        Difficulty difficulty;
+        if (arg == "--bot" && i + 1 < argc)
+        {
+            options.command = argv[++i];
+        }
+        else if (arg == "--opponent" && i + 1 < argc && parseDifficulty(argv[i + 1], difficulty))
+        {
+            opponents = {difficulty};
+            ++i;
+        }
+        else if (arg == "--games" && i + 1 < argc)
+        {
+            gamesPerOpponent = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--bots" && i + 1 < argc)
+        {
+            bots = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--timeout" && i + 1 < argc)
+        {
+            options.timeout = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--book" && i + 1 < argc)
+        {
+            bookPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " --bot COMMAND [--opponent easy|medium|hard] [--games N] [--bots B] [--seed S]"
+                         " [--timeout MS] [--book opening.bin]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.command.empty() || gamesPerOpponent == 0)
+    {
+        std::cerr << "A bot command and a positive number of games are required" << std::endl;
+        return 1;
+    }
+
+    OpeningBook book;
+    if (!bookPath.empty() && !book.load(bookPath))
+    {
+        std::cerr << "Unable to read opening book " << bookPath << std::endl;
+        return 1;
+    }
+    options.book = book.size() ? &book : nullptr;
+
+    // A bot that exits mid-write must not take the driver with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    BotProcess probe;
+    std::string name;
+    if (!probe.start(options.command) || !probe.request("hello", name, options.timeout))
+    {
+        std::cerr << "Bot did not answer hello: " << options.command << std::endl;
+        return 1;
+    }
+    probe.stop();
+
+    WorkStealingPool pool(std::max(1u, bots));
+    std::vector<Worker> workers(pool.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t opponent = 0; opponent < opponents.size(); ++opponent)
+    {
+        for (std::uint64_t first = 0; first < gamesPerOpponent; first += GAMES_PER_TASK)
+        {
+            const std::uint64_t last = std::min(gamesPerOpponent, first + GAMES_PER_TASK);
+            pool.submit([&workers, &options, &opponents, opponent, first, last, seed]
+                        {
+                Worker &worker = workers[static_cast<std::size_t>(WorkStealingPool::currentWorker())];
+                const Difficulty difficulty = opponents[opponent];
+                const std::size_t index = static_cast<std::size_t>(difficulty);
+                for (std::uint64_t game = first; game < last; ++game)
+                {
+                    std::uint64_t state = seed ^ (static_cast<std::uint64_t>(opponent) << 48) ^ game;
+                    Outcome outcome = playGame(worker, options, difficulty, game % 2 == 0, splitmix64(state));
+                    if (outcome.botWon)
+                    {
+                        ++worker.tally.wins[index];
+                        worker.tally.winningShots[index] += static_cast<std::uint64_t>(outcome.botShots);
+                    }
+                    else
+                    {
+                        ++worker.tally.losses[index];
+                        worker.tally.forfeits[index] += outcome.forfeit ? 1 : 0;
+                    }
+                } });
+        }
+    }
+    pool.wait();
+
+    Tally total;
+    std::vector<std::uint64_t> latencies;
+    std::uint64_t messages = 0;
+    for (auto &worker : workers)
+    {
+        messages += worker.bot.getMessageCount();
+        for (std::size_t i = 0; i < DIFFICULTY_COUNT; ++i)
+        {
+            total.wins[i] += worker.tally.wins[i];
+            total.losses[i] += worker.tally.losses[i];
+            total.forfeits[i] += worker.tally.forfeits[i];
+            total.winningShots[i] += worker.tally.winningShots[i];
+        }
+        latencies.insert(latencies.end(), worker.latencyNanos.begin(), worker.latencyNanos.end());
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "Bot: " << name << "\n";
+    std::cout << "Played " << gamesPerOpponent * opponents.size() << " games (" << gamesPerOpponent
+              << " per opponent) with " << pool.size() << " bot processes in " << std::fixed << std::setprecision(2)
+              << elapsed << " s, seed " << seed << "\n\n";
+
+    std::cout << std::left << std::setw(10) << "Opponent" << std::right << std::setw(8) << "Wins" << std::setw(8)
+              << "Losses" << std::setw(10) << "Forfeits" << std::setw(10) << "Win rate" << std::setw(12)
+              << "Shots/win" << "\n";
+    for (Difficulty difficulty : opponents)
+    {
+        const std::size_t i = static_cast<std::size_t>(difficulty);
+        const std::uint64_t games = total.wins[i] + total.losses[i];
+        std::cout << std::left << std::setw(10) << difficultyName(difficulty) << std::right << std::setw(8)
+                  << total.wins[i] << std::setw(8) << total.losses[i] << std::setw(10) << total.forfeits[i]
+                  << std::setw(9) << std::setprecision(1) << (games ? 100.0 * total.wins[i] / games : 0.0) << "%"
+                  << std::setw(12) << (total.wins[i] ? static_cast<double>(total.winningShots[i]) / total.wins[i] : 0.0)
+                  << "\n";
+    }
+
+    std::cout << "\nMessages: " << messages << " (" << std::setprecision(0) << messages / elapsed << " msgs/s)\n";
+    std::cout << "Move latency (us): p50 " << std::setprecision(1) << percentile(latencies, 0.5) << ", p90 "
+              << percentile(latencies, 0.9) << ", p99 " << percentile(latencies, 0.99) << ", max "
+              << percentile(latencies, 1.0) << " over " << latencies.size() << " moves\n";
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "ComputerAI.h"
+#include "OpeningBook.h"
+#include "SaveGame.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Offline generator for the opening book read by ComputerAI. Expands every
+// all-miss line of play the hunt search can choose, up to the given depth.
+int main(int argc, char *argv[])
+{
+    int depth = 16;
+    std::string outPath = "opening.bin";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--depth" && i + 1 < argc)
+        {
+            depth = std::atoi(argv[++i]);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--depth N] [--out FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (depth < 1 || depth > 40)
+    {
+        std::cerr << "Depth must be between 1 and 40" << std::endl;
+        return 1;
+    }
+
+    const std::vector<int> sizes(STANDARD_SHIP_SIZES.begin(), STANDARD_SHIP_SIZES.end());
+    auto start = std::chrono::steady_clock::now();
+
+    OpeningBook book;
+    std::vector<CellMask> frontier(1);
+    for (int ply = 0; ply < depth && !frontier.empty(); ++ply)
+    {
+        std::vector<CellMask> next;
+        for (const CellMask &misses : frontier)
+        {
+            std::size_t known = 0;
+            if (book.lookup(misses, known))
+            {
+                continue;
+            }
+
+            std::vector<std::uint8_t> best = bestDensityCells(huntDensity(misses, sizes), misses);
+            book.add(misses, best);
+            for (std::uint8_t cell : best)
+            {
+                CellMask child = misses;
+                child.set(cell);
+                next.push_back(child);
+            }
+        }
+        std::cout << "Ply " << ply + 1 << ": " << book.size() << " positions" << std::endl;
+        frontier.swap(next);
+    }
+
+    const std::vector<std::uint8_t> data = book.serialize();
+    if (!writeFileAtomically(outPath, data))
+    {
+        std::cerr << "Unable to write " << outPath << std::endl;
+        return 1;
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << book.size() << " positions (" << data.size() << " bytes) to " << outPath << " in "
+              << elapsed << " s" << std::endl;
+    return 0;
+}
@@ -1,11 +1,72 @@
 #include "GameGUI.h"
+#include <cstdlib>
 #include <iostream>
 
-int main()
+int main(int argc, char *argv[])
 {
+    std::string replayPath;
+    int replayGame = -1;
+    int replaySpeed = 1;
+    bool replayToEnd = false;
+    std::uint64_t seed = RandomService::freshSeed();
+    bool hostGame = false;
+    std::string joinAddress;
+    unsigned short port = NetworkManager::DEFAULT_PORT;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (arg == "--game" && i + 1 < argc && std::atoi(argv[i + 1]) >= 1)
+        {
+            replayGame = std::atoi(argv[++i]) - 1;
+        }
+        else if (arg == "--speed" && i + 1 < argc)
+        {
+            replaySpeed = std::atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--end")
+        {
+            replayToEnd = true;
+        }
+        else if (arg == "--host")
+        {
+            hostGame = true;
+        }
+        else if (arg == "--join" && i + 1 < argc)
+        {
+            joinAddress = argv[++i];
+        }
+        else if (arg == "--port" && i + 1 < argc)
+        {
+            port = static_cast<unsigned short>(std::atoi(argv[++i]));
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--seed S] [--replay FILE [--game N] [--speed 1-1000] [--end]]" << std::endl;
+            std::cerr << "       " << argv[0] << " --host | --join ADDRESS [--port " << NetworkManager::DEFAULT_PORT << "]" << std::endl;
+            return 1;
+        }
+    }
+
     try
     {
-        GameGUI game;
+        GameGUI game(seed);
+        if (!replayPath.empty() && !game.startReplay(replayPath, replayGame, replaySpeed, replayToEnd))
+        {
+            return 1;
+        }
+        if ((hostGame || !joinAddress.empty()) && !game.startNetworkGame(hostGame, joinAddress, port))
+        {
+            return 1;
+        }
         game.run();
     }
     catch (const std::exception &e)
@@ -0,0 +1,134 @@
+#include "Heatmaps.h"
+#include "Replay.h"
+#include "SaveGame.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Query tool for heatmaps.bin. Prints each map as a 10x10 grid of
+// percentages (count / games) with a shade ramp for quick scanning.
+
+static void printHeatmap(const Heatmaps &heatmaps, HeatmapKind kind)
+{
+    static const char ramp[] = " .:-=+*#%@";
+    const auto &map = heatmaps.get(kind);
+    const std::uint32_t peak = std::max<std::uint32_t>(1, *std::max_element(map.begin(), map.end()));
+    const double games = std::max<std::uint32_t>(1, heatmaps.games);
+
+    std::cout << "\n"
+              << heatmapName(kind) << " (% of " << heatmaps.games << " games)\n";
+    std::cout << "    ";
+    for (int col = 1; col <= Board::SIZE; ++col)
+    {
+        std::cout << std::setw(6) << col;
+    }
+    std::cout << "    ";
+    for (int col = 1; col <= Board::SIZE; ++col)
+    {
+        std::cout << col % 10;
+    }
+    std::cout << "\n";
+
+    for (int row = 0; row < Board::SIZE; ++row)
+    {
+        std::cout << ' ' << static_cast<char>('A' + row) << "  ";
+        for (int col = 0; col < Board::SIZE; ++col)
+        {
+            std::uint32_t count = map[row * Board::SIZE + col];
+            std::cout << std::setw(6) << std::fixed << std::setprecision(1) << 100.0 * count / games;
+        }
+        std::cout << "    ";
+        for (int col = 0; col < Board::SIZE; ++col)
+        {
+            std::uint32_t count = map[row * Board::SIZE + col];
+            std::cout << ramp[count * (sizeof(ramp) - 2) / peak];
+        }
+        std::cout << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string path = "heatmaps.bin";
+    std::string rebuildFrom;
+    std::string mapName = "all";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--file" && i + 1 < argc)
+        {
+            path = argv[++i];
+        }
+        else if (arg == "--map" && i + 1 < argc)
+        {
+            mapName = argv[++i];
+        }
+        else if (arg == "--rebuild" && i + 1 < argc)
+        {
+            rebuildFrom = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--file heatmaps.bin] [--map NAME|all] [--rebuild replays.bin]\n"
+                      << "Maps:";
+            for (std::size_t k = 0; k < HEATMAP_COUNT; ++k)
+            {
+                std::cerr << ' ' << heatmapName(static_cast<HeatmapKind>(k));
+            }
+            std::cerr << std::endl;
+            return 1;
+        }
+    }
+
+    Heatmaps heatmaps;
+    if (!rebuildFrom.empty())
+    {
+        std::vector<ReplayRecord> records;
+        if (!readReplayFile(rebuildFrom, records) && records.empty())
+        {
+            std::cerr << "Unable to read replays from " << rebuildFrom << std::endl;
+            return 1;
+        }
+        // The GUI only folds in finished games, so a rebuild skips the rest
+        for (const auto &record : records)
+        {
+            if (isFinishedGame(record))
+            {
+                heatmaps.addGame(record);
+            }
+        }
+        if (!writeFileAtomically(path, serializeHeatmaps(heatmaps)))
+        {
+            std::cerr << "Unable to write " << path << std::endl;
+            return 1;
+        }
+        std::cout << "Rebuilt " << path << " from " << heatmaps.games << " finished games ("
+                  << records.size() - heatmaps.games << " abandoned games skipped)" << std::endl;
+    }
+    else if (!loadHeatmaps(path, heatmaps))
+    {
+        std::cerr << "Unable to read heatmaps from " << path << std::endl;
+        return 1;
+    }
+
+    bool printed = false;
+    for (std::size_t k = 0; k < HEATMAP_COUNT; ++k)
+    {
+        auto kind = static_cast<HeatmapKind>(k);
+        if (mapName == "all" || mapName == heatmapName(kind))
+        {
+            printHeatmap(heatmaps, kind);
+            printed = true;
+        }
+    }
+
+    if (!printed)
+    {
+        std::cerr << "Unknown map: " << mapName << std::endl;
+        return 1;
+    }
+    return 0;
+}
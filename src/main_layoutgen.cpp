@@ -0,0 +1,100 @@
+#include "GameLogic.h"
+#include "LayoutPool.h"
+#include "Random.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Layouts are written out this many bytes at a time
+constexpr std::size_t BLOCK_SIZE = 64 * 1024 * LayoutPool::ENTRY_SIZE;
+}
+
+// Offline generator for the layout pool read by LayoutPool.
+int main(int argc, char *argv[])
+{
+    std::uint64_t count = 1000000;
+    std::uint64_t seed = RandomService::freshSeed();
+    std::string outPath = "layouts.bin";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--count" && i + 1 < argc)
+        {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--count N] [--seed S] [--out FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (count == 0)
+    {
+        std::cerr << "Layout count must be positive" << std::endl;
+        return 1;
+    }
+
+    const std::string tempPath = outPath + ".tmp";
+    std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+        std::cerr << "Unable to write " << tempPath << std::endl;
+        return 1;
+    }
+
+    std::uint8_t header[LayoutPool::HEADER_SIZE];
+    LayoutPool::writeHeader(header, count);
+    output.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+    auto start = std::chrono::steady_clock::now();
+    Xoshiro256 rng(seed);
+    std::vector<std::uint8_t> block;
+    block.reserve(BLOCK_SIZE);
+
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        FleetLayout layout = randomFleetLayout(rng);
+        block.insert(block.end(), layout.begin(), layout.end());
+        if (block.size() >= BLOCK_SIZE)
+        {
+            output.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(block.size()));
+            block.clear();
+        }
+    }
+    output.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(block.size()));
+    output.close();
+
+    // A short write must not replace an existing pool with a truncated one
+    std::error_code error;
+    if (output)
+    {
+        std::filesystem::rename(tempPath, outPath, error);
+    }
+    if (!output || error)
+    {
+        std::filesystem::remove(tempPath, error);
+        std::cerr << "Unable to write " << outPath << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << count << " layouts to " << outPath << " (seed " << seed << ") in " << seconds
+              << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,350 @@
+#include "LayoutPool.h"
+#include "LoadGenerator.h"
+#include "OpeningBook.h"
+#include "Random.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/resource.h>
+
+// Capacity-test client for fleet_server. Opens many simulated players from
+// one process and reports latency percentiles per request type along with
+// connection and shot rates.
+//
+// Profiles:
+//   steady  ramp up to --connections over --ramp seconds, then measure for
+//           --duration seconds
+//   ramp    step the connection count up in --steps equal steps, holding
+//           each for --interval seconds, one report row per step
+//   soak    like steady, but with a report row every --interval seconds,
+//           so drift over a long run shows up
+
+namespace
+{
+enum class Profile
+{
+    Steady,
+    Ramp,
+    Soak
+};
+
+std::atomic<bool> interrupted{false};
+
+void handleSignal(int)
+{
+    interrupted = true;
+}
+
+// Thousands of connections need thousands of sockets; lift the soft limit
+void raiseFileLimit()
+{
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Sleeps in short steps so Ctrl+C still gets a report; false if interrupted
+bool sleepFor(std::chrono::steady_clock::duration duration)
+{
+    const auto deadline = std::chrono::steady_clock::now() + duration;
+    while (!interrupted)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - now,
+                                                                                   std::chrono::milliseconds(100)));
+    }
+    return false;
+}
+
+double micros(std::uint64_t nanos)
+{
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+void printRowHeader()
+{
+    std::cout << std::right << std::setw(8) << "Time(s)" << std::setw(8) << "Conns" << std::setw(10) << "Conn/s"
+              << std::setw(10) << "Shots/s" << std::setw(9) << "Games/s" << std::setw(11) << "Fire p50"
+              << std::setw(11) << "Fire p99" << std::setw(11) << "Fire p999" << std::setw(11) << "Ping p99"
+              << std::setw(8) << "Errors" << std::setw(9) << "Refused" << std::setw(7) << "Drops"
+              << "  (latency in us)\n";
+}
+
+void printRow(double at, std::size_t connections, const LoadStats &stats, double seconds)
+{
+    const LatencyHistogram &fire = stats.latency[static_cast<std::size_t>(Exchange::Fire)];
+    const LatencyHistogram &ping = stats.latency[static_cast<std::size_t>(Exchange::Ping)];
+    std::cout << std::fixed << std::setprecision(1) << std::setw(8) << at << std::setw(8) << connections
+              << std::setprecision(0) << std::setw(10) << stats.connects / seconds << std::setw(10)
+              << stats.shots / seconds << std::setprecision(1) << std::setw(9) << stats.games / seconds
+              << std::setw(11) << micros(fire.percentile(0.5)) << std::setw(11) << micros(fire.percentile(0.99))
+              << std::setw(11) << micros(fire.percentile(0.999)) << std::setw(11) << micros(ping.percentile(0.99))
+              << std::setw(8) << stats.errors << std::setw(9) << stats.refused << std::setw(7) << stats.disconnects
+              << std::endl;
+}
+
+void printSummary(const LoadStats &stats, double seconds)
+{
+    std::cout << "\nOver " << std::fixed << std::setprecision(1) << seconds << " s: " << stats.shots << " shots ("
+              << std::setprecision(0) << stats.shots / seconds << "/s), " << stats.games << " games ("
+              << std::setprecision(1) << stats.games / seconds << "/s), " << stats.connects << " connections ("
+              << std::setprecision(0) << stats.connects / seconds << "/s)\n";
+    std::cout << "Connect failures: " << stats.connectFailures << ", dropped by server: " << stats.disconnects
+              << ", protocol errors: " << stats.errors << ", joins refused: " << stats.refused << "\n\n";
+
+    std::cout << std::left << std::setw(9) << "Request" << std::right << std::setw(11) << "Count" << std::setw(11)
+              << "Mean" << std::setw(11) << "p50" << std::setw(11) << "p90" << std::setw(11) << "p99"
+              << std::setw(11) << "p999" << std::setw(11) << "Max" << "  (us)\n";
+    for (std::size_t i = 0; i < EXCHANGE_COUNT; ++i)
+    {
+        const LatencyHistogram &histogram = stats.latency[i];
+        std::cout << std::left << std::setw(9) << exchangeName(static_cast<Exchange>(i)) << std::right
+                  << std::setw(11) << histogram.getCount() << std::setprecision(1) << std::setw(11)
+                  << histogram.getMean() / 1000.0 << std::setw(11) << micros(histogram.percentile(0.5))
+                  << std::setw(11) << micros(histogram.percentile(0.9)) << std::setw(11)
+                  << micros(histogram.percentile(0.99)) << std::setw(11) << micros(histogram.percentile(0.999))
+                  << std::setw(11) << micros(histogram.getMax()) << "\n";
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    LoadGenerator::Options options;
+    std::size_t connections = 1000;
+    Profile profile = Profile::Steady;
+    double rampSeconds = 5.0;
+    double durationSeconds = -1.0;
+    double intervalSeconds = 10.0;
+    std::size_t steps = 5;
+    std::string layoutPath;
+    std::string bookPath;
+    std::string aiName = "random";
+    options.seed = RandomService::freshSeed();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--host" && i + 1 < argc)
+        {
+            options.host = argv[++i];
+        }
+        else if (arg == "--port" && i + 1 < argc)
+        {
+            options.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        }
+        else if (arg == "--connections" && i + 1 < argc)
+        {
+            connections = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--profile" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (name == "steady")
+            {
+                profile = Profile::Steady;
+            }
+            else if (name == "ramp")
+            {
+                profile = Profile::Ramp;
+            }
+            else if (name == "soak")
+            {
+                profile = Profile::Soak;
+            }
+            else
+            {
+                std::cerr << "Unknown profile " << name << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--ramp" && i + 1 < argc)
+        {
+            rampSeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--duration" && i + 1 < argc)
+        {
+            durationSeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--interval" && i + 1 < argc)
+        {
+            intervalSeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--steps" && i + 1 < argc)
+        {
+            steps = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--ai" && i + 1 < argc)
+        {
+            aiName = argv[++i];
+        }
+        else if (arg == "--think" && i + 1 < argc)
+        {
+            options.thinkTime = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--rejoin" && i + 1 < argc)
+        {
+            options.rejoinPercent = static_cast<unsigned>(std::min(100ul, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (arg == "--ping" && i + 1 < argc)
+        {
+            options.pingInterval = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--layouts" && i + 1 < argc)
+        {
+            layoutPath = argv[++i];
+        }
+        else if (arg == "--book" && i + 1 < argc)
+        {
+            bookPath = argv[++i];
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--host 127.0.0.1] [--port 7777] [--connections N] [--threads T]"
+                         " [--profile steady|ramp|soak] [--ramp S] [--duration S] [--interval S] [--steps K]"
+                         " [--ai random|easy|medium|hard] [--think MS] [--ping MS] [--rejoin PCT]"
+                         " [--layouts layouts.bin] [--book opening.bin] [--seed S]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (connections == 0 || steps == 0 || intervalSeconds <= 0.0)
+    {
+        std::cerr << "Connections, steps and interval must be positive" << std::endl;
+        return 1;
+    }
+    if (durationSeconds < 0.0)
+    {
+        durationSeconds = profile == Profile::Soak ? 600.0 : 30.0;
+    }
+
+    OpeningBook book;
+    if (!bookPath.empty() && !book.load(bookPath))
+    {
+        std::cerr << "Unable to read opening book " << bookPath << std::endl;
+        return 1;
+    }
+    Difficulty difficulty;
+    if (parseDifficulty(aiName, difficulty))
+    {
+        options.ai = playerConfig(difficulty, book.size() ? &book : nullptr);
+    }
+    else if (aiName != "random")
+    {
+        std::cerr << "Unknown AI " << aiName << std::endl;
+        return 1;
+    }
+
+    LayoutPool layouts;
+    if (!layoutPath.empty())
+    {
+        if (!layouts.open(layoutPath) || layouts.size() == 0)
+        {
+            std::cerr << "Unable to open layout pool " << layoutPath << std::endl;
+            return 1;
+        }
+        options.layouts = &layouts;
+    }
+
+    raiseFileLimit();
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    const unsigned threads = std::max(1u, options.threads);
+    LoadGenerator generator(options);
+    if (!generator.start())
+    {
+        return 1;
+    }
+    std::cout << "fleet_loadgen: " << connections << " connections to " << options.host << ":" << options.port
+              << " on " << threads << " threads, AI " << aiName << ", seed " << options.seed << "\n";
+
+    using Clock = std::chrono::steady_clock;
+    LoadStats interval;
+    LoadStats total;
+    const auto begin = Clock::now();
+    auto measureStart = begin;
+    auto since = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    if (profile == Profile::Ramp)
+    {
+        printRowHeader();
+        for (std::size_t step = 1; step <= steps && !interrupted; ++step)
+        {
+            const auto start = Clock::now();
+            generator.setConnections(connections * step / steps);
+            sleepFor(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(intervalSeconds)));
+            generator.collect(interval);
+            printRow(since(begin), generator.getOpenConnections(), interval, since(start));
+            total.merge(interval);
+        }
+    }
+    else
+    {
+        // Open connections gradually so the server's accept queue keeps up
+        const auto rampLength = std::chrono::duration<double>(rampSeconds);
+        while (!interrupted)
+        {
+            const double fraction = rampSeconds > 0.0 ? since(begin) / rampLength.count() : 1.0;
+            generator.setConnections(static_cast<std::size_t>(connections * std::min(1.0, fraction)));
+            if (fraction >= 1.0)
+            {
+                break;
+            }
+            sleepFor(std::chrono::milliseconds(100));
+        }
+        generator.collect(interval);
+        const double rampTime = since(begin);
+        std::cout << "Ramp-up: " << generator.getOpenConnections() << " connections open after " << std::fixed
+                  << std::setprecision(1) << rampTime << " s (" << interval.connects << " handshakes, "
+                  << interval.connectFailures << " failed)\n";
+
+        measureStart = Clock::now();
+        const double rowSeconds = profile == Profile::Soak ? intervalSeconds : durationSeconds;
+        if (profile == Profile::Soak)
+        {
+            printRowHeader();
+        }
+        while (!interrupted && since(measureStart) < durationSeconds)
+        {
+            const auto start = Clock::now();
+            const double remaining = durationSeconds - since(measureStart);
+            sleepFor(std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(std::min(rowSeconds, remaining))));
+            generator.collect(interval);
+            if (profile == Profile::Soak)
+            {
+                printRow(since(begin), generator.getOpenConnections(), interval, since(start));
+            }
+            total.merge(interval);
+        }
+    }
+
+    printSummary(total, since(measureStart));
+    generator.stop();
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include "GameServer.h"
+#include "MetricsEndpoint.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/resource.h>
+
+// Headless multi-match server. Clients speak the binary protocol described
+// in Protocol.h.
+
+namespace
+{
+GameServer *activeServer = nullptr;
+
+void handleSignal(int)
+{
+    if (activeServer)
+    {
+        activeServer->stop();
+    }
+}
+
+// Thousands of matches need thousands of sockets; lift the soft limit
+void raiseFileLimit()
+{
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    GameServer::Options options;
+    int metricsPort = -1;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--host" && i + 1 < argc)
+        {
+            options.host = argv[++i];
+        }
+        else if (arg == "--port" && i + 1 < argc)
+        {
+            options.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        }
+        else if (arg == "--metrics" && i + 1 < argc)
+        {
+            metricsPort = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            if (options.threads == 0)
+            {
+                std::cerr << "Threads must be positive" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--io" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (name == "epoll")
+            {
+                options.backend = GameServer::Backend::Epoll;
+            }
+            else if (name == "uring")
+            {
+                options.backend = GameServer::Backend::Uring;
+            }
+            else
+            {
+                std::cerr << "Unknown I/O backend " << name << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--turn-timeout" && i + 1 < argc)
+        {
+            options.turnTimeout = std::chrono::seconds(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--rejoin-grace" && i + 1 < argc)
+        {
+            options.rejoinGrace = std::chrono::seconds(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--rate-limit" && i + 1 < argc)
+        {
+            options.messageRate = std::strtod(argv[++i], nullptr);
+        }
+        else if (arg == "--burst" && i + 1 < argc)
+        {
+            options.messageBurst = std::max(1.0, std::strtod(argv[++i], nullptr));
+        }
+        else if (arg == "--max-pending" && i + 1 < argc)
+        {
+            options.maxPendingMatches = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--slo" && i + 1 < argc)
+        {
+            options.latencySlo = std::chrono::milliseconds(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--log-dir" && i + 1 < argc)
+        {
+            options.logDirectory = argv[++i];
+        }
+        else if (arg == "--commit-ms" && i + 1 < argc)
+        {
+            options.commitInterval = std::chrono::milliseconds(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (arg == "--checkpoint-mb" && i + 1 < argc)
+        {
+            options.checkpointBytes = static_cast<std::size_t>(std::strtod(argv[++i], nullptr) * 1024 * 1024);
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--host 127.0.0.1] [--port 7777] [--threads N] [--io epoll|uring]"
+                      << " [--turn-timeout S] [--rejoin-grace S] [--rate-limit N] [--burst N] [--max-pending N]"
+                      << " [--slo MS] [--log-dir DIR] [--commit-ms N] [--checkpoint-mb N] [--metrics PORT]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    raiseFileLimit();
+
+    GameServer server(options);
+    if (!server.start())
+    {
+        return 1;
+    }
+
+    MetricsEndpoint metrics;
+    if (metricsPort >= 0 && !metrics.start(static_cast<std::uint16_t>(metricsPort)))
+    {
+        return 1;
+    }
+
+    activeServer = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    std::cout << "fleet_server listening on " << options.host << ":" << options.port << " with "
+              << server.getShardCount() << " threads on "
+              << (server.getBackend() == GameServer::Backend::Uring ? "io_uring" : "epoll");
+    if (options.turnTimeout.count() > 0)
+    {
+        std::cout << ", " << options.turnTimeout.count() << " s per turn";
+    }
+    std::cout << std::endl;
+    if (!options.logDirectory.empty())
+    {
+        const MatchLog::Stats log = server.getLogStats();
+        std::cout << "Recovered " << server.getRecoveredMatches() << " matches from " << log.replayedRecords
+                  << " records (" << log.replayedBytes << " bytes) in "
+                  << std::chrono::duration<double, std::milli>(server.getRecoveryTime()).count() << " ms"
+                  << std::endl;
+    }
+    if (metricsPort >= 0)
+    {
+        std::cout << "Metrics at http://127.0.0.1:" << metrics.getPort() << "/metrics" << std::endl;
+    }
+    auto start = std::chrono::steady_clock::now();
+    server.run();
+    activeServer = nullptr;
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const GameServer::Stats &stats = server.getStats();
+    std::cout << "\nServed " << stats.connectionsAccepted << " connections (" << stats.connectionsMigrated
+              << " moved between threads), " << stats.matchesStarted
+              << " matches (" << stats.matchesFinished << " finished, " << stats.matchesTimedOut
+              << " timed out, " << stats.rejoins << " rejoins), " << stats.shots << " shots in " << elapsed
+              << " s" << std::endl;
+    std::cout << "Frames in: " << stats.framesIn << ", bytes in/out: " << stats.bytesIn << "/" << stats.bytesOut
+              << std::endl;
+    std::cout << "Spectator events: " << stats.spectatorEvents << ", skips: " << stats.spectatorSkips
+              << ", dropped: " << stats.spectatorsDropped << std::endl;
+    std::cout << "Joins refused: " << stats.joinsRefused << ", clients throttled: " << stats.clientsThrottled
+              << ", clients shed: " << stats.clientsShed << ", loop lag p99/max: "
+              << static_cast<double>(stats.loopLag.percentile(0.99)) / 1e6 << "/"
+              << static_cast<double>(stats.loopLag.getMax()) / 1e6 << " ms" << std::endl;
+    const double perMatch = static_cast<double>(stats.heapAllocations) /
+                            static_cast<double>(std::max<std::uint64_t>(stats.matchesStarted, 1));
+    std::cout << "Match frames allocated: " << stats.sessionAllocations << ", heap allocations on event loops: "
+              << stats.heapAllocations << " (" << perMatch << " per match)" << std::endl;
+
+    if (!options.logDirectory.empty())
+    {
+        // Write amplification: bytes written to disk per byte of play logged
+        const MatchLog::Stats log = server.getLogStats();
+        std::cout << "Match log: " << log.eventBytes << " event, " << log.checkpointBytes << " checkpoint ("
+                  << log.checkpoints << " checkpoints), " << log.resultBytes << " result bytes; " << log.bytesWritten
+                  << " written in " << log.syncs << " syncs, write amplification ";
+        // A run without play has nothing to amplify
+        if (log.eventBytes == 0)
+        {
+            std::cout << "n/a";
+        }
+        else
+        {
+            std::cout << static_cast<double>(log.bytesWritten) / static_cast<double>(log.eventBytes);
+        }
+        std::cout << ", " << log.segmentsDeleted << " segments compacted" << std::endl;
+    }
+
+    // Process CPU time, for comparing the I/O backends under the same load
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval &time) { return static_cast<double>(time.tv_sec) + time.tv_usec / 1e6; };
+    std::cout << "CPU time: " << seconds(usage.ru_utime) << " s user, " << seconds(usage.ru_stime) << " s system"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,314 @@
+#include "Battle.h"
+#include "ComputerAI.h"
+#include "MetricsEndpoint.h"
+#include "OpeningBook.h"
+#include "Random.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Strength-vs-budget curve for the anytime Hard AI. For each per-move time
+// budget, the Hard computer hunts the same set of random fleets; fewer
+// shots to sink them all means a stronger player.
+//
+// With --battle, plays free-for-alls instead, one row per player count,
+// to track what each shot costs as the ocean fills up.
+
+namespace
+{
+struct BudgetTally
+{
+    std::uint64_t games = 0;
+    double shots = 0.0;
+    double shotsSquared = 0.0;
+    std::uint64_t moves = 0;
+    std::uint64_t iterations = 0;
+    std::uint64_t thinkNanos = 0;
+};
+
+struct BattleTally
+{
+    std::uint64_t battles = 0;
+    std::uint64_t rounds = 0;
+    std::uint64_t shots = 0;
+    std::uint64_t thinkNanos = 0;
+    std::uint64_t totalNanos = 0;
+    std::uint64_t engineNanos = 0;
+};
+
+bool parsePlayerCounts(const std::string &list, std::vector<int> &counts)
+{
+    counts.clear();
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        char *end = nullptr;
+        long value = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value < Battle::MIN_PLAYERS || value > Battle::MAX_PLAYERS)
+        {
+            return false;
+        }
+        counts.push_back(static_cast<int>(value));
+    }
+    return !counts.empty();
+}
+
+void runBattles(const std::vector<int> &counts, Difficulty difficulty, TurnOrder order, std::uint64_t games,
+                std::uint64_t seed, WorkStealingPool &pool)
+{
+    std::cout << difficultyName(difficulty) << " AI free-for-all, " << turnOrderName(order) << " turn order, "
+              << games << " battles per size, " << pool.size() << " threads, seed " << seed << "\n\n";
+    std::cout << std::setw(8) << "Players" << std::setw(10) << "Rounds" << std::setw(14) << "Shots/battle"
+              << std::setw(16) << "Engine ns/shot" << std::setw(14) << "AI us/shot" << std::setw(14) << "CPU ms/battle"
+              << "\n";
+
+    for (int players : counts)
+    {
+        const std::vector<PlayerConfig> configs(static_cast<std::size_t>(players), playerConfig(difficulty));
+        std::vector<BattleTally> tallies(pool.size());
+        for (std::uint64_t game = 0; game < games; ++game)
+        {
+            // The same seeds at every size, offset by the size so the
+            // fleets differ
+            const std::uint64_t battleSeed = seed + game * 1000003 + static_cast<std::uint64_t>(players);
+            pool.submit([&tallies, &configs, order, battleSeed]
+                        {
+                BattleTally &tally = tallies[static_cast<std::size_t>(WorkStealingPool::currentWorker())];
+                SimulatedBattle battle = simulateBattle(configs, order, battleSeed);
+                ++tally.battles;
+                tally.rounds += static_cast<std::uint64_t>(battle.rounds);
+                for (std::size_t seat = 0; seat < battle.shots.size(); ++seat)
+                {
+                    tally.shots += static_cast<std::uint64_t>(battle.shots[seat]);
+                    tally.thinkNanos += battle.thinkNanos[seat];
+                }
+                tally.totalNanos += battle.totalNanos;
+                tally.engineNanos += battle.engineNanos; });
+        }
+        pool.wait();
+
+        BattleTally total;
+        for (const auto &tally : tallies)
+        {
+            total.battles += tally.battles;
+            total.rounds += tally.rounds;
+            total.shots += tally.shots;
+            total.thinkNanos += tally.thinkNanos;
+            total.totalNanos += tally.totalNanos;
+            total.engineNanos += tally.engineNanos;
+        }
+        const double n = static_cast<double>(std::max<std::uint64_t>(1, total.battles));
+        const double shots = static_cast<double>(std::max<std::uint64_t>(1, total.shots));
+        std::cout << std::fixed << std::setw(8) << players << std::setprecision(1) << std::setw(10)
+                  << static_cast<double>(total.rounds) / n << std::setw(14) << static_cast<double>(total.shots) / n
+                  << std::setprecision(0) << std::setw(16) << static_cast<double>(total.engineNanos) / shots << std::setprecision(2)
+                  << std::setw(14) << static_cast<double>(total.thinkNanos) / 1e3 / shots << std::setw(14)
+                  << static_cast<double>(total.totalNanos) / 1e6 / n << "\n";
+    }
+}
+
+bool parseBudgets(const std::string &list, std::vector<double> &budgets)
+{
+    budgets.clear();
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        char *end = nullptr;
+        double value = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0' || value < 0.0)
+        {
+            return false;
+        }
+        budgets.push_back(value);
+    }
+    return !budgets.empty();
+}
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<double> budgets = {0.0, 0.1, 0.5, 1.0, 5.0};
+    std::uint64_t games = 200;
+    std::uint64_t maxIterations = 0;
+    unsigned threads = 0;
+    std::uint64_t seed = RandomService::freshSeed();
+    std::string bookPath;
+    int metricsPort = -1;
+    std::vector<int> battleSizes;
+    Difficulty battleDifficulty = Difficulty::Medium;
+    TurnOrder turnOrder = TurnOrder::Seats;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--budgets" && i + 1 < argc)
+        {
+            if (!parseBudgets(argv[++i], budgets))
+            {
+                std::cerr << "Budgets must be a comma-separated list of milliseconds" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--games" && i + 1 < argc)
+        {
+            games = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--iterations" && i + 1 < argc)
+        {
+            maxIterations = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--book" && i + 1 < argc)
+        {
+            bookPath = argv[++i];
+        }
+        else if (arg == "--metrics" && i + 1 < argc)
+        {
+            metricsPort = std::atoi(argv[++i]);
+        }
+        else if (arg == "--battle" && i + 1 < argc)
+        {
+            if (!parsePlayerCounts(argv[++i], battleSizes))
+            {
+                std::cerr << "Player counts must be a comma-separated list from " << Battle::MIN_PLAYERS << " to "
+                          << Battle::MAX_PLAYERS << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--ai" && i + 1 < argc)
+        {
+            if (!parseDifficulty(argv[++i], battleDifficulty))
+            {
+                std::cerr << "Unknown difficulty " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--order" && i + 1 < argc)
+        {
+            if (!parseTurnOrder(argv[++i], turnOrder))
+            {
+                std::cerr << "Turn order must be seats, shuffled or reshuffled" << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--budgets MS,MS,...] [--games N] [--iterations CAP] [--threads T] [--seed S]"
+                      << " [--book opening.bin] [--metrics PORT]\n"
+                      << "       " << argv[0]
+                      << " --battle N,N,... [--ai easy|medium|hard] [--order seats|shuffled|reshuffled] [--games N]"
+                      << " [--threads T] [--seed S] [--metrics PORT]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (games == 0)
+    {
+        std::cerr << "Game count must be positive" << std::endl;
+        return 1;
+    }
+
+    MetricsEndpoint metrics;
+    if (metricsPort >= 0)
+    {
+        if (!metrics.start(static_cast<std::uint16_t>(metricsPort)))
+        {
+            return 1;
+        }
+        std::cout << "Metrics at http://127.0.0.1:" << metrics.getPort() << "/metrics\n";
+    }
+
+    if (!battleSizes.empty())
+    {
+        WorkStealingPool pool(threads);
+        runBattles(battleSizes, battleDifficulty, turnOrder, games, seed, pool);
+        return 0;
+    }
+
+    OpeningBook book;
+    if (!bookPath.empty() && !book.load(bookPath))
+    {
+        std::cerr << "Unable to read opening book " << bookPath << std::endl;
+        return 1;
+    }
+
+    // Every budget hunts the same fleets with the same AI seeds
+    std::vector<FleetLayout> layouts;
+    std::vector<std::uint64_t> aiSeeds;
+    RandomService random(seed);
+    for (std::uint64_t game = 0; game < games; ++game)
+    {
+        random.beginGame();
+        layouts.push_back(randomFleetLayout(random.placement()));
+        aiSeeds.push_back(random.aiSeed());
+    }
+
+    WorkStealingPool pool(threads);
+    std::cout << "Hard AI, " << games << " fleets per budget, " << pool.size() << " threads, seed " << seed << "\n\n";
+    std::cout << std::setw(12) << "Budget ms" << std::setw(18) << "Shots to sink" << std::setw(16) << "Iters/move"
+              << std::setw(14) << "CPU ms/move" << "\n";
+
+    for (double budgetMs : budgets)
+    {
+        PlayerConfig hunter = playerConfig(Difficulty::Hard, book.size() ? &book : nullptr);
+        hunter.limits.budget = std::chrono::microseconds(static_cast<std::int64_t>(budgetMs * 1000.0));
+        hunter.limits.maxIterations = maxIterations;
+
+        std::vector<BudgetTally> tallies(pool.size());
+        for (std::uint64_t game = 0; game < games; ++game)
+        {
+            pool.submit([&tallies, &layouts, &aiSeeds, &hunter, game]
+                        {
+                BudgetTally &tally = tallies[static_cast<std::size_t>(WorkStealingPool::currentWorker())];
+                HuntResult hunt = huntLayout(layouts[game], hunter, aiSeeds[game]);
+                ++tally.games;
+                tally.shots += hunt.shots;
+                tally.shotsSquared += static_cast<double>(hunt.shots) * hunt.shots;
+                tally.moves += static_cast<std::uint64_t>(hunt.shots);
+                tally.iterations += hunt.iterations;
+                tally.thinkNanos += hunt.thinkNanos; });
+        }
+        pool.wait();
+
+        BudgetTally total;
+        for (const auto &tally : tallies)
+        {
+            total.games += tally.games;
+            total.shots += tally.shots;
+            total.shotsSquared += tally.shotsSquared;
+            total.moves += tally.moves;
+            total.iterations += tally.iterations;
+            total.thinkNanos += tally.thinkNanos;
+        }
+
+        const double n = static_cast<double>(total.games);
+        const double mean = total.shots / n;
+        const double variance = std::max(0.0, total.shotsSquared / n - mean * mean);
+        const double margin = 1.96 * std::sqrt(variance / n);
+        const double moves = static_cast<double>(std::max<std::uint64_t>(1, total.moves));
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(12) << budgetMs << std::setprecision(2)
+                  << std::setw(10) << mean << " +/-" << std::setw(4) << std::setprecision(1) << margin
+                  << std::setprecision(0) << std::setw(16) << total.iterations / moves << std::setprecision(3)
+                  << std::setw(14) << total.thinkNanos / 1e6 / moves << "  "
+                  << std::string(static_cast<std::size_t>(std::max(0.0, 100.0 - mean)), '#') << "\n";
+    }
+    return 0;
+}
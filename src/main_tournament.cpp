@@ -0,0 +1,311 @@
+#include "ComputerAI.h"
+#include "OpeningBook.h"
+#include "Random.h"
+#include "Simulation.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Round-robin tournament between the computer strategies. Every pairing
+// plays the same number of games with the first move alternating, spread
+// over a work-stealing pool; results are reduced per worker, so the hot
+// path never takes a lock.
+
+namespace
+{
+struct Strategy
+{
+    const char *name;
+    Difficulty difficulty;
+};
+
+// Add new strategies here to include them in the tournament
+const Strategy STRATEGIES[] = {
+    {"Easy", Difficulty::Easy},
+    {"Medium", Difficulty::Medium},
+    {"Hard", Difficulty::Hard},
+};
+constexpr std::size_t STRATEGY_COUNT = sizeof(STRATEGIES) / sizeof(STRATEGIES[0]);
+constexpr std::uint64_t GAMES_PER_TASK = 64;
+
+struct Tally
+{
+    std::uint64_t wins[STRATEGY_COUNT][STRATEGY_COUNT] = {};
+    std::uint64_t winningShots[STRATEGY_COUNT] = {};
+    std::uint64_t winningTurns[STRATEGY_COUNT] = {};
+    std::uint64_t thinkNanos[STRATEGY_COUNT] = {};
+    std::uint64_t moves[STRATEGY_COUNT] = {};
+
+    void merge(const Tally &other)
+    {
+        for (std::size_t i = 0; i < STRATEGY_COUNT; ++i)
+        {
+            for (std::size_t j = 0; j < STRATEGY_COUNT; ++j)
+            {
+                wins[i][j] += other.wins[i][j];
+            }
+            winningShots[i] += other.winningShots[i];
+            winningTurns[i] += other.winningTurns[i];
+            thinkNanos[i] += other.thinkNanos[i];
+            moves[i] += other.moves[i];
+        }
+    }
+};
+
+struct Rating
+{
+    double elo;
+    double margin;
+};
+
+// Bradley-Terry maximum likelihood fit (minorization-maximization), with one
+// virtual win and loss per pairing so an unbeaten strategy stays finite.
+// Margins are 95% intervals from the diagonal of the Fisher information.
+std::vector<Rating> fitElo(const Tally &tally)
+{
+    double wins[STRATEGY_COUNT][STRATEGY_COUNT];
+    for (std::size_t i = 0; i < STRATEGY_COUNT; ++i)
+    {
+        for (std::size_t j = 0; j < STRATEGY_COUNT; ++j)
+        {
+            wins[i][j] = i == j ? 0.0 : static_cast<double>(tally.wins[i][j]) + 1.0;
+        }
+    }
+
+    std::vector<double> gamma(STRATEGY_COUNT, 1.0);
+    for (int iteration = 0; iteration < 10000; ++iteration)
+    {
+        double change = 0.0;
+        for (std::size_t i = 0; i < STRATEGY_COUNT; ++i)
+        {
+            double won = 0.0;
+            double denominator = 0.0;
+            for (std::size_t j = 0; j < STRATEGY_COUNT; ++j)
+            {
+                if (i != j)
+                {
+                    won += wins[i][j];
+                    denominator += (wins[i][j] + wins[j][i]) / (gamma[i] + gamma[j]);
+                }
+            }
+            double updated = denominator > 0.0 ? won / denominator : gamma[i];
+            change = std::max(change, std::abs(std::log(updated / gamma[i])));
+            gamma[i] = updated;
+        }
+
+        double logMean = 0.0;
+        for (double g : gamma)
+        {
+            logMean += std::log(g);
+        }
+        logMean /= STRATEGY_COUNT;
+        for (double &g : gamma)
+        {
+            g /= std::exp(logMean);
+        }
+
+        if (change < 1e-10)
+        {
+            break;
+        }
+    }
+
+    const double eloPerNat = 400.0 / std::log(10.0);
+    std::vector<Rating> ratings;
+    for (std::size_t i = 0; i < STRATEGY_COUNT; ++i)
+    {
+        double information = 0.0;
+        for (std::size_t j = 0; j < STRATEGY_COUNT; ++j)
+        {
+            if (i != j)
+            {
+                double p = gamma[i] / (gamma[i] + gamma[j]);
+                information += (wins[i][j] + wins[j][i]) * p * (1.0 - p);
+            }
+        }
+        double margin = information > 0.0 ? 1.96 * eloPerNat / std::sqrt(information) : 0.0;
+        ratings.push_back({1500.0 + eloPerNat * std::log(gamma[i]), margin});
+    }
+    return ratings;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    std::uint64_t gamesPerPairing = 1000;
+    unsigned threads = 0;
+    std::uint64_t seed = RandomService::freshSeed();
+    std::string bookPath;
+    RuleSet rules = RuleSet::Classic;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--games" && i + 1 < argc)
+        {
+            gamesPerPairing = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--book" && i + 1 < argc)
+        {
+            bookPath = argv[++i];
+        }
+        else if (arg == "--rules" && i + 1 < argc)
+        {
+            if (!parseRuleSet(argv[++i], rules))
+            {
+                std::cerr << "Unknown rules " << argv[i] << " (expected classic or salvo)" << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--games N] [--threads T] [--seed S] [--book opening.bin] [--rules classic|salvo]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (gamesPerPairing == 0)
+    {
+        std::cerr << "Games per pairing must be positive" << std::endl;
+        return 1;
+    }
+
+    OpeningBook book;
+    if (!bookPath.empty() && !book.load(bookPath))
+    {
+        std::cerr << "Unable to read opening book " << bookPath << std::endl;
+        return 1;
+    }
+    const OpeningBook *openingBook = book.size() ? &book : nullptr;
+
+    WorkStealingPool pool(threads);
+    std::vector<Tally> tallies(pool.size());
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t pairing = 0;
+    for (std::size_t a = 0; a < STRATEGY_COUNT; ++a)
+    {
+        for (std::size_t b = a + 1; b < STRATEGY_COUNT; ++b, ++pairing)
+        {
+            for (std::uint64_t first = 0; first < gamesPerPairing; first += GAMES_PER_TASK)
+            {
+                const std::uint64_t last = std::min(gamesPerPairing, first + GAMES_PER_TASK);
+                pool.submit([&tallies, openingBook, a, b, first, last, pairing, seed, rules]
+                            {
+                    Tally &tally = tallies[static_cast<std::size_t>(WorkStealingPool::currentWorker())];
+                    for (std::uint64_t game = first; game < last; ++game)
+                    {
+                        // Alternate who fires first; every game has its own seed
+                        const bool swapped = game % 2 == 1;
+                        const std::size_t sides[2] = {swapped ? b : a, swapped ? a : b};
+                        std::uint64_t state = seed ^ (pairing << 48) ^ game;
+                        SimulatedGame result = simulateGame(playerConfig(STRATEGIES[sides[0]].difficulty, openingBook),
+                                                            playerConfig(STRATEGIES[sides[1]].difficulty, openingBook),
+                                                            splitmix64(state), rules);
+                        if (result.winner < 0)
+                        {
+                            continue;
+                        }
+
+                        const std::size_t winner = sides[result.winner];
+                        const std::size_t loser = sides[1 - result.winner];
+                        ++tally.wins[winner][loser];
+                        tally.winningShots[winner] += static_cast<std::uint64_t>(result.shots[result.winner]);
+                        // The winner took the last turn, so half the turns rounded up
+                        tally.winningTurns[winner] += static_cast<std::uint64_t>((result.turns + 1) / 2);
+                        for (int side = 0; side < 2; ++side)
+                        {
+                            tally.thinkNanos[sides[side]] += result.thinkNanos[side];
+                            tally.moves[sides[side]] += static_cast<std::uint64_t>(result.shots[side]);
+                        }
+                    } });
+            }
+        }
+    }
+    pool.wait();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Tally total;
+    for (const auto &tally : tallies)
+    {
+        total.merge(tally);
+    }
+    std::vector<Rating> ratings = fitElo(total);
+
+    const std::uint64_t totalGames = gamesPerPairing * pairing;
+    std::cout << "Played " << totalGames << " games (" << gamesPerPairing << " per pairing) on " << pool.size()
+              << " threads in " << std::fixed << std::setprecision(2) << elapsed << " s, seed " << seed << ", "
+              << ruleSetName(rules) << " rules\n\n";
+
+    std::vector<std::size_t> order(STRATEGY_COUNT);
+    for (std::size_t i = 0; i < STRATEGY_COUNT; ++i)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&ratings](std::size_t x, std::size_t y)
+              { return ratings[x].elo > ratings[y].elo; });
+
+    std::cout << std::left << std::setw(10) << "Strategy" << std::right << std::setw(8) << "Elo" << std::setw(9)
+              << "95% CI" << std::setw(8) << "Wins" << std::setw(8) << "Losses" << std::setw(14) << "Shots/win"
+              << std::setw(14) << "Turns/win" << std::setw(14) << "CPU us/shot" << "\n";
+    for (std::size_t i : order)
+    {
+        std::uint64_t won = 0;
+        std::uint64_t lost = 0;
+        for (std::size_t j = 0; j < STRATEGY_COUNT; ++j)
+        {
+            won += total.wins[i][j];
+            lost += total.wins[j][i];
+        }
+        const double shotsPerWin = won ? static_cast<double>(total.winningShots[i]) / won : 0.0;
+        const double turnsPerWin = won ? static_cast<double>(total.winningTurns[i]) / won : 0.0;
+        const double microsPerMove = total.moves[i] ? total.thinkNanos[i] / 1000.0 / total.moves[i] : 0.0;
+
+        std::cout << std::left << std::setw(10) << STRATEGIES[i].name << std::right << std::setprecision(0)
+                  << std::setw(8) << ratings[i].elo << std::setw(5) << "+/-" << std::setw(4) << ratings[i].margin
+                  << std::setw(8) << won << std::setw(8) << lost << std::setprecision(1) << std::setw(14)
+                  << shotsPerWin << std::setw(14) << turnsPerWin << std::setprecision(3) << std::setw(14) << microsPerMove << "\n";
+    }
+
+    std::cout << "\nWin rate (row vs column)\n"
+              << std::setw(10) << "";
+    for (std::size_t j : order)
+    {
+        std::cout << std::setw(10) << STRATEGIES[j].name;
+    }
+    std::cout << "\n";
+    for (std::size_t i : order)
+    {
+        std::cout << std::left << std::setw(10) << STRATEGIES[i].name << std::right;
+        for (std::size_t j : order)
+        {
+            const std::uint64_t games = total.wins[i][j] + total.wins[j][i];
+            if (i == j || games == 0)
+            {
+                std::cout << std::setw(10) << "-";
+            }
+            else
+            {
+                std::cout << std::setw(9) << std::setprecision(1) << 100.0 * total.wins[i][j] / games << "%";
+            }
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
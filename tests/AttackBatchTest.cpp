@@ -0,0 +1,73 @@
+#include "GameLogic.h"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Board::attackBatch resolves a whole Salvo volley at once. Each shot must
+// read as it would have fired alone, except that a ship sunk by the volley
+// reports Sunk only on its last shot in it.
+
+namespace
+{
+using Result = Board::AttackResult;
+
+struct Expected
+{
+    Result result;
+    int ship;
+};
+
+bool expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+    return condition;
+}
+
+bool expectVolley(Board &board, const std::vector<Coordinate> &targets, const std::vector<Expected> &expected,
+                  std::uint32_t expectedSunk, const char *what)
+{
+    std::vector<Board::ShotResult> results;
+    const std::uint32_t sunk = board.attackBatch(targets, results);
+    bool matches = sunk == expectedSunk && results.size() == expected.size();
+    for (std::size_t i = 0; matches && i < results.size(); ++i)
+    {
+        matches = results[i].result == expected[i].result && results[i].ship == expected[i].ship;
+    }
+    return expect(matches, what);
+}
+}
+
+int main()
+{
+    Destroyer destroyer;
+    Cruiser cruiser;
+    Submarine submarine;
+    Board board;
+    bool ok = expect(board.placeShip(destroyer, {0, 0}, true) && board.placeShip(cruiser, {2, 0}, true) &&
+                         board.placeShip(submarine, {4, 0}, false),
+                     "placement");
+
+    ok = expectVolley(board, {{0, 0}, {0, 0}, {5, 5}, {-1, 3}, {2, 0}},
+                      {{Result::Hit, 0}, {Result::AlreadyTried, -1}, {Result::Miss, -1}, {Result::Invalid, -1},
+                       {Result::Hit, 1}},
+                      0, "a cell repeated within a volley is AlreadyTried") && ok;
+
+    ok = expectVolley(board, {{0, 1}, {2, 1}, {2, 2}, {0, 0}, {5, 5}},
+                      {{Result::Sunk, 0}, {Result::Hit, 1}, {Result::Sunk, 1}, {Result::AlreadyTried, -1},
+                       {Result::AlreadyTried, -1}},
+                      0b011, "cells attacked by an earlier volley are AlreadyTried, sinks set the mask") && ok;
+    ok = expect(board.countShipsAfloat() == 1 && !board.allShipsSunk(), "one ship left afloat") && ok;
+
+    // Shots out of board order still report Sunk on the last one, and a
+    // repeat after it does not move it
+    ok = expectVolley(board, {{6, 0}, {4, 0}, {5, 0}, {5, 0}},
+                      {{Result::Hit, 2}, {Result::Hit, 2}, {Result::Sunk, 2}, {Result::AlreadyTried, -1}}, 0b100,
+                      "Sunk on the last shot of the volley") && ok;
+    ok = expect(board.allShipsSunk(), "every ship sunk") && ok;
+
+    ok = expectVolley(board, {}, {}, 0, "an empty volley") && ok;
+    return ok ? 0 : 1;
+}
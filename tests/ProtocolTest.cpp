@@ -0,0 +1,169 @@
+#include "Protocol.h"
+#include "Random.h"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// View and Delta frames carry a match to a rejoining player or a new
+// spectator. Each must decode to exactly what was encoded, at every frame
+// size the server sends.
+
+namespace
+{
+constexpr int CELLS = Board::SIZE * Board::SIZE;
+
+bool sameStatus(const MatchStatus &a, const MatchStatus &b)
+{
+    return a.phase == b.phase && a.turn == b.turn && a.placed[0] == b.placed[0] && a.placed[1] == b.placed[1] &&
+           a.seat == b.seat;
+}
+
+bool sameShot(const ShotRecord &a, const ShotRecord &b)
+{
+    return a.seat == b.seat && a.cell == b.cell && a.result == b.result && a.sunkShip == b.sunkShip;
+}
+
+bool sameView(const MatchView &a, const MatchView &b)
+{
+    bool same = a.matchId == b.matchId && a.shots == b.shots && sameStatus(a.status, b.status) &&
+                a.layout == b.layout;
+    for (int side = 0; side < 2; ++side)
+    {
+        same = same && a.sides[side].attacked == b.sides[side].attacked && a.sides[side].hits == b.sides[side].hits &&
+               a.sides[side].sunk == b.sides[side].sunk;
+    }
+    return same;
+}
+
+MatchView sampleView(int seat)
+{
+    Xoshiro256 rng(static_cast<std::uint64_t>(seat + 2));
+    MatchView view;
+    view.matchId = 0xC0FFEE01u;
+    view.shots = 141;
+    view.status.phase = 2;
+    view.status.turn = 1;
+    view.status.placed[0] = true;
+    view.status.placed[1] = true;
+    view.status.seat = seat;
+    if (seat >= 0)
+    {
+        view.layout = randomFleetLayout(rng);
+    }
+    for (auto &side : view.sides)
+    {
+        // Random cells in both words of the mask, and always the last cell
+        for (int cell = 0; cell < CELLS; ++cell)
+        {
+            if (rng() % 3 == 0)
+            {
+                side.attacked.set(cell);
+                if (rng() % 2 == 0)
+                {
+                    side.hits.set(cell);
+                }
+            }
+        }
+        side.attacked.set(CELLS - 1);
+        side.sunk = 0x15;
+    }
+    return view;
+}
+
+// The single frame out holds, if it is one whole frame of the given type
+bool onlyFrame(const std::vector<std::uint8_t> &out, MessageType type, Frame &frame)
+{
+    return parseFrame(out.data(), out.size(), frame) == out.size() && frame.type == type;
+}
+
+bool expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+    return condition;
+}
+}
+
+int main()
+{
+    bool ok = true;
+
+    bool packed = true;
+    for (int seat = 0; seat < 2; ++seat)
+    {
+        for (int cell = 0; cell < CELLS; ++cell)
+        {
+            for (int result = 0; result <= static_cast<int>(Board::AttackResult::Sunk); ++result)
+            {
+                for (int sunkShip = -1; sunkShip < static_cast<int>(FLEET_SIZE); ++sunkShip)
+                {
+                    const ShotRecord shot{seat, cell, static_cast<Board::AttackResult>(result), sunkShip};
+                    packed = sameShot(unpackShot(packShot(shot)), shot) && packed;
+                }
+            }
+        }
+    }
+    ok = expect(packed, "every shot survives packShot and unpackShot") && ok;
+    ok = expect(packShot(ShotRecord{1, 99, Board::AttackResult::Hit, -1})[1] >> 4 == 0xF,
+                "no sunk ship packs as 0xF") && ok;
+
+    for (int seat = -1; seat < 2; ++seat)
+    {
+        const MatchView view = sampleView(seat);
+        std::vector<std::uint8_t> out;
+        appendView(out, view);
+        Frame frame{};
+        MatchView decoded;
+        ok = expect(out.size() == viewFrameSize(seat >= 0), "the View frame has its documented size") && ok;
+        ok = expect(onlyFrame(out, MessageType::View, frame) && readView(frame, decoded) && sameView(decoded, view),
+                    seat < 0 ? "spectator View round trip" : "player View round trip") && ok;
+
+        frame.size -= 1;
+        ok = expect(!readView(frame, decoded), "a short View is rejected") && ok;
+    }
+
+    // The most shots one Delta frame can carry, the limit rejoin relies on
+    const std::size_t maxShots = (MAX_PAYLOAD_SIZE - 3) / 2;
+    std::vector<PackedShot> shots;
+    std::vector<ShotRecord> expected;
+    for (std::size_t i = 0; i < maxShots; ++i)
+    {
+        const ShotRecord shot{static_cast<int>(i % 2), static_cast<int>(i % CELLS),
+                              i % 7 == 0 ? Board::AttackResult::Sunk : Board::AttackResult::Miss,
+                              i % 7 == 0 ? static_cast<int>(i % FLEET_SIZE) : -1};
+        shots.push_back(packShot(shot));
+        expected.push_back(shot);
+    }
+    MatchStatus status;
+    status.phase = 1;
+    status.turn = 0;
+    status.placed[0] = true;
+    status.seat = 1;
+
+    std::vector<std::uint8_t> out;
+    appendDelta(out, 300, status, shots.data(), shots.size());
+    Frame frame{};
+    std::uint16_t since = 0;
+    MatchStatus decodedStatus;
+    std::vector<ShotRecord> decoded;
+    ok = expect(out.size() <= FRAME_HEADER_SIZE + MAX_PAYLOAD_SIZE && onlyFrame(out, MessageType::Delta, frame) &&
+                    readDelta(frame, since, decodedStatus, decoded),
+                "a full Delta fits one frame") && ok;
+    bool sameShots = decoded.size() == expected.size();
+    for (std::size_t i = 0; sameShots && i < decoded.size(); ++i)
+    {
+        sameShots = sameShot(decoded[i], expected[i]);
+    }
+    ok = expect(since == 300 && sameStatus(decodedStatus, status) && sameShots, "full Delta round trip") && ok;
+
+    frame.size -= 1;
+    ok = expect(!readDelta(frame, since, decodedStatus, decoded), "a Delta with half a shot is rejected") && ok;
+
+    // ServerShard::rejoin sends a Delta only while it is no larger than a
+    // player's View, so every Delta it sends must fit the limit above
+    ok = expect((viewFrameSize(true) - FRAME_HEADER_SIZE - 3) / 2 <= maxShots, "rejoin Deltas fit one frame") && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+#include "SaveGame.h"
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// Save games must come back exactly as written, and a file that was
+// corrupted or cut short must be refused rather than resumed.
+
+namespace
+{
+namespace fs = std::filesystem;
+
+bool sameSnapshot(const BattleSnapshot &a, const BattleSnapshot &b)
+{
+    return a.seed == b.seed && a.difficulty == b.difficulty && a.computerToMove == b.computerToMove &&
+           a.playerLayout == b.playerLayout && a.computerLayout == b.computerLayout && a.shots == b.shots &&
+           a.hitQueue == b.hitQueue && a.lastHit == b.lastHit && a.huntingMode == b.huntingMode &&
+           a.computerShots == b.computerShots && a.aiRng == b.aiRng && a.shotsFired == b.shotsFired &&
+           a.hits == b.hits;
+}
+
+BattleSnapshot sampleSnapshot()
+{
+    Xoshiro256 rng(7);
+    BattleSnapshot snapshot;
+    snapshot.seed = 0x0123456789ABCDEFull;
+    snapshot.difficulty = 2;
+    snapshot.computerToMove = true;
+    snapshot.playerLayout = randomFleetLayout(rng);
+    snapshot.computerLayout = randomFleetLayout(rng);
+    // More than 255 shots, so the count needs both of its bytes
+    for (int i = 0; i < 300; ++i)
+    {
+        snapshot.shots.push_back(static_cast<std::uint8_t>(i % 200));
+    }
+    snapshot.hitQueue = {{3, 4}, {3, 6}};
+    snapshot.lastHit = {3, 5};
+    snapshot.huntingMode = true;
+    for (int cell = 0; cell < 60; ++cell)
+    {
+        snapshot.computerShots.push_back({cell / Board::SIZE, cell % Board::SIZE});
+    }
+    snapshot.aiRng = rng.state();
+    snapshot.shotsFired = 41;
+    snapshot.hits = 12;
+    return snapshot;
+}
+
+std::uint32_t fnv1a(const std::uint8_t *data, std::size_t size)
+{
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// The same snapshot as a version 1 file, which had no AI generator state
+std::vector<std::uint8_t> versionOne(std::vector<std::uint8_t> data)
+{
+    const std::size_t rngOffset = data.size() - 4 - 8 - 32;
+    data.erase(data.begin() + static_cast<std::ptrdiff_t>(rngOffset),
+               data.begin() + static_cast<std::ptrdiff_t>(rngOffset + 32));
+    data[3] = 1;
+    data.resize(data.size() - 4);
+    const std::uint32_t checksum = fnv1a(data.data(), data.size());
+    for (int i = 0; i < 4; ++i)
+    {
+        data.push_back(static_cast<std::uint8_t>(checksum >> (8 * i)));
+    }
+    return data;
+}
+
+bool expect(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+    return condition;
+}
+}
+
+int main()
+{
+    const BattleSnapshot original = sampleSnapshot();
+    const std::vector<std::uint8_t> data = serializeSnapshot(original);
+    bool ok = true;
+
+    BattleSnapshot loaded;
+    ok = expect(deserializeSnapshot(data, loaded) && sameSnapshot(loaded, original), "round trip in memory") && ok;
+
+    const fs::path path = fs::temp_directory_path() / "fleet-savegame-test.bin";
+    loaded = BattleSnapshot();
+    ok = expect(writeFileAtomically(path.string(), data) && !fs::exists(path.string() + ".tmp"),
+                "atomic write leaves no temp file") && ok;
+    ok = expect(loadSnapshot(path.string(), loaded) && sameSnapshot(loaded, original), "round trip on disk") && ok;
+    fs::remove(path);
+    ok = expect(!loadSnapshot(path.string(), loaded), "a missing file") && ok;
+
+    // A rejected file leaves the caller's snapshot as it was
+    bool rejected = true;
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        std::vector<std::uint8_t> corrupt = data;
+        corrupt[i] ^= 0x10;
+        rejected = !deserializeSnapshot(corrupt, loaded) && rejected;
+    }
+    ok = expect(rejected && sameSnapshot(loaded, original), "every single-byte corruption is rejected") && ok;
+
+    rejected = true;
+    for (std::size_t size = 0; size < data.size(); ++size)
+    {
+        const std::vector<std::uint8_t> truncated(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(size));
+        rejected = !deserializeSnapshot(truncated, loaded) && rejected;
+    }
+    ok = expect(rejected && sameSnapshot(loaded, original), "every truncation is rejected") && ok;
+
+    BattleSnapshot expected = original;
+    expected.aiRng = {};
+    ok = expect(deserializeSnapshot(versionOne(data), loaded) && sameSnapshot(loaded, expected),
+                "a version 1 save loads without the generator state") && ok;
+
+    return ok ? 0 : 1;
+}